@@ -0,0 +1,49 @@
+# Writes every SPIR-V file into a header as constexpr uint32_t arrays, run in script mode:
+# cmake -D OUTPUT=<header> -D SPIRV_FILES=<file|file|...> -P EmbedShaders.cmake
+#
+# Lists are passed with | instead of ; because custom commands split arguments on ;
+
+string(REPLACE "|" ";" SPIRV_FILES "${SPIRV_FILES}")
+
+set(ARRAYS "")
+set(ENTRIES "")
+set(SHADER_INDEX 0)
+
+foreach(SPIRV ${SPIRV_FILES})
+    get_filename_component(FILE_NAME ${SPIRV} NAME)
+    file(READ ${SPIRV} HEX HEX)
+
+    # SPIR-V is little endian words, the byte order is swapped to write them as hex literals
+    string(REGEX REPLACE "(..)(..)(..)(..)" "0x\\4\\3\\2\\1," WORDS "${HEX}")
+
+    string(APPEND ARRAYS "    alignas(16) inline constexpr uint32_t SHADER_${SHADER_INDEX}[] = { ${WORDS} };\n")
+    string(APPEND ENTRIES "        Entry{ \"${FILE_NAME}\", SHADER_${SHADER_INDEX} },\n")
+    math(EXPR SHADER_INDEX "${SHADER_INDEX} + 1")
+endforeach()
+
+file(WRITE ${OUTPUT}.tmp
+"// Generated by cmake/EmbedShaders.cmake from the Shaders target, don't edit
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace embeddedShaders
+{
+    struct Entry
+    {
+        std::string_view name;
+        std::span<const uint32_t> code;
+    };
+
+${ARRAYS}
+    inline constexpr std::array<Entry, ${SHADER_INDEX}> ENTRIES{
+${ENTRIES}    };
+}
+")
+
+# Only touch the header when a shader changed, so C++ files aren't rebuilt for nothing
+execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different ${OUTPUT}.tmp ${OUTPUT})
+file(REMOVE ${OUTPUT}.tmp)
@@ -0,0 +1,452 @@
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/mat3x3.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/matrix.hpp>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+#include "jul/CpuProfiler.h"
+#include "jul/ThreadPool.h"
+
+namespace
+{
+    constexpr uint32_t TEXELS_PER_BLOCK{ 16 };
+
+    // Interpolation weights of the 4 bit BC7 indices, out of 64
+    constexpr std::array<int32_t, 16> BC7_WEIGHTS{ 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    // Ends of the line through the texels along their largest spread, the first one is the end the axis points to
+    template<typename Vector, typename Matrix>
+    std::pair<Vector, Vector> FindEndpoints(const std::array<Vector, TEXELS_PER_BLOCK>& texels)
+    {
+        Vector mean{ 0.0f };
+        for(const Vector& texel : texels)
+            mean += texel;
+        mean /= static_cast<float>(TEXELS_PER_BLOCK);
+
+        Matrix covariance{ 0.0f };
+        for(const Vector& texel : texels)
+            covariance += glm::outerProduct(texel - mean, texel - mean);
+
+        // Every texel is the same
+        float trace{};
+        for(glm::length_t component = 0; component < Vector::length(); ++component)
+            trace += covariance[component][component];
+
+        if(trace < 1e-6f)
+            return { mean, mean };
+
+        // Power iteration from the covariance column with the largest norm, a fixed start like the grey axis can be
+        // orthogonal to the spread, blocks that only vary in hue would then come out flat
+        Vector axis = covariance[0];
+        for(glm::length_t column = 1; column < Vector::length(); ++column)
+        {
+            if(glm::dot(covariance[column], covariance[column]) > glm::dot(axis, axis))
+                axis = covariance[column];
+        }
+
+        axis = glm::normalize(axis);
+
+        // A few steps are plenty for 16 texels
+        for(int iteration = 0; iteration < 8; ++iteration)
+        {
+            const Vector next = covariance * axis;
+            const float length = glm::length(next);
+            if(length < 1e-6f)
+                break;
+
+            axis = next / length;
+        }
+
+        float minProjection{ std::numeric_limits<float>::max() };
+        float maxProjection{ std::numeric_limits<float>::lowest() };
+        for(const Vector& texel : texels)
+        {
+            const float projection = glm::dot(texel - mean, axis);
+            minProjection = std::min(minProjection, projection);
+            maxProjection = std::max(maxProjection, projection);
+        }
+
+        return { glm::clamp(mean + axis * maxProjection, Vector{ 0.0f }, Vector{ 255.0f }),
+                 glm::clamp(mean + axis * minProjection, Vector{ 0.0f }, Vector{ 255.0f }) };
+    }
+
+    template<typename Vector, size_t PaletteSize>
+    uint32_t FindNearest(const std::array<Vector, PaletteSize>& palette, const Vector& texel, float& error)
+    {
+        uint32_t nearestIndex{};
+        error = std::numeric_limits<float>::max();
+
+        for(uint32_t paletteIndex = 0; paletteIndex < PaletteSize; ++paletteIndex)
+        {
+            const Vector offset = palette[paletteIndex] - texel;
+            const float distance = glm::dot(offset, offset);
+            if(distance < error)
+            {
+                error = distance;
+                nearestIndex = paletteIndex;
+            }
+        }
+
+        return nearestIndex;
+    }
+
+    uint16_t PackRgb565(const glm::vec3& color)
+    {
+        const auto red = static_cast<uint16_t>(std::lround(color.r * 31.0f / 255.0f));
+        const auto green = static_cast<uint16_t>(std::lround(color.g * 63.0f / 255.0f));
+        const auto blue = static_cast<uint16_t>(std::lround(color.b * 31.0f / 255.0f));
+        return static_cast<uint16_t>(red << 11 | green << 5 | blue);
+    }
+
+    // The same bit replication the GPU uses to expand the endpoints
+    glm::vec3 UnpackRgb565(uint16_t color)
+    {
+        const uint32_t red = color >> 11 & 31;
+        const uint32_t green = color >> 5 & 63;
+        const uint32_t blue = color & 31;
+        return { red << 3 | red >> 2, green << 2 | green >> 4, blue << 3 | blue >> 2 };
+    }
+
+    // BC7 fields are packed from the least significant bit of the first byte onwards
+    class BitWriter final
+    {
+    public:
+        explicit BitWriter(uint8_t* bytes) :
+            m_BytesPtr(bytes)
+        {
+        }
+
+        void Write(uint32_t value, uint32_t bitCount)
+        {
+            for(uint32_t bit = 0; bit < bitCount; ++bit, ++m_Position)
+            {
+                if(value >> bit & 1)
+                    m_BytesPtr[m_Position / 8] |= static_cast<uint8_t>(1 << m_Position % 8);
+            }
+        }
+
+    private:
+        uint8_t* m_BytesPtr;
+        uint32_t m_Position{};
+    };
+
+    // Mode 6, one subset with 7 bit RGBA endpoints, a p bit per endpoint and 4 bit indices
+    struct Bc7Fit
+    {
+        std::array<glm::ivec4, 2> endpoints;
+        std::array<uint32_t, 2> pBits;
+        std::array<uint32_t, TEXELS_PER_BLOCK> indices;
+        float error;
+    };
+
+    // The p bit is the shared lowest bit of every channel, both options are tried
+    void QuantizeBc7Endpoint(const glm::vec4& endpoint, glm::ivec4& quantized, uint32_t& pBit)
+    {
+        float bestError{ std::numeric_limits<float>::max() };
+
+        for(uint32_t candidatePBit = 0; candidatePBit < 2; ++candidatePBit)
+        {
+            glm::ivec4 candidate{};
+            float error{};
+
+            for(glm::length_t channel = 0; channel < 4; ++channel)
+            {
+                const float value = (endpoint[channel] - static_cast<float>(candidatePBit)) * 0.5f;
+                candidate[channel] = std::clamp(static_cast<int32_t>(std::lround(value)), 0, 127);
+
+                const float offset =
+                    static_cast<float>(candidate[channel] * 2 + static_cast<int32_t>(candidatePBit)) - endpoint[channel];
+                error += offset * offset;
+            }
+
+            if(error < bestError)
+            {
+                bestError = error;
+                quantized = candidate;
+                pBit = candidatePBit;
+            }
+        }
+    }
+
+    Bc7Fit FitBc7(const std::array<glm::vec4, TEXELS_PER_BLOCK>& texels, const glm::vec4& endpoint0,
+                  const glm::vec4& endpoint1)
+    {
+        Bc7Fit fit{};
+        QuantizeBc7Endpoint(endpoint0, fit.endpoints[0], fit.pBits[0]);
+        QuantizeBc7Endpoint(endpoint1, fit.endpoints[1], fit.pBits[1]);
+
+        const glm::ivec4 expanded0 = fit.endpoints[0] * 2 + static_cast<int32_t>(fit.pBits[0]);
+        const glm::ivec4 expanded1 = fit.endpoints[1] * 2 + static_cast<int32_t>(fit.pBits[1]);
+
+        std::array<glm::vec4, 16> palette{};
+        for(size_t weightIndex = 0; weightIndex < palette.size(); ++weightIndex)
+        {
+            const int32_t weight = BC7_WEIGHTS[weightIndex];
+            palette[weightIndex] = glm::vec4{ ((64 - weight) * expanded0 + weight * expanded1 + 32) >> 6 };
+        }
+
+        for(uint32_t texelIndex = 0; texelIndex < TEXELS_PER_BLOCK; ++texelIndex)
+        {
+            float error{};
+            fit.indices[texelIndex] = FindNearest(palette, texels[texelIndex], error);
+            fit.error += error;
+        }
+
+        return fit;
+    }
+
+    // Least squares endpoints for the weights the texels picked, false when every texel picked the same weight
+    bool RefitBc7Endpoints(const std::array<glm::vec4, TEXELS_PER_BLOCK>& texels, const Bc7Fit& fit,
+                           glm::vec4& endpoint0, glm::vec4& endpoint1)
+    {
+        float weight00{};
+        float weight01{};
+        float weight11{};
+        glm::vec4 sum0{ 0.0f };
+        glm::vec4 sum1{ 0.0f };
+
+        for(uint32_t texelIndex = 0; texelIndex < TEXELS_PER_BLOCK; ++texelIndex)
+        {
+            const float weight = static_cast<float>(BC7_WEIGHTS[fit.indices[texelIndex]]) / 64.0f;
+            weight00 += (1.0f - weight) * (1.0f - weight);
+            weight01 += (1.0f - weight) * weight;
+            weight11 += weight * weight;
+            sum0 += (1.0f - weight) * texels[texelIndex];
+            sum1 += weight * texels[texelIndex];
+        }
+
+        const float determinant = weight00 * weight11 - weight01 * weight01;
+        if(std::abs(determinant) < 1e-6f)
+            return false;
+
+        endpoint0 = glm::clamp((weight11 * sum0 - weight01 * sum1) / determinant, glm::vec4{ 0.0f }, glm::vec4{ 255.0f });
+        endpoint1 = glm::clamp((weight00 * sum1 - weight01 * sum0) / determinant, glm::vec4{ 0.0f }, glm::vec4{ 255.0f });
+        return true;
+    }
+}  // namespace
+
+uint32_t blockCompression::GetBlockSize(Format format)
+{
+    return format == Format::BC1 or format == Format::BC4 ? 8 : 16;
+}
+
+void blockCompression::EncodeBC1(const uint8_t* texels, uint8_t* block)
+{
+    std::array<glm::vec3, TEXELS_PER_BLOCK> colors{};
+    for(uint32_t texelIndex = 0; texelIndex < TEXELS_PER_BLOCK; ++texelIndex)
+        colors[texelIndex] = { texels[texelIndex * 4], texels[texelIndex * 4 + 1], texels[texelIndex * 4 + 2] };
+
+    const auto [maxColor, minColor] = FindEndpoints<glm::vec3, glm::mat3>(colors);
+
+    uint16_t color0 = PackRgb565(maxColor);
+    uint16_t color1 = PackRgb565(minColor);
+
+    // The first color has to be the larger one to select the four color mode, which has no transparent entry
+    if(color0 < color1)
+        std::swap(color0, color1);
+
+    // Equal colors select the three color mode, index 0 still means color0 there
+    uint32_t indices{};
+    if(color0 != color1)
+    {
+        const glm::vec3 endpoint0 = UnpackRgb565(color0);
+        const glm::vec3 endpoint1 = UnpackRgb565(color1);
+        const std::array<glm::vec3, 4> palette{
+            endpoint0,
+            endpoint1,
+            (2.0f * endpoint0 + endpoint1) / 3.0f,
+            (endpoint0 + 2.0f * endpoint1) / 3.0f,
+        };
+
+        for(uint32_t texelIndex = 0; texelIndex < TEXELS_PER_BLOCK; ++texelIndex)
+        {
+            float error{};
+            indices |= FindNearest(palette, colors[texelIndex], error) << texelIndex * 2;
+        }
+    }
+
+    block[0] = static_cast<uint8_t>(color0);
+    block[1] = static_cast<uint8_t>(color0 >> 8);
+    block[2] = static_cast<uint8_t>(color1);
+    block[3] = static_cast<uint8_t>(color1 >> 8);
+    for(uint32_t byteIndex = 0; byteIndex < 4; ++byteIndex)
+        block[4 + byteIndex] = static_cast<uint8_t>(indices >> byteIndex * 8);
+}
+
+void blockCompression::EncodeBC4(const uint8_t* texels, uint8_t* block, uint32_t channel)
+{
+    uint8_t minValue{ 255 };
+    uint8_t maxValue{ 0 };
+    for(uint32_t texelIndex = 0; texelIndex < TEXELS_PER_BLOCK; ++texelIndex)
+    {
+        minValue = std::min(minValue, texels[texelIndex * 4 + channel]);
+        maxValue = std::max(maxValue, texels[texelIndex * 4 + channel]);
+    }
+
+    // The larger value first selects the mode with six interpolated values
+    block[0] = maxValue;
+    block[1] = minValue;
+
+    uint64_t indices{};
+    if(minValue != maxValue)
+    {
+        std::array<float, 8> palette{ static_cast<float>(maxValue), static_cast<float>(minValue) };
+        for(uint32_t paletteIndex = 2; paletteIndex < palette.size(); ++paletteIndex)
+            palette[paletteIndex] =
+                static_cast<float>((8 - paletteIndex) * maxValue + (paletteIndex - 1) * minValue) / 7.0f;
+
+        for(uint32_t texelIndex = 0; texelIndex < TEXELS_PER_BLOCK; ++texelIndex)
+        {
+            const auto value = static_cast<float>(texels[texelIndex * 4 + channel]);
+            const auto nearest = std::ranges::min_element(
+                palette, [value](float first, float second) { return std::abs(first - value) < std::abs(second - value); });
+
+            indices |= static_cast<uint64_t>(nearest - palette.begin()) << texelIndex * 3;
+        }
+    }
+
+    for(uint32_t byteIndex = 0; byteIndex < 6; ++byteIndex)
+        block[2 + byteIndex] = static_cast<uint8_t>(indices >> byteIndex * 8);
+}
+
+void blockCompression::EncodeBC5(const uint8_t* texels, uint8_t* block)
+{
+    EncodeBC4(texels, block, 0);
+    EncodeBC4(texels, block + 8, 1);
+}
+
+void blockCompression::EncodeBC7(const uint8_t* texels, uint8_t* block)
+{
+    std::array<glm::vec4, TEXELS_PER_BLOCK> colors{};
+    for(uint32_t texelIndex = 0; texelIndex < TEXELS_PER_BLOCK; ++texelIndex)
+    {
+        const uint8_t* texel = texels + texelIndex * 4;
+        colors[texelIndex] = { texel[0], texel[1], texel[2], texel[3] };
+    }
+
+    auto [endpoint0, endpoint1] = FindEndpoints<glm::vec4, glm::mat4>(colors);
+    Bc7Fit bestFit = FitBc7(colors, endpoint0, endpoint1);
+
+    // The principal axis ignores quantization, refitting to the chosen weights usually lowers the error further
+    for(int iteration = 0; iteration < 2 and RefitBc7Endpoints(colors, bestFit, endpoint0, endpoint1); ++iteration)
+    {
+        const Bc7Fit refit = FitBc7(colors, endpoint0, endpoint1);
+        if(refit.error >= bestFit.error)
+            break;
+
+        bestFit = refit;
+    }
+
+    // The highest bit of the first index is implied to be 0, so the endpoints are swapped when it is set
+    if(bestFit.indices[0] & 8)
+    {
+        std::swap(bestFit.endpoints[0], bestFit.endpoints[1]);
+        std::swap(bestFit.pBits[0], bestFit.pBits[1]);
+        for(uint32_t& index : bestFit.indices)
+            index = 15 - index;
+    }
+
+    std::memset(block, 0, 16);
+    BitWriter writer{ block };
+
+    // Mode 6 is a 1 at bit 6
+    writer.Write(1 << 6, 7);
+
+    for(glm::length_t channel = 0; channel < 4; ++channel)
+    {
+        writer.Write(static_cast<uint32_t>(bestFit.endpoints[0][channel]), 7);
+        writer.Write(static_cast<uint32_t>(bestFit.endpoints[1][channel]), 7);
+    }
+
+    writer.Write(bestFit.pBits[0], 1);
+    writer.Write(bestFit.pBits[1], 1);
+
+    writer.Write(bestFit.indices[0], 3);
+    for(uint32_t texelIndex = 1; texelIndex < TEXELS_PER_BLOCK; ++texelIndex)
+        writer.Write(bestFit.indices[texelIndex], 4);
+}
+
+std::vector<uint8_t> blockCompression::EncodeImage(Format format, const uint8_t* pixels, uint32_t width,
+                                                   uint32_t height, ThreadPool* threadPool)
+{
+    JUL_PROFILE_ZONE("blockCompression::EncodeImage");
+
+    const uint32_t blockCountX = (width + 3) / 4;
+    const uint32_t blockCountY = (height + 3) / 4;
+    const uint32_t blockSize = GetBlockSize(format);
+
+    std::vector<uint8_t> blocks(static_cast<size_t>(blockCountX) * blockCountY * blockSize);
+
+    auto encodeRow = [&](uint32_t blockY)
+    {
+        std::array<uint8_t, TEXELS_PER_BLOCK * 4> texels{};
+
+        for(uint32_t blockX = 0; blockX < blockCountX; ++blockX)
+        {
+            for(uint32_t y = 0; y < 4; ++y)
+            {
+                const uint32_t sourceY = std::min(blockY * 4 + y, height - 1);
+                for(uint32_t x = 0; x < 4; ++x)
+                {
+                    const uint32_t sourceX = std::min(blockX * 4 + x, width - 1);
+                    std::memcpy(texels.data() + (y * 4 + x) * 4,
+                                pixels + (static_cast<size_t>(sourceY) * width + sourceX) * 4,
+                                4);
+                }
+            }
+
+            uint8_t* block = blocks.data() + (static_cast<size_t>(blockY) * blockCountX + blockX) * blockSize;
+            switch(format)
+            {
+                case Format::BC1: EncodeBC1(texels.data(), block); break;
+                case Format::BC4: EncodeBC4(texels.data(), block); break;
+                case Format::BC5: EncodeBC5(texels.data(), block); break;
+                case Format::BC7: EncodeBC7(texels.data(), block); break;
+                default: throw std::invalid_argument("Unknown block format!");
+            }
+        }
+    };
+
+    if(threadPool != nullptr)
+    {
+        // Exceptions can't leave a pool thread, the first one is rethrown on the calling thread
+        std::exception_ptr error{};
+        std::mutex errorMutex{};
+
+        threadPool->ParallelFor(blockCountY,
+                                [&](uint32_t blockY)
+                                {
+                                    try
+                                    {
+                                        encodeRow(blockY);
+                                    }
+                                    catch(...)
+                                    {
+                                        const std::lock_guard lock{ errorMutex };
+                                        if(error == nullptr)
+                                            error = std::current_exception();
+                                    }
+                                });
+
+        if(error != nullptr)
+            std::rethrow_exception(error);
+    }
+    else
+    {
+        for(uint32_t blockY = 0; blockY < blockCountY; ++blockY)
+            encodeRow(blockY);
+    }
+
+    return blocks;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// CPU encoders for the BC block formats, used offline by the TextureCompressor tool
+//
+// Blocks are 4x4 texels, every encoder takes the 16 RGBA8 texels of one block in row order
+// BC1 color without alpha, BC4 the red channel, BC5 red and green, BC7 (mode 6 only) color with alpha
+namespace blockCompression
+{
+    enum class Format
+    {
+        BC1,
+        BC4,
+        BC5,
+        BC7
+    };
+
+    [[nodiscard]] uint32_t GetBlockSize(Format format);
+
+    void EncodeBC1(const uint8_t* texels, uint8_t* block);
+    void EncodeBC4(const uint8_t* texels, uint8_t* block, uint32_t channel = 0);
+    void EncodeBC5(const uint8_t* texels, uint8_t* block);
+    void EncodeBC7(const uint8_t* texels, uint8_t* block);
+
+    // Edge blocks repeat the last row and column, rows of blocks are spread over the pool when there is one
+    // Errors from any row are thrown on the calling thread
+    [[nodiscard]] std::vector<uint8_t> EncodeImage(Format format, const uint8_t* pixels, uint32_t width,
+                                                   uint32_t height, ThreadPool* threadPool = nullptr);
+}  // namespace blockCompression
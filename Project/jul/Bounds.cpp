@@ -0,0 +1,49 @@
+#include "Bounds.h"
+
+#include <limits>
+
+Bounds Bounds::Infinite()
+{
+    constexpr float infinity{ std::numeric_limits<float>::infinity() };
+    return { .center = {}, .extents = glm::vec3{ infinity }, .radius = infinity };
+}
+
+bool Bounds::IsInfinite() const { return radius == std::numeric_limits<float>::infinity(); }
+
+Bounds Bounds::Transformed(const glm::mat4& matrix) const
+{
+    if(IsInfinite())
+        return *this;
+
+    const glm::mat3 rotationScale{ matrix };
+
+    // Every axis of the box contributes its projected length to the new extents
+    const glm::mat3 absoluteMatrix{ glm::abs(rotationScale[0]), glm::abs(rotationScale[1]), glm::abs(rotationScale[2]) };
+
+    const float maxScale = glm::sqrt(glm::max(glm::max(glm::dot(rotationScale[0], rotationScale[0]),
+                                                       glm::dot(rotationScale[1], rotationScale[1])),
+                                              glm::dot(rotationScale[2], rotationScale[2])));
+
+    return {
+        .center = glm::vec3{ matrix * glm::vec4{ center, 1.0f } },
+        .extents = absoluteMatrix * extents,
+        .radius = radius * maxScale,
+    };
+}
+
+Bounds Bounds::Merge(const Bounds& first, const Bounds& second)
+{
+    if(first.IsInfinite() or second.IsInfinite())
+        return Infinite();
+
+    const glm::vec3 min = glm::min(first.GetMin(), second.GetMin());
+    const glm::vec3 max = glm::max(first.GetMax(), second.GetMax());
+
+    Bounds merged{ .center = (min + max) * 0.5f, .extents = (max - min) * 0.5f };
+
+    // Sphere around both spheres, centered on the merged box so the culler can use one center
+    merged.radius = glm::max(glm::distance(merged.center, first.center) + first.radius,
+                             glm::distance(merged.center, second.center) + second.radius);
+
+    return merged;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+// Axis aligned box and bounding sphere around the same geometry, both share the box center
+struct Bounds
+{
+    glm::vec3 center{};
+    glm::vec3 extents{};
+    float radius{};
+
+    // Sphere is fitted to the points instead of using the box diagonal
+    template<typename Vertex>
+    [[nodiscard]] static Bounds FromVertices(const std::vector<Vertex>& vertices);
+
+    // Bounds that are never culled
+    [[nodiscard]] static Bounds Infinite();
+
+    [[nodiscard]] bool IsInfinite() const;
+
+    // Box around the transformed box, sphere scaled by the largest axis scale
+    [[nodiscard]] Bounds Transformed(const glm::mat4& matrix) const;
+
+    [[nodiscard]] static Bounds Merge(const Bounds& first, const Bounds& second);
+
+    [[nodiscard]] glm::vec3 GetMin() const { return center - extents; }
+    [[nodiscard]] glm::vec3 GetMax() const { return center + extents; }
+};
+
+template<typename Vertex>
+Bounds Bounds::FromVertices(const std::vector<Vertex>& vertices)
+{
+    if(vertices.empty())
+        return {};
+
+    glm::vec3 min{ vertices.front().position };
+    glm::vec3 max{ vertices.front().position };
+
+    for(const Vertex& vertex : vertices)
+    {
+        min = glm::min(min, vertex.position);
+        max = glm::max(max, vertex.position);
+    }
+
+    Bounds bounds{ .center = (min + max) * 0.5f, .extents = (max - min) * 0.5f };
+
+    float radiusSquared{};
+    for(const Vertex& vertex : vertices)
+    {
+        const glm::vec3 offset = vertex.position - bounds.center;
+        radiusSquared = glm::max(radiusSquared, glm::dot(offset, offset));
+    }
+
+    bounds.radius = glm::sqrt(radiusSquared);
+    return bounds;
+}
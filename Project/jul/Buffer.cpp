@@ -50,18 +50,18 @@ Buffer::~Buffer()
     vkFreeMemory(VulkanGlobals::GetDevice(), m_BufferMemory, nullptr);
 }
 
-void Buffer::Upload(void* uploadDataPtr, uint32_t size)
+void Buffer::Upload(const void* uploadDataPtr, uint32_t size, uint32_t offset)
 {
     if(m_BufferDataPtr == nullptr)
     {
         void* tempBufferDataPtr = nullptr;
-        vkMapMemory(VulkanGlobals::GetDevice(), m_BufferMemory, 0, size, 0, &tempBufferDataPtr);
+        vkMapMemory(VulkanGlobals::GetDevice(), m_BufferMemory, offset, size, 0, &tempBufferDataPtr);
         memcpy(tempBufferDataPtr, uploadDataPtr, (size_t)size);
         vkUnmapMemory(VulkanGlobals::GetDevice(), m_BufferMemory);
     }
     else
     {
-        memcpy(m_BufferDataPtr, uploadDataPtr, (size_t)size);
+        memcpy(static_cast<char*>(m_BufferDataPtr) + offset, uploadDataPtr, (size_t)size);
     }
 }
 
@@ -14,10 +14,13 @@ public:
     Buffer& operator=(Buffer&&) = delete;
     Buffer& operator=(const Buffer&) = delete;
 
-    void Upload(void* uploadDataPtr, uint32_t size);
+    void Upload(const void* uploadDataPtr, uint32_t size, uint32_t offset = 0);
     void Map(uint32_t size);
     void Unmap();
 
+    // Null while the buffer isn't mapped
+    [[nodiscard]] void* GetMappedData() const { return m_BufferDataPtr; }
+
     operator VkBuffer() { return m_Buffer; }
     operator VkDeviceMemory() { return m_BufferMemory; }
 
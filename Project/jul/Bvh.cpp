@@ -0,0 +1,367 @@
+#include "Bvh.h"
+
+#include <algorithm>
+#include <array>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include "jul/CpuProfiler.h"
+#include "jul/FrustumCuller.h"
+
+namespace
+{
+    float SurfaceArea(const glm::vec3& min, const glm::vec3& max)
+    {
+        const glm::vec3 size = max - min;
+        return size.x * size.y + size.y * size.z + size.z * size.x;
+    }
+}  // namespace
+
+void Bvh::Build(const std::vector<Bounds>& objectBounds)
+{
+    JUL_PROFILE_ZONE("Bvh::Build");
+
+    m_Bounds = objectBounds;
+    m_Nodes.clear();
+    m_ObjectIds.clear();
+    m_InfiniteObjectIds.clear();
+    m_NeedsRefit = false;
+    m_NeedsRebuild = false;
+
+    for(uint32_t objectId = 0; objectId < m_Bounds.size(); ++objectId)
+    {
+        if(m_Bounds[objectId].IsInfinite())
+            m_InfiniteObjectIds.push_back(objectId);
+        else
+            m_ObjectIds.push_back(objectId);
+    }
+
+    if(m_ObjectIds.empty())
+        return;
+
+    // A binary tree with at least one object per leaf never has more than 2n - 1 nodes
+    m_Nodes.reserve(m_ObjectIds.size() * 2 - 1);
+    m_Nodes.push_back({ .firstOrLeft = 0, .objectCount = static_cast<uint32_t>(m_ObjectIds.size()) });
+    UpdateNodeBounds(m_Nodes.front());
+    Subdivide(0);
+}
+
+void Bvh::SetBounds(uint32_t objectId, const Bounds& bounds)
+{
+    // Infinite bounds live outside the tree, so switching between the two needs a new tree
+    if(bounds.IsInfinite() != m_Bounds[objectId].IsInfinite())
+        m_NeedsRebuild = true;
+
+    m_Bounds[objectId] = bounds;
+    m_NeedsRefit = true;
+}
+
+void Bvh::Refit()
+{
+    if(m_NeedsRebuild)
+    {
+        const std::vector<Bounds> objectBounds = m_Bounds;
+        Build(objectBounds);
+        return;
+    }
+
+    if(not m_NeedsRefit)
+        return;
+
+    JUL_PROFILE_ZONE("Bvh::Refit");
+
+    for(auto node = m_Nodes.rbegin(); node != m_Nodes.rend(); ++node)
+    {
+        if(node->objectCount > 0)
+        {
+            UpdateNodeBounds(*node);
+            continue;
+        }
+
+        const Node& left = m_Nodes[node->firstOrLeft];
+        const Node& right = m_Nodes[node->firstOrLeft + 1];
+        node->min = glm::min(left.min, right.min);
+        node->max = glm::max(left.max, right.max);
+    }
+
+    m_NeedsRefit = false;
+}
+
+void Bvh::QueryFrustum(const glm::mat4& viewProjection, FrustumCuller& culler, std::vector<uint32_t>& result) const
+{
+    JUL_PROFILE_ZONE("Bvh::QueryFrustum");
+
+    result.insert(result.end(), m_InfiniteObjectIds.begin(), m_InfiniteObjectIds.end());
+
+    if(m_Nodes.empty())
+        return;
+
+    const std::array<glm::vec4, 6> planes = FrustumCuller::ExtractPlanes(viewProjection);
+
+    const size_t firstCandidate = result.size();
+    QueryFrustumNode(0, planes.data(), result);
+
+    // Objects under fully visible nodes always pass, batching them too is cheaper than keeping them apart
+    culler.Clear();
+    for(size_t index = firstCandidate; index < result.size(); ++index)
+        culler.Add(m_Bounds[result[index]]);
+
+    culler.Cull(viewProjection);
+
+    size_t visibleEnd = firstCandidate;
+    for(size_t index = firstCandidate; index < result.size(); ++index)
+    {
+        if(culler.IsVisible(static_cast<uint32_t>(index - firstCandidate)))
+            result[visibleEnd++] = result[index];
+    }
+
+    result.resize(visibleEnd);
+}
+
+std::optional<Bvh::RayHit> Bvh::QueryRay(const Ray& ray) const
+{
+    if(m_Nodes.empty())
+        return std::nullopt;
+
+    // Division by a zero component gives infinity, which the slab test handles
+    const glm::vec3 inverseDirection = 1.0f / ray.direction;
+
+    RayHit hit{ .objectId = 0, .distance = ray.maxDistance };
+    QueryRayNode(0, ray, inverseDirection, hit);
+
+    if(hit.distance >= ray.maxDistance)
+        return std::nullopt;
+
+    return hit;
+}
+
+void Bvh::UpdateNodeBounds(Node& node) const
+{
+    node.min = glm::vec3{ std::numeric_limits<float>::max() };
+    node.max = glm::vec3{ -std::numeric_limits<float>::max() };
+
+    for(uint32_t index = node.firstOrLeft; index < node.firstOrLeft + node.objectCount; ++index)
+    {
+        const Bounds& bounds = m_Bounds[m_ObjectIds[index]];
+        node.min = glm::min(node.min, bounds.GetMin());
+        node.max = glm::max(node.max, bounds.GetMax());
+    }
+}
+
+void Bvh::Subdivide(uint32_t nodeIndex)
+{
+    const uint32_t first = m_Nodes[nodeIndex].firstOrLeft;
+    const uint32_t count = m_Nodes[nodeIndex].objectCount;
+
+    if(count <= MAX_LEAF_SIZE)
+        return;
+
+    glm::vec3 centroidMin{ std::numeric_limits<float>::max() };
+    glm::vec3 centroidMax{ -std::numeric_limits<float>::max() };
+    for(uint32_t index = first; index < first + count; ++index)
+    {
+        centroidMin = glm::min(centroidMin, m_Bounds[m_ObjectIds[index]].center);
+        centroidMax = glm::max(centroidMax, m_Bounds[m_ObjectIds[index]].center);
+    }
+
+    struct Bin
+    {
+        glm::vec3 min{ std::numeric_limits<float>::max() };
+        glm::vec3 max{ -std::numeric_limits<float>::max() };
+        uint32_t count{};
+    };
+
+    // Binned SAH, the split is placed on one of the bin borders along the best axis
+    float bestCost{ std::numeric_limits<float>::max() };
+    int bestAxis{ -1 };
+    float bestSplit{};
+
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        const float extent = centroidMax[axis] - centroidMin[axis];
+        if(extent <= 0.0f)
+            continue;
+
+        std::array<Bin, BIN_COUNT> bins{};
+        const float binScale = static_cast<float>(BIN_COUNT) / extent;
+
+        for(uint32_t index = first; index < first + count; ++index)
+        {
+            const Bounds& bounds = m_Bounds[m_ObjectIds[index]];
+            const auto binIndex = std::min(BIN_COUNT - 1,
+                                           static_cast<uint32_t>((bounds.center[axis] - centroidMin[axis]) * binScale));
+
+            Bin& bin = bins[binIndex];
+            bin.min = glm::min(bin.min, bounds.GetMin());
+            bin.max = glm::max(bin.max, bounds.GetMax());
+            ++bin.count;
+        }
+
+        // Sweep from both sides so every border is scored in linear time
+        std::array<float, BIN_COUNT - 1> leftCosts{};
+        Bin left{};
+        Bin right{};
+
+        for(uint32_t border = 0; border < BIN_COUNT - 1; ++border)
+        {
+            left.min = glm::min(left.min, bins[border].min);
+            left.max = glm::max(left.max, bins[border].max);
+            left.count += bins[border].count;
+            leftCosts[border] = left.count > 0 ? static_cast<float>(left.count) * SurfaceArea(left.min, left.max) : 0.0f;
+        }
+
+        for(uint32_t border = BIN_COUNT - 1; border > 0; --border)
+        {
+            right.min = glm::min(right.min, bins[border].min);
+            right.max = glm::max(right.max, bins[border].max);
+            right.count += bins[border].count;
+
+            if(right.count == 0 or right.count == count)
+                continue;
+
+            const float cost = leftCosts[border - 1] + static_cast<float>(right.count) * SurfaceArea(right.min, right.max);
+            if(cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = centroidMin[axis] + static_cast<float>(border) / binScale;
+            }
+        }
+    }
+
+    // Splitting has to beat testing every object of the node
+    const float leafCost = static_cast<float>(count) * SurfaceArea(m_Nodes[nodeIndex].min, m_Nodes[nodeIndex].max);
+    if(bestAxis < 0 or bestCost >= leafCost)
+        return;
+
+    const auto middle = std::partition(m_ObjectIds.begin() + first,
+                                       m_ObjectIds.begin() + first + count,
+                                       [&](uint32_t objectId) { return m_Bounds[objectId].center[bestAxis] < bestSplit; });
+
+    const auto leftCount = static_cast<uint32_t>(middle - (m_ObjectIds.begin() + first));
+    if(leftCount == 0 or leftCount == count)
+        return;
+
+    const auto leftIndex = static_cast<uint32_t>(m_Nodes.size());
+    m_Nodes.push_back({ .firstOrLeft = first, .objectCount = leftCount });
+    m_Nodes.push_back({ .firstOrLeft = first + leftCount, .objectCount = count - leftCount });
+    UpdateNodeBounds(m_Nodes[leftIndex]);
+    UpdateNodeBounds(m_Nodes[leftIndex + 1]);
+
+    m_Nodes[nodeIndex].firstOrLeft = leftIndex;
+    m_Nodes[nodeIndex].objectCount = 0;
+
+    Subdivide(leftIndex);
+    Subdivide(leftIndex + 1);
+}
+
+void Bvh::QueryFrustumNode(uint32_t nodeIndex, const glm::vec4* planes, std::vector<uint32_t>& result) const
+{
+    const Node& node = m_Nodes[nodeIndex];
+
+    const Containment containment = TestFrustum(node.min, node.max, planes);
+    if(containment == Containment::Outside)
+        return;
+
+    if(node.objectCount == 0 and containment == Containment::Intersecting)
+    {
+        QueryFrustumNode(node.firstOrLeft, planes, result);
+        QueryFrustumNode(node.firstOrLeft + 1, planes, result);
+        return;
+    }
+
+    // Nothing below a fully visible node needs testing, leaf objects are left to the culler
+    CollectObjects(nodeIndex, result);
+}
+
+void Bvh::QueryRayNode(uint32_t nodeIndex, const Ray& ray, const glm::vec3& inverseDirection, RayHit& hit) const
+{
+    const Node& node = m_Nodes[nodeIndex];
+
+    if(node.objectCount > 0)
+    {
+        for(uint32_t index = node.firstOrLeft; index < node.firstOrLeft + node.objectCount; ++index)
+        {
+            const Bounds& bounds = m_Bounds[m_ObjectIds[index]];
+            const float distance = IntersectRay(bounds.GetMin(), bounds.GetMax(), ray, inverseDirection);
+            if(distance < hit.distance)
+                hit = { .objectId = m_ObjectIds[index], .distance = distance };
+        }
+
+        return;
+    }
+
+    uint32_t nearIndex = node.firstOrLeft;
+    uint32_t farIndex = node.firstOrLeft + 1;
+    float nearDistance = IntersectRay(m_Nodes[nearIndex].min, m_Nodes[nearIndex].max, ray, inverseDirection);
+    float farDistance = IntersectRay(m_Nodes[farIndex].min, m_Nodes[farIndex].max, ray, inverseDirection);
+
+    // Visiting the closer child first lets its hit skip the other child
+    if(farDistance < nearDistance)
+    {
+        std::swap(nearIndex, farIndex);
+        std::swap(nearDistance, farDistance);
+    }
+
+    if(nearDistance < hit.distance)
+        QueryRayNode(nearIndex, ray, inverseDirection, hit);
+
+    if(farDistance < hit.distance)
+        QueryRayNode(farIndex, ray, inverseDirection, hit);
+}
+
+void Bvh::CollectObjects(uint32_t nodeIndex, std::vector<uint32_t>& result) const
+{
+    const Node& node = m_Nodes[nodeIndex];
+
+    if(node.objectCount == 0)
+    {
+        CollectObjects(node.firstOrLeft, result);
+        CollectObjects(node.firstOrLeft + 1, result);
+        return;
+    }
+
+    result.insert(result.end(),
+                  m_ObjectIds.begin() + node.firstOrLeft,
+                  m_ObjectIds.begin() + node.firstOrLeft + node.objectCount);
+}
+
+Bvh::Containment Bvh::TestFrustum(const glm::vec3& min, const glm::vec3& max, const glm::vec4* planes)
+{
+    const glm::vec3 center = (min + max) * 0.5f;
+    const glm::vec3 extents = (max - min) * 0.5f;
+
+    Containment containment{ Containment::Inside };
+    for(int planeIndex = 0; planeIndex < 6; ++planeIndex)
+    {
+        const glm::vec3 normal{ planes[planeIndex] };
+        const float distance = glm::dot(normal, center) + planes[planeIndex].w;
+        const float radius = glm::dot(glm::abs(normal), extents);
+
+        if(distance < -radius)
+            return Containment::Outside;
+
+        if(distance < radius)
+            containment = Containment::Intersecting;
+    }
+
+    return containment;
+}
+
+float Bvh::IntersectRay(const glm::vec3& min, const glm::vec3& max, const Ray& ray, const glm::vec3& inverseDirection)
+{
+    // Slab test, returns max float when missed and zero when the origin is inside
+    const glm::vec3 first = (min - ray.origin) * inverseDirection;
+    const glm::vec3 second = (max - ray.origin) * inverseDirection;
+
+    const glm::vec3 nearDistances = glm::min(first, second);
+    const glm::vec3 farDistances = glm::max(first, second);
+
+    const float enter = std::max(std::max(nearDistances.x, nearDistances.y), std::max(nearDistances.z, 0.0f));
+    const float exit = std::min(std::min(farDistances.x, farDistances.y), std::min(farDistances.z, ray.maxDistance));
+
+    if(enter > exit)
+        return std::numeric_limits<float>::max();
+
+    return enter;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include "Bounds.h"
+
+class FrustumCuller;
+
+// Bounding volume hierarchy over object bounds, an object id is the index of its bounds in Build
+// Built once with the surface area heuristic, moving objects only refit the boxes above them
+class Bvh final
+{
+public:
+    struct Ray
+    {
+        glm::vec3 origin{};
+        glm::vec3 direction{};
+        float maxDistance{ std::numeric_limits<float>::max() };
+    };
+
+    struct RayHit
+    {
+        uint32_t objectId;
+        float distance;
+    };
+
+    void Build(const std::vector<Bounds>& objectBounds);
+
+    // Only marks the object, the boxes are updated by the next Refit
+    void SetBounds(uint32_t objectId, const Bounds& bounds);
+
+    // Keeps the tree and only fits the boxes again, the tree gets worse when objects move far from where they were built
+    void Refit();
+
+    // Results are appended, infinite bounds are always included
+    // The tree rejects whole nodes, the objects it keeps are tested in SIMD batches by the culler
+    // The culler is only scratch, its contents are replaced
+    void QueryFrustum(const glm::mat4& viewProjection, FrustumCuller& culler, std::vector<uint32_t>& result) const;
+
+    // Nearest box the ray enters, infinite bounds are never hit
+    [[nodiscard]] std::optional<RayHit> QueryRay(const Ray& ray) const;
+
+    [[nodiscard]] const Bounds& GetBounds(uint32_t objectId) const { return m_Bounds[objectId]; }
+    [[nodiscard]] uint32_t GetObjectCount() const { return static_cast<uint32_t>(m_Bounds.size()); }
+    [[nodiscard]] uint32_t GetNodeCount() const { return static_cast<uint32_t>(m_Nodes.size()); }
+
+    inline static constexpr uint32_t MAX_LEAF_SIZE{ 4 };
+    inline static constexpr uint32_t BIN_COUNT{ 12 };
+
+private:
+    // Children are always stored after their parent, so a reverse walk visits children first
+    struct Node
+    {
+        glm::vec3 min;
+        uint32_t firstOrLeft;  // First leaf object for leaves, left child otherwise with right at left + 1
+        glm::vec3 max;
+        uint32_t objectCount;  // Zero for interior nodes
+    };
+
+    enum class Containment
+    {
+        Outside,
+        Intersecting,
+        Inside
+    };
+
+    void UpdateNodeBounds(Node& node) const;
+    void Subdivide(uint32_t nodeIndex);
+
+    void QueryFrustumNode(uint32_t nodeIndex, const glm::vec4* planes, std::vector<uint32_t>& result) const;
+    void QueryRayNode(uint32_t nodeIndex, const Ray& ray, const glm::vec3& inverseDirection, RayHit& hit) const;
+    void CollectObjects(uint32_t nodeIndex, std::vector<uint32_t>& result) const;
+
+    [[nodiscard]] static Containment TestFrustum(const glm::vec3& min, const glm::vec3& max, const glm::vec4* planes);
+    [[nodiscard]] static float IntersectRay(const glm::vec3& min,
+                                            const glm::vec3& max,
+                                            const Ray& ray,
+                                            const glm::vec3& inverseDirection);
+
+    std::vector<Node> m_Nodes{};
+    std::vector<Bounds> m_Bounds{};
+    // Leaves point into this, it only holds objects with finite bounds
+    std::vector<uint32_t> m_ObjectIds{};
+    std::vector<uint32_t> m_InfiniteObjectIds{};
+
+    bool m_NeedsRefit{};
+    bool m_NeedsRebuild{};
+};
@@ -21,6 +21,10 @@ public:
 
     [[nodiscard]] const glm::vec3& GetPosition() const { return m_Position; }
 
+    [[nodiscard]] const glm::vec3& GetForward() const { return m_Forward; }
+
+    [[nodiscard]] float GetFarClipping() const { return m_FarClippingPlane; }
+
     void SetFovAngle(float fovAngle);
 
     void SetPosition(glm::vec3 position, bool teleport = true);
@@ -60,8 +60,7 @@ void CommandBuffer::BeginBuffer()
 
 void CommandBuffer::EndBuffer()
 {
-	if (vkEndCommandBuffer(m_CommandBuffer) != VK_SUCCESS)
-        throw std::runtime_error("failed to record command buffer!");
+    EndRecording();
 
     const VkSubmitInfo submitInfo{
         .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
@@ -72,3 +71,9 @@ void CommandBuffer::EndBuffer()
     vkQueueSubmit(VulkanGlobals::GetGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE);
     vkQueueWaitIdle(VulkanGlobals::GetGraphicsQueue());
 }
+
+void CommandBuffer::EndRecording()
+{
+    if(vkEndCommandBuffer(m_CommandBuffer) != VK_SUCCESS)
+        throw std::runtime_error("failed to record command buffer!");
+}
@@ -9,8 +9,13 @@ public:
 	~CommandBuffer();
 
     void BeginBuffer();
+
+    // Ends recording, then submits and waits for the queue to finish (one time use buffers)
     void EndBuffer();
 
+    // Only ends recording, submitting is left to the caller
+    void EndRecording();
+
     operator VkCommandBuffer() const { return m_CommandBuffer; }
 
 private:
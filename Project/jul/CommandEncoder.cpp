@@ -0,0 +1,175 @@
+#include "CommandEncoder.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "vulkanbase/VulkanGlobals.h"
+
+void CommandEncoder::Begin(VkCommandBuffer commandBuffer)
+{
+    m_CommandBuffer = commandBuffer;
+
+    m_BindPoints = {};
+    m_VertexBuffer = VK_NULL_HANDLE;
+    m_IndexBuffer = VK_NULL_HANDLE;
+    m_PushConstantLayout = VK_NULL_HANDLE;
+    m_Viewport.reset();
+    m_Scissor.reset();
+    m_FixedFunctionState.reset();
+}
+
+void CommandEncoder::BindPipeline(VkPipelineBindPoint bindPoint, VkPipeline pipeline)
+{
+    BindPointState& state = GetBindPointState(bindPoint);
+    if(state.pipeline == pipeline)
+    {
+        ++m_Stats.pipelines.dropped;
+        return;
+    }
+
+    vkCmdBindPipeline(m_CommandBuffer, bindPoint, pipeline);
+    state.pipeline = pipeline;
+    ++m_Stats.pipelines.issued;
+}
+
+void CommandEncoder::BindDescriptorSet(VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t setIndex,
+                                       VkDescriptorSet descriptorSet)
+{
+    if(setIndex >= MAX_TRACKED_SET_COUNT)
+        throw std::runtime_error("Descriptor set index is too high for the command encoder!");
+
+    BindPointState& state = GetBindPointState(bindPoint);
+    BoundSet& boundSet = state.sets[setIndex];
+
+    if(boundSet.layout == layout and boundSet.descriptorSet == descriptorSet)
+    {
+        ++m_Stats.descriptorSets.dropped;
+        return;
+    }
+
+    vkCmdBindDescriptorSets(m_CommandBuffer, bindPoint, layout, setIndex, 1, &descriptorSet, 0, nullptr);
+    ++m_Stats.descriptorSets.issued;
+
+    // Layouts are not compared for compatibility, sets bound with another layout might have been disturbed
+    for(BoundSet& otherSet : state.sets)
+    {
+        if(otherSet.layout != layout)
+            otherSet = {};
+    }
+
+    boundSet = { .layout = layout, .descriptorSet = descriptorSet };
+}
+
+void CommandEncoder::BindVertexBuffer(VkBuffer buffer, VkDeviceSize offset)
+{
+    if(m_VertexBuffer == buffer and m_VertexOffset == offset)
+    {
+        ++m_Stats.vertexBuffers.dropped;
+        return;
+    }
+
+    vkCmdBindVertexBuffers(m_CommandBuffer, 0, 1, &buffer, &offset);
+    m_VertexBuffer = buffer;
+    m_VertexOffset = offset;
+    ++m_Stats.vertexBuffers.issued;
+}
+
+void CommandEncoder::BindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType)
+{
+    if(m_IndexBuffer == buffer and m_IndexOffset == offset and m_IndexType == indexType)
+    {
+        ++m_Stats.indexBuffers.dropped;
+        return;
+    }
+
+    vkCmdBindIndexBuffer(m_CommandBuffer, buffer, offset, indexType);
+    m_IndexBuffer = buffer;
+    m_IndexOffset = offset;
+    m_IndexType = indexType;
+    ++m_Stats.indexBuffers.issued;
+}
+
+void CommandEncoder::PushConstants(VkPipelineLayout layout, VkShaderStageFlags stages, const void* data,
+                                   uint32_t size)
+{
+    if(size > MAX_PUSH_CONSTANT_SIZE)
+        throw std::runtime_error("Push constants are too big for the command encoder!");
+
+    if(m_PushConstantLayout == layout and m_PushConstantStages == stages and m_PushConstantSize == size and
+       std::memcmp(m_PushConstants.data(), data, size) == 0)
+    {
+        ++m_Stats.pushConstants.dropped;
+        return;
+    }
+
+    vkCmdPushConstants(m_CommandBuffer, layout, stages, 0, size, data);
+    m_PushConstantLayout = layout;
+    m_PushConstantStages = stages;
+    m_PushConstantSize = size;
+    std::memcpy(m_PushConstants.data(), data, size);
+    ++m_Stats.pushConstants.issued;
+}
+
+void CommandEncoder::SetViewport(const VkViewport& viewport)
+{
+    if(m_Viewport.has_value() and std::memcmp(&m_Viewport.value(), &viewport, sizeof(VkViewport)) == 0)
+    {
+        ++m_Stats.dynamicState.dropped;
+        return;
+    }
+
+    vkCmdSetViewport(m_CommandBuffer, 0, 1, &viewport);
+    m_Viewport = viewport;
+    ++m_Stats.dynamicState.issued;
+}
+
+void CommandEncoder::SetScissor(const VkRect2D& scissor)
+{
+    if(m_Scissor.has_value() and std::memcmp(&m_Scissor.value(), &scissor, sizeof(VkRect2D)) == 0)
+    {
+        ++m_Stats.dynamicState.dropped;
+        return;
+    }
+
+    vkCmdSetScissor(m_CommandBuffer, 0, 1, &scissor);
+    m_Scissor = scissor;
+    ++m_Stats.dynamicState.issued;
+}
+
+void CommandEncoder::SetFixedFunctionState(const FixedFunctionState& state)
+{
+    const ExtendedDynamicStateFunctions& functions = VulkanGlobals::GetExtendedDynamicState();
+    if(functions.setCullMode == nullptr)
+        throw std::runtime_error("Fixed function state can't be set without extended dynamic state!");
+
+    const std::optional<FixedFunctionState> previous = m_FixedFunctionState;
+    m_FixedFunctionState = state;
+
+    // Nothing is known after Begin, so every field is recorded once
+    auto record = [this, &previous, &state](auto member, auto setFunction)
+    {
+        if(previous.has_value() and (*previous).*member == state.*member)
+        {
+            ++m_Stats.fixedFunctionState.dropped;
+            return;
+        }
+
+        setFunction(m_CommandBuffer, state.*member);
+        ++m_Stats.fixedFunctionState.issued;
+    };
+
+    record(&FixedFunctionState::cullMode, functions.setCullMode);
+    record(&FixedFunctionState::frontFace, functions.setFrontFace);
+    record(&FixedFunctionState::topology, functions.setPrimitiveTopology);
+    record(&FixedFunctionState::depthTestEnable, functions.setDepthTestEnable);
+    record(&FixedFunctionState::depthWriteEnable, functions.setDepthWriteEnable);
+    record(&FixedFunctionState::depthCompareOp, functions.setDepthCompareOp);
+
+    if(functions.setPrimitiveRestartEnable != nullptr)
+        record(&FixedFunctionState::primitiveRestartEnable, functions.setPrimitiveRestartEnable);
+}
+
+CommandEncoder::BindPointState& CommandEncoder::GetBindPointState(VkPipelineBindPoint bindPoint)
+{
+    return m_BindPoints[bindPoint == VK_PIPELINE_BIND_POINT_COMPUTE ? 1 : 0];
+}
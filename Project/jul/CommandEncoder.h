@@ -0,0 +1,119 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+// Baked into every pipeline, or set on the command buffer when the device has extended dynamic state
+struct FixedFunctionState
+{
+    VkCullModeFlags cullMode{ VK_CULL_MODE_FRONT_BIT };
+    VkFrontFace frontFace{ VK_FRONT_FACE_CLOCKWISE };
+    VkPrimitiveTopology topology{ VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST };
+    VkBool32 primitiveRestartEnable{ VK_FALSE };
+    VkBool32 depthTestEnable{ VK_TRUE };
+    VkBool32 depthWriteEnable{ VK_TRUE };
+    VkCompareOp depthCompareOp{ VK_COMPARE_OP_LESS };
+
+    bool operator==(const FixedFunctionState&) const = default;
+};
+
+// Records state commands into a command buffer and drops the ones that would not change anything
+//
+// Only state set through the encoder is tracked, call Begin again after binding around it
+// Viewport and scissor are assumed to be dynamic in every graphics pipeline
+class CommandEncoder final
+{
+public:
+    struct Counter
+    {
+        uint32_t issued{};
+        uint32_t dropped{};
+    };
+
+    struct Stats
+    {
+        Counter pipelines{};
+        Counter descriptorSets{};
+        Counter vertexBuffers{};
+        Counter indexBuffers{};
+        Counter pushConstants{};
+        Counter dynamicState{};
+        // One per field, extended dynamic state only
+        Counter fixedFunctionState{};
+    };
+
+    CommandEncoder() = default;
+
+    // Forgets everything that was bound, stats keep counting until ResetStats
+    void Begin(VkCommandBuffer commandBuffer);
+    void ResetStats() { m_Stats = {}; }
+
+    void BindPipeline(VkPipelineBindPoint bindPoint, VkPipeline pipeline);
+
+    // Binding with a different layout forgets the sets that were bound with another one
+    void BindDescriptorSet(VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t setIndex,
+                           VkDescriptorSet descriptorSet);
+
+    void BindVertexBuffer(VkBuffer buffer, VkDeviceSize offset = 0);
+    void BindIndexBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkIndexType indexType = VK_INDEX_TYPE_UINT32);
+
+    // Always at offset 0, dropped when the layout, stages and bytes match the last push
+    void PushConstants(VkPipelineLayout layout, VkShaderStageFlags stages, const void* data, uint32_t size);
+
+    void SetViewport(const VkViewport& viewport);
+    void SetScissor(const VkRect2D& scissor);
+
+    // Only records the fields that changed, needs VK_EXT_extended_dynamic_state
+    // Primitive restart is skipped without VK_EXT_extended_dynamic_state2, pipelines bake it then
+    void SetFixedFunctionState(const FixedFunctionState& state);
+
+    [[nodiscard]] const Stats& GetStats() const { return m_Stats; }
+
+    // Draws, barriers and anything else that is not tracked go to the command buffer directly
+    operator VkCommandBuffer() const { return m_CommandBuffer; }
+
+    inline static constexpr uint32_t MAX_TRACKED_SET_COUNT{ 4 };
+    inline static constexpr uint32_t MAX_PUSH_CONSTANT_SIZE{ 128 };
+
+private:
+    struct BoundSet
+    {
+        VkPipelineLayout layout;
+        VkDescriptorSet descriptorSet;
+    };
+
+    struct BindPointState
+    {
+        VkPipeline pipeline;
+        std::array<BoundSet, MAX_TRACKED_SET_COUNT> sets;
+    };
+
+    [[nodiscard]] BindPointState& GetBindPointState(VkPipelineBindPoint bindPoint);
+
+    VkCommandBuffer m_CommandBuffer{};
+
+    // Graphics then compute
+    std::array<BindPointState, 2> m_BindPoints{};
+
+    VkBuffer m_VertexBuffer{};
+    VkDeviceSize m_VertexOffset{};
+
+    VkBuffer m_IndexBuffer{};
+    VkDeviceSize m_IndexOffset{};
+    VkIndexType m_IndexType{};
+
+    VkPipelineLayout m_PushConstantLayout{};
+    VkShaderStageFlags m_PushConstantStages{};
+    uint32_t m_PushConstantSize{};
+    std::array<std::byte, MAX_PUSH_CONSTANT_SIZE> m_PushConstants{};
+
+    std::optional<VkViewport> m_Viewport{};
+    std::optional<VkRect2D> m_Scissor{};
+    std::optional<FixedFunctionState> m_FixedFunctionState{};
+
+    Stats m_Stats{};
+};
@@ -0,0 +1,93 @@
+#include "ComputePipeline.h"
+
+#include <chrono>
+#include <stdexcept>
+
+#include "DescriptorAllocator.h"
+#include "PipelineCache.h"
+#include "ShaderBlob.h"
+#include "vulkanbase/VulkanGlobals.h"
+
+ComputePipeline::ComputePipeline(const path& computePath, const std::vector<VkDescriptorType>& bindingTypes,
+                                 uint32_t pushConstantSize)
+{
+    const VkDevice device = VulkanGlobals::GetDevice();
+
+    std::vector<VkDescriptorSetLayoutBinding> bindings{};
+    bindings.reserve(bindingTypes.size());
+    for(const VkDescriptorType bindingType : bindingTypes)
+    {
+        bindings.push_back({
+            .binding = static_cast<uint32_t>(bindings.size()),
+            .descriptorType = bindingType,
+            .descriptorCount = 1,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        });
+    }
+
+    m_DescriptorSetLayout = VulkanGlobals::GetDescriptorAllocator().GetLayout(bindings);
+
+    const VkPushConstantRange pushConstantRange{
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = pushConstantSize,
+    };
+
+    const VkPipelineLayoutCreateInfo pipelineLayoutInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = 1,
+        .pSetLayouts = &m_DescriptorSetLayout,
+        .pushConstantRangeCount = pushConstantSize > 0 ? 1u : 0u,
+        .pPushConstantRanges = &pushConstantRange,
+    };
+
+    if(vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &m_PipelineLayout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create compute pipeline layout!");
+
+    const VkShaderModule shaderModule = Shader::CreateShaderModule(ShaderBlob{ computePath }.GetCode(), device);
+
+    const VkComputePipelineCreateInfo pipelineInfo{
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = shaderModule,
+            .pName = "main",
+        },
+        .layout = m_PipelineLayout,
+    };
+
+    const auto creationStart = std::chrono::steady_clock::now();
+    const VkResult result =
+        vkCreateComputePipelines(device, PipelineCache::Get(), 1, &pipelineInfo, nullptr, &m_Pipeline);
+
+    PipelineCache::AddCreationTime(
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - creationStart).count());
+
+    // The module is only needed to create the pipeline
+    vkDestroyShaderModule(device, shaderModule, nullptr);
+
+    if(result != VK_SUCCESS)
+        throw std::runtime_error("failed to create compute pipeline!");
+}
+
+ComputePipeline::~ComputePipeline()
+{
+    const VkDevice device = VulkanGlobals::GetDevice();
+    vkDestroyPipeline(device, m_Pipeline, nullptr);
+    vkDestroyPipelineLayout(device, m_PipelineLayout, nullptr);
+}
+
+void ComputePipeline::Bind(VkCommandBuffer commandBuffer, VkDescriptorSet descriptorSet)
+{
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline);
+    vkCmdBindDescriptorSets(
+        commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+}
+
+void ComputePipeline::UpdatePushConstant(VkCommandBuffer commandBuffer, const void* pushConstants,
+                                         uint32_t pushConstantSize)
+{
+    vkCmdPushConstants(
+        commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, pushConstantSize, pushConstants);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "Shader.h"
+
+// Compute shader with a single descriptor set, binding i of the set has type bindingTypes[i]
+class ComputePipeline final
+{
+public:
+    ComputePipeline(const path& computePath, const std::vector<VkDescriptorType>& bindingTypes,
+                    uint32_t pushConstantSize = 0);
+    ~ComputePipeline();
+
+    ComputePipeline(ComputePipeline&&) = delete;
+    ComputePipeline(const ComputePipeline&) = delete;
+    ComputePipeline& operator=(ComputePipeline&&) = delete;
+    ComputePipeline& operator=(const ComputePipeline&) = delete;
+
+    void Bind(VkCommandBuffer commandBuffer, VkDescriptorSet descriptorSet);
+    void UpdatePushConstant(VkCommandBuffer commandBuffer, const void* pushConstants, uint32_t pushConstantSize);
+
+    [[nodiscard]] VkDescriptorSetLayout GetDescriptorSetLayout() const { return m_DescriptorSetLayout; }
+
+private:
+    VkPipeline m_Pipeline{};
+    VkPipelineLayout m_PipelineLayout{};
+
+    // Owned by the descriptor allocator
+    VkDescriptorSetLayout m_DescriptorSetLayout{};
+};
@@ -0,0 +1,203 @@
+#include "CpuProfiler.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define JUL_PROFILER_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define JUL_PROFILER_RDTSC 1
+#else
+#define JUL_PROFILER_RDTSC 0
+#endif
+
+namespace
+{
+    double GetSteadySeconds()
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}  // namespace
+
+uint64_t CpuProfiler::GetTicks()
+{
+#if JUL_PROFILER_RDTSC
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+void CpuProfiler::BeginFrame()
+{
+    const uint64_t frameTicks = GetTicks();
+
+    if(IsCapturing())
+    {
+        RecordZone("Frame", s_FrameBeginTicks, frameTicks);
+
+        if(--s_FramesLeftToCapture <= 0)
+            FinishCapture();
+    }
+    else if(s_FramesLeftToCapture > 0)
+    {
+        StartCapture();
+    }
+
+    s_FrameBeginTicks = GetTicks();
+}
+
+void CpuProfiler::CaptureFrames(int frameCount, const std::filesystem::path& path)
+{
+    if(IsCapturing() or frameCount <= 0)
+        return;
+
+    s_FramesToCapture = frameCount;
+    s_FramesLeftToCapture = frameCount;
+    s_CapturePath = path;
+}
+
+void CpuProfiler::SetThreadName(const std::string& name) { GetThreadBuffer().threadName = name; }
+
+void CpuProfiler::RecordZone(const char* name, uint64_t beginTicks, uint64_t endTicks)
+{
+    if(not IsCapturing())
+        return;
+
+    ThreadBuffer& buffer = GetThreadBuffer();
+
+    // First event of a new capture, only the owning thread ever resets its buffer
+    const uint32_t generation = s_Generation.load(std::memory_order_acquire);
+    if(buffer.generation.load(std::memory_order_relaxed) != generation)
+    {
+        buffer.generation.store(generation, std::memory_order_relaxed);
+        buffer.droppedCount.store(0, std::memory_order_relaxed);
+        buffer.eventCount.store(0, std::memory_order_relaxed);
+    }
+
+    const uint32_t eventIndex = buffer.eventCount.load(std::memory_order_relaxed);
+    if(eventIndex >= buffer.events.size())
+    {
+        buffer.droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    buffer.events[eventIndex] = { name, beginTicks, endTicks };
+    buffer.eventCount.store(eventIndex + 1, std::memory_order_release);
+}
+
+CpuProfiler::ThreadBuffer& CpuProfiler::GetThreadBuffer()
+{
+    // Buffers are leaked on purpose, a thread can exit while its events still have to be written out
+    thread_local ThreadBuffer* bufferPtr = nullptr;
+
+    if(bufferPtr == nullptr)
+    {
+        bufferPtr = new ThreadBuffer{};
+        bufferPtr->generation.store(s_Generation.load(std::memory_order_acquire), std::memory_order_relaxed);
+
+        const std::lock_guard lock{ s_ThreadBuffersMutex };
+        bufferPtr->threadIndex = static_cast<uint32_t>(s_ThreadBuffers.size());
+        bufferPtr->threadName = "Thread " + std::to_string(bufferPtr->threadIndex);
+        s_ThreadBuffers.push_back(bufferPtr);
+    }
+
+    return *bufferPtr;
+}
+
+void CpuProfiler::StartCapture()
+{
+    s_Generation.fetch_add(1, std::memory_order_release);
+
+    s_CaptureBeginSeconds = GetSteadySeconds();
+    s_CaptureBeginTicks = GetTicks();
+
+    s_Capturing.store(true, std::memory_order_relaxed);
+}
+
+void CpuProfiler::FinishCapture()
+{
+    s_Capturing.store(false, std::memory_order_relaxed);
+
+    s_CaptureEndSeconds = GetSteadySeconds();
+    s_CaptureEndTicks = GetTicks();
+
+    s_FramesLeftToCapture = 0;
+
+    WriteTrace();
+}
+
+void CpuProfiler::WriteTrace()
+{
+#if JUL_PROFILER_RDTSC
+    const double elapsedSeconds = s_CaptureEndSeconds - s_CaptureBeginSeconds;
+    const double ticksPerMicrosecond =
+        elapsedSeconds > 0.0 ? static_cast<double>(s_CaptureEndTicks - s_CaptureBeginTicks) / (elapsedSeconds * 1e6)
+                             : 1.0;
+#else
+    constexpr double ticksPerMicrosecond =
+        static_cast<double>(std::chrono::steady_clock::period::den) /
+        (static_cast<double>(std::chrono::steady_clock::period::num) * 1e6);
+#endif
+
+    std::ofstream file(s_CapturePath);
+    if(not file.is_open())
+    {
+        std::cerr << "Failed to write CPU trace to: " << s_CapturePath.string() << '\n';
+        return;
+    }
+
+    const uint32_t generation = s_Generation.load(std::memory_order_acquire);
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    bool firstEvent = true;
+    auto writeSeparator = [&file, &firstEvent]()
+    {
+        if(not firstEvent)
+            file << ",\n";
+        firstEvent = false;
+    };
+
+    uint64_t eventCount{};
+    uint64_t droppedCount{};
+
+    const std::lock_guard lock{ s_ThreadBuffersMutex };
+    for(const ThreadBuffer* bufferPtr : s_ThreadBuffers)
+    {
+        writeSeparator();
+        file << R"({"name":"thread_name","ph":"M","pid":0,"tid":)" << bufferPtr->threadIndex
+             << R"(,"args":{"name":")" << bufferPtr->threadName << "\"}}";
+
+        if(bufferPtr->generation.load(std::memory_order_relaxed) != generation)
+            continue;
+
+        const uint32_t bufferEventCount = bufferPtr->eventCount.load(std::memory_order_acquire);
+        for(uint32_t eventIndex = 0; eventIndex < bufferEventCount; ++eventIndex)
+        {
+            const Event& event = bufferPtr->events[eventIndex];
+
+            // Zones that started before the capture did
+            if(event.beginTicks < s_CaptureBeginTicks)
+                continue;
+
+            const double begin = static_cast<double>(event.beginTicks - s_CaptureBeginTicks) / ticksPerMicrosecond;
+            const double duration = static_cast<double>(event.endTicks - event.beginTicks) / ticksPerMicrosecond;
+
+            writeSeparator();
+            file << R"({"name":")" << event.name << R"(","ph":"X","pid":0,"tid":)" << bufferPtr->threadIndex
+                 << ",\"ts\":" << begin << ",\"dur\":" << duration << '}';
+        }
+
+        eventCount += bufferEventCount;
+        droppedCount += bufferPtr->droppedCount.load(std::memory_order_relaxed);
+    }
+
+    file << "\n]}\n";
+
+    std::cout << "CPU trace of " << s_FramesToCapture << " frames written to " << s_CapturePath.string() << " ("
+              << eventCount << " zones, " << droppedCount << " dropped)" << std::endl;
+}
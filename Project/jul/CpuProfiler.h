@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifndef JUL_PROFILER_ENABLED
+#define JUL_PROFILER_ENABLED 1
+#endif
+
+// Instrumented CPU zone profiler
+// Every thread writes its zones to its own buffer without locking, the buffers are only read
+// once a capture finishes and are written out as Chrome trace_event JSON (chrome://tracing, Perfetto)
+class CpuProfiler final
+{
+public:
+    // Call once at the start of every frame, starts and finishes captures
+    static void BeginFrame();
+
+    // Captures the next frameCount frames and writes them to path once done
+    static void CaptureFrames(int frameCount, const std::filesystem::path& path);
+
+    static void SetThreadName(const std::string& name);
+
+    static void RecordZone(const char* name, uint64_t beginTicks, uint64_t endTicks);
+
+    [[nodiscard]] static bool IsCapturing() { return s_Capturing.load(std::memory_order_relaxed); }
+
+    [[nodiscard]] static uint64_t GetTicks();
+
+private:
+    struct Event
+    {
+        const char* name;
+        uint64_t beginTicks;
+        uint64_t endTicks;
+    };
+
+    struct ThreadBuffer
+    {
+        std::array<Event, 1 << 16> events{};
+        std::atomic<uint32_t> eventCount{};
+        std::atomic<uint32_t> droppedCount{};
+        std::atomic<uint32_t> generation{};
+        uint32_t threadIndex{};
+        std::string threadName{};
+    };
+
+    [[nodiscard]] static ThreadBuffer& GetThreadBuffer();
+
+    static void StartCapture();
+    static void FinishCapture();
+    static void WriteTrace();
+
+    inline static std::atomic<bool> s_Capturing{ false };
+    inline static std::atomic<uint32_t> s_Generation{ 0 };
+
+    inline static std::mutex s_ThreadBuffersMutex{};
+    inline static std::vector<ThreadBuffer*> s_ThreadBuffers{};
+
+    inline static int s_FramesLeftToCapture{};
+    inline static int s_FramesToCapture{};
+    inline static uint64_t s_FrameBeginTicks{};
+    inline static std::filesystem::path s_CapturePath{};
+
+    // Tick to time calibration taken at capture start and end
+    inline static uint64_t s_CaptureBeginTicks{};
+    inline static uint64_t s_CaptureEndTicks{};
+    inline static double s_CaptureBeginSeconds{};
+    inline static double s_CaptureEndSeconds{};
+};
+
+class CpuZone final
+{
+public:
+    explicit CpuZone(const char* name) :
+        m_Name(name),
+        m_BeginTicks(CpuProfiler::IsCapturing() ? CpuProfiler::GetTicks() : 0)
+    {
+    }
+
+    ~CpuZone()
+    {
+        if(m_BeginTicks != 0)
+            CpuProfiler::RecordZone(m_Name, m_BeginTicks, CpuProfiler::GetTicks());
+    }
+
+    CpuZone(CpuZone&&) = delete;
+    CpuZone(const CpuZone&) = delete;
+    CpuZone& operator=(CpuZone&&) = delete;
+    CpuZone& operator=(const CpuZone&) = delete;
+
+private:
+    const char* m_Name;
+    uint64_t m_BeginTicks;
+};
+
+#define JUL_PROFILE_CONCAT_INNER(a, b) a##b
+#define JUL_PROFILE_CONCAT(a, b) JUL_PROFILE_CONCAT_INNER(a, b)
+
+#if JUL_PROFILER_ENABLED
+#define JUL_PROFILE_ZONE(name) const CpuZone JUL_PROFILE_CONCAT(cpuZone, __LINE__){ name }
+#else
+#define JUL_PROFILE_ZONE(name)
+#endif
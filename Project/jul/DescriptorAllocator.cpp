@@ -0,0 +1,306 @@
+#include "DescriptorAllocator.h"
+
+#include <vulkan/vk_enum_string_helper.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "vulkanbase/VulkanGlobals.h"
+
+using namespace std::string_literals;
+
+namespace
+{
+    // Descriptors per set of every type, enough for the materials, pipelines and culling passes
+    constexpr std::array<VkDescriptorPoolSize, 4> POOL_SIZES_PER_SET{
+        VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 },
+        VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 },
+        VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4 },
+        VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1 },
+    };
+
+    bool IsImageDescriptor(VkDescriptorType type)
+    {
+        return type == VK_DESCRIPTOR_TYPE_SAMPLER or type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER or
+               type == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE or type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE or
+               type == VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+    }
+
+    bool IsBufferDescriptor(VkDescriptorType type)
+    {
+        return type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER or type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER or
+               type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC or type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    }
+}  // namespace
+
+DescriptorAllocator::DescriptorAllocator(VkDevice device) :
+    m_Device(device)
+{
+}
+
+DescriptorAllocator::~DescriptorAllocator()
+{
+    for(const Pool& pool : m_PersistentPools)
+        vkDestroyDescriptorPool(m_Device, pool.pool, nullptr);
+
+    for(const std::vector<Pool>& framePools : m_FramePools)
+    {
+        for(const Pool& pool : framePools)
+            vkDestroyDescriptorPool(m_Device, pool.pool, nullptr);
+    }
+
+    for(const Pool& pool : m_FreePools)
+        vkDestroyDescriptorPool(m_Device, pool.pool, nullptr);
+
+    for(auto&& [layout, cachedLayout] : m_CachedLayouts)
+    {
+        if(cachedLayout.updateTemplate != VK_NULL_HANDLE)
+            VulkanGlobals::GetDestroyDescriptorUpdateTemplate()(m_Device, cachedLayout.updateTemplate, nullptr);
+
+        vkDestroyDescriptorSetLayout(m_Device, layout, nullptr);
+    }
+}
+
+VkDescriptorSetLayout DescriptorAllocator::GetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+{
+    LayoutKey key{};
+    key.reserve(bindings.size());
+    for(const VkDescriptorSetLayoutBinding& binding : bindings)
+        key.push_back({ binding.binding, binding.descriptorType, binding.descriptorCount, binding.stageFlags });
+
+    // Binding order does not change the layout
+    std::ranges::sort(key);
+
+    if(auto found = m_LayoutCache.find(key); found != m_LayoutCache.end())
+        return found->second;
+
+    const VkDescriptorSetLayoutCreateInfo layoutInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = static_cast<uint32_t>(bindings.size()),
+        .pBindings = bindings.data(),
+    };
+
+    VkDescriptorSetLayout layout{};
+    if(vkCreateDescriptorSetLayout(m_Device, &layoutInfo, nullptr, &layout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create descriptor set layout!");
+
+    CachedLayout cachedLayout{};
+
+    size_t offset{};
+    for(const auto& [binding, type, count, stages] : key)
+    {
+        const auto descriptorType = static_cast<VkDescriptorType>(type);
+
+        const auto poolSize = std::ranges::find(POOL_SIZES_PER_SET, descriptorType, &VkDescriptorPoolSize::type);
+        if(poolSize == POOL_SIZES_PER_SET.end())
+            throw std::runtime_error("Descriptor type is not supported by the descriptor allocator!");
+
+        cachedLayout.descriptorCounts[poolSize - POOL_SIZES_PER_SET.begin()] += count;
+
+        size_t infoSize{};
+        if(IsImageDescriptor(descriptorType))
+            infoSize = sizeof(VkDescriptorImageInfo);
+        else if(IsBufferDescriptor(descriptorType))
+            infoSize = sizeof(VkDescriptorBufferInfo);
+        else
+            throw std::runtime_error("Descriptor type is not supported by the descriptor allocator!");
+
+        cachedLayout.entries.push_back({
+            .dstBinding = binding,
+            .dstArrayElement = 0,
+            .descriptorCount = count,
+            .descriptorType = descriptorType,
+            .offset = offset,
+            .stride = infoSize,
+        });
+
+        offset += infoSize * count;
+    }
+
+    if(VulkanGlobals::GetCreateDescriptorUpdateTemplate() != nullptr)
+    {
+        const VkDescriptorUpdateTemplateCreateInfoKHR templateInfo{
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO_KHR,
+            .descriptorUpdateEntryCount = static_cast<uint32_t>(cachedLayout.entries.size()),
+            .pDescriptorUpdateEntries = cachedLayout.entries.data(),
+            .templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET_KHR,
+            .descriptorSetLayout = layout,
+        };
+
+        if(VulkanGlobals::GetCreateDescriptorUpdateTemplate()(
+               m_Device, &templateInfo, nullptr, &cachedLayout.updateTemplate) != VK_SUCCESS)
+            throw std::runtime_error("failed to create descriptor update template!");
+    }
+
+    m_LayoutCache.emplace(std::move(key), layout);
+    m_CachedLayouts.emplace(layout, std::move(cachedLayout));
+    return layout;
+}
+
+VkDescriptorSet DescriptorAllocator::Allocate(VkDescriptorSetLayout layout)
+{
+    return AllocateFrom(m_PersistentPools, layout);
+}
+
+VkDescriptorSet DescriptorAllocator::AllocateTransient(int frameIndex, VkDescriptorSetLayout layout)
+{
+    if(frameIndex >= static_cast<int>(m_FramePools.size()))
+        m_FramePools.resize(frameIndex + 1);
+
+    return AllocateFrom(m_FramePools[frameIndex], layout);
+}
+
+void DescriptorAllocator::ResetFrame(int frameIndex)
+{
+    if(frameIndex >= static_cast<int>(m_FramePools.size()))
+        return;
+
+    for(Pool& pool : m_FramePools[frameIndex])
+    {
+        vkResetDescriptorPool(m_Device, pool.pool, 0);
+        Refill(pool);
+        m_FreePools.push_back(pool);
+    }
+
+    m_FramePools[frameIndex].clear();
+}
+
+void DescriptorAllocator::Write(VkDescriptorSet descriptorSet, VkDescriptorSetLayout layout, const void* data) const
+{
+    const CachedLayout& cachedLayout = m_CachedLayouts.at(layout);
+
+    if(cachedLayout.updateTemplate != VK_NULL_HANDLE)
+    {
+        VulkanGlobals::GetUpdateDescriptorSetWithTemplate()(m_Device, descriptorSet, cachedLayout.updateTemplate, data);
+        return;
+    }
+
+    // Without the extension the template entries are turned into writes
+    std::vector<VkWriteDescriptorSet> writes{};
+    writes.reserve(cachedLayout.entries.size());
+
+    for(const VkDescriptorUpdateTemplateEntryKHR& entry : cachedLayout.entries)
+    {
+        const auto* entryData = static_cast<const std::byte*>(data) + entry.offset;
+        const bool isImage = IsImageDescriptor(entry.descriptorType);
+
+        writes.push_back({
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = descriptorSet,
+            .dstBinding = entry.dstBinding,
+            .dstArrayElement = entry.dstArrayElement,
+            .descriptorCount = entry.descriptorCount,
+            .descriptorType = entry.descriptorType,
+            .pImageInfo = isImage ? reinterpret_cast<const VkDescriptorImageInfo*>(entryData) : nullptr,
+            .pBufferInfo = isImage ? nullptr : reinterpret_cast<const VkDescriptorBufferInfo*>(entryData),
+        });
+    }
+
+    vkUpdateDescriptorSets(m_Device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+VkDescriptorSet DescriptorAllocator::AllocateFrom(std::vector<Pool>& pools, VkDescriptorSetLayout layout)
+{
+    const CachedLayout& cachedLayout = m_CachedLayouts.at(layout);
+
+    // A full pool is kept until it is reset or destroyed, the chain continues in a new one
+    if(pools.empty() or not Fits(pools.back(), cachedLayout))
+        pools.push_back(GetPool(cachedLayout));
+
+    Pool& pool = pools.back();
+
+    const VkDescriptorSetAllocateInfo allocateInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = pool.pool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &layout,
+    };
+
+    VkDescriptorSet descriptorSet{};
+    const VkResult result = vkAllocateDescriptorSets(m_Device, &allocateInfo, &descriptorSet);
+    if(result != VK_SUCCESS)
+        throw std::runtime_error{ "failed to allocate descriptor set! error: "s + string_VkResult(result) };
+
+    --pool.setsLeft;
+    for(uint32_t typeIndex = 0; typeIndex < POOL_TYPE_COUNT; ++typeIndex)
+        pool.descriptorsLeft[typeIndex] -= cachedLayout.descriptorCounts[typeIndex];
+
+    return descriptorSet;
+}
+
+DescriptorAllocator::Pool DescriptorAllocator::GetPool(const CachedLayout& cachedLayout)
+{
+    // Reset pools can be smaller than the layout needs if they were made early
+    const auto freePool = std::ranges::find_if(m_FreePools, [&](const Pool& pool) { return Fits(pool, cachedLayout); });
+    if(freePool != m_FreePools.end())
+    {
+        const Pool pool = *freePool;
+        m_FreePools.erase(freePool);
+        return pool;
+    }
+
+    const Pool pool = CreatePool();
+    if(not Fits(pool, cachedLayout))
+    {
+        m_FreePools.push_back(pool);
+        throw std::runtime_error("Descriptor set layout needs more descriptors than a pool holds!");
+    }
+
+    return pool;
+}
+
+bool DescriptorAllocator::Fits(const Pool& pool, const CachedLayout& cachedLayout)
+{
+    if(pool.setsLeft == 0)
+        return false;
+
+    for(uint32_t typeIndex = 0; typeIndex < POOL_TYPE_COUNT; ++typeIndex)
+    {
+        if(cachedLayout.descriptorCounts[typeIndex] > pool.descriptorsLeft[typeIndex])
+            return false;
+    }
+
+    return true;
+}
+
+DescriptorAllocator::Pool DescriptorAllocator::CreatePool()
+{
+    const uint32_t setCount = m_NextPoolSetCount;
+    m_NextPoolSetCount = std::min(m_NextPoolSetCount * 2, MAX_POOL_SET_COUNT);
+
+    Pool pool{ .setCount = setCount };
+    Refill(pool);
+
+    std::array<VkDescriptorPoolSize, POOL_TYPE_COUNT> poolSizes{};
+    for(uint32_t typeIndex = 0; typeIndex < POOL_TYPE_COUNT; ++typeIndex)
+    {
+        poolSizes[typeIndex] = {
+            .type = POOL_SIZES_PER_SET[typeIndex].type,
+            .descriptorCount = pool.descriptorsLeft[typeIndex],
+        };
+    }
+
+    const VkDescriptorPoolCreateInfo poolInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags = 0,
+        .maxSets = setCount,
+        .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+        .pPoolSizes = poolSizes.data(),
+    };
+
+    if(vkCreateDescriptorPool(m_Device, &poolInfo, nullptr, &pool.pool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create descriptor pool!");
+
+    ++m_PoolCount;
+    return pool;
+}
+
+void DescriptorAllocator::Refill(Pool& pool)
+{
+    pool.setsLeft = pool.setCount;
+    for(uint32_t typeIndex = 0; typeIndex < POOL_TYPE_COUNT; ++typeIndex)
+        pool.descriptorsLeft[typeIndex] = POOL_SIZES_PER_SET[typeIndex].descriptorCount * pool.setCount;
+}
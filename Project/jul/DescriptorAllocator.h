@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+// Hands out descriptor sets from chained pools, a full pool never fails an allocation, the next one is used instead
+//
+// Persistent sets live as long as the allocator, transient sets until their frame is reset. What is left in the
+// current pool is counted, so the next pool is started before an allocation could overflow it, Vulkan 1.0 without
+// maintenance1 doesn't report a full pool
+// Layouts are cached by their bindings and every layout gets an update template,
+// so a set is written with one call from a struct of descriptor infos
+class DescriptorAllocator final
+{
+public:
+    explicit DescriptorAllocator(VkDevice device);
+    ~DescriptorAllocator();
+
+    DescriptorAllocator(DescriptorAllocator&&) = delete;
+    DescriptorAllocator(const DescriptorAllocator&) = delete;
+    DescriptorAllocator& operator=(DescriptorAllocator&&) = delete;
+    DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+    // Equal bindings give the same layout, the allocator owns it
+    [[nodiscard]] VkDescriptorSetLayout GetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+
+    // The layout must come from GetLayout
+    [[nodiscard]] VkDescriptorSet Allocate(VkDescriptorSetLayout layout);
+    [[nodiscard]] VkDescriptorSet AllocateTransient(int frameIndex, VkDescriptorSetLayout layout);
+
+    // Only call once the frame is done on the GPU, its pools go back to be reused by any frame
+    void ResetFrame(int frameIndex);
+
+    // Data holds a VkDescriptorImageInfo or VkDescriptorBufferInfo per descriptor,
+    // back to back in binding order, the layout must come from GetLayout
+    void Write(VkDescriptorSet descriptorSet, VkDescriptorSetLayout layout, const void* data) const;
+
+    [[nodiscard]] uint32_t GetPoolCount() const { return m_PoolCount; }
+
+    inline static constexpr uint32_t FIRST_POOL_SET_COUNT{ 64 };
+    inline static constexpr uint32_t MAX_POOL_SET_COUNT{ 4'096 };
+
+private:
+    // Uniform buffers, storage buffers, combined image samplers and storage images
+    inline static constexpr uint32_t POOL_TYPE_COUNT{ 4 };
+
+    using DescriptorCounts = std::array<uint32_t, POOL_TYPE_COUNT>;
+
+    struct CachedLayout
+    {
+        VkDescriptorUpdateTemplateKHR updateTemplate;
+        std::vector<VkDescriptorUpdateTemplateEntryKHR> entries;
+        DescriptorCounts descriptorCounts;
+    };
+
+    struct Pool
+    {
+        VkDescriptorPool pool;
+        uint32_t setCount;
+        uint32_t setsLeft;
+        DescriptorCounts descriptorsLeft;
+    };
+
+    // Binding, type, count and stages of every binding
+    using LayoutKey = std::vector<std::array<uint32_t, 4>>;
+
+    [[nodiscard]] VkDescriptorSet AllocateFrom(std::vector<Pool>& pools, VkDescriptorSetLayout layout);
+    [[nodiscard]] static bool Fits(const Pool& pool, const CachedLayout& cachedLayout);
+    [[nodiscard]] Pool GetPool(const CachedLayout& cachedLayout);
+    [[nodiscard]] Pool CreatePool();
+    static void Refill(Pool& pool);
+
+    VkDevice m_Device{};
+
+    std::map<LayoutKey, VkDescriptorSetLayout> m_LayoutCache{};
+    std::unordered_map<VkDescriptorSetLayout, CachedLayout> m_CachedLayouts{};
+
+    // The last pool of a chain is the one allocated from
+    std::vector<Pool> m_PersistentPools{};
+    std::vector<std::vector<Pool>> m_FramePools{};
+    std::vector<Pool> m_FreePools{};
+
+    // Every new pool doubles in size, so long runs of allocations only create a few pools
+    uint32_t m_NextPoolSetCount{ FIRST_POOL_SET_COUNT };
+    uint32_t m_PoolCount{};
+};
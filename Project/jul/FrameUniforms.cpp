@@ -0,0 +1,76 @@
+#include "FrameUniforms.h"
+
+#include <array>
+
+#include "DescriptorAllocator.h"
+#include "SwapChain.h"
+#include "vulkanbase/VulkanGlobals.h"
+
+FrameUniforms::FrameUniforms(VkDeviceSize uboSize, VkBuffer instanceBuffer)
+{
+    CreateSetLayout(instanceBuffer != VK_NULL_HANDLE);
+    CreateUniformBuffers(VulkanGlobals::GetSwapChain().GetImageCount(), uboSize);
+    CreateDescriptorSets(instanceBuffer);
+}
+
+void FrameUniforms::Update(int imageIndex, void* uboData, VkDeviceSize uboSize)
+{
+    m_UniformBuffers[imageIndex]->Upload(uboData, uboSize);
+}
+
+void FrameUniforms::CreateSetLayout(bool hasInstanceBuffer)
+{
+    const std::array<VkDescriptorSetLayoutBinding, 2> layoutBindings{
+        VkDescriptorSetLayoutBinding{ .binding = 0,
+                                     .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                                     .descriptorCount = 1,
+                                     .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                                     .pImmutableSamplers = nullptr },
+
+        // Per instance data
+        VkDescriptorSetLayoutBinding{ .binding = 1,
+                                     .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                     .descriptorCount = 1,
+                                     .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+                                     .pImmutableSamplers = nullptr },
+    };
+
+    const std::vector<VkDescriptorSetLayoutBinding> bindings(layoutBindings.begin(),
+                                                             layoutBindings.begin() + (hasInstanceBuffer ? 2 : 1));
+
+    m_SetLayout = VulkanGlobals::GetDescriptorAllocator().GetLayout(bindings);
+}
+
+void FrameUniforms::CreateUniformBuffers(int frameCount, VkDeviceSize uboSize)
+{
+    m_UniformBuffers.reserve(frameCount);
+
+    for(size_t i = 0; i < frameCount; i++)
+    {
+        m_UniformBuffers.emplace_back(
+            std::make_unique<Buffer>(uboSize,
+                                     VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+
+        m_UniformBuffers[i]->Map(uboSize);
+    }
+}
+
+void FrameUniforms::CreateDescriptorSets(VkBuffer instanceBuffer)
+{
+    DescriptorAllocator& descriptorAllocator = VulkanGlobals::GetDescriptorAllocator();
+
+    m_DescriptorSets.reserve(m_UniformBuffers.size());
+    for(auto&& uniformBuffer : m_UniformBuffers)
+    {
+        // Every frame reads the same instance buffer, the second info is unused without one
+        const std::array<VkDescriptorBufferInfo, 2> bufferInfos{
+            VkDescriptorBufferInfo{ *uniformBuffer, 0, VK_WHOLE_SIZE },
+            VkDescriptorBufferInfo{ instanceBuffer, 0, VK_WHOLE_SIZE },
+        };
+
+        const VkDescriptorSet descriptorSet = descriptorAllocator.Allocate(m_SetLayout);
+        descriptorAllocator.Write(descriptorSet, m_SetLayout, bufferInfos.data());
+        m_DescriptorSets.push_back(descriptorSet);
+    }
+}
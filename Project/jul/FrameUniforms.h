@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <memory>
+#include <vector>
+
+#include "Buffer.h"
+
+// A uniform buffer per frame and the set 0 descriptor sets that point to it, binding 1 is the instance buffer if any
+//
+// Kept apart from Pipeline, so pipelines with the same state are shared while every user has its own uniforms
+class FrameUniforms final
+{
+public:
+    FrameUniforms(VkDeviceSize uboSize, VkBuffer instanceBuffer = VK_NULL_HANDLE);
+    ~FrameUniforms() = default;
+
+    FrameUniforms(FrameUniforms&&) = delete;
+    FrameUniforms(const FrameUniforms&) = delete;
+    FrameUniforms& operator=(FrameUniforms&&) = delete;
+    FrameUniforms& operator=(const FrameUniforms&) = delete;
+
+    void Update(int imageIndex, void* uboData, VkDeviceSize uboSize);
+
+    [[nodiscard]] VkDescriptorSet GetDescriptorSet(int imageIndex) const { return m_DescriptorSets[imageIndex]; }
+
+    // Owned by the descriptor allocator, uniforms with and without an instance buffer use a different layout
+    [[nodiscard]] VkDescriptorSetLayout GetSetLayout() const { return m_SetLayout; }
+
+private:
+    void CreateSetLayout(bool hasInstanceBuffer);
+    void CreateUniformBuffers(int frameCount, VkDeviceSize uboSize);
+    void CreateDescriptorSets(VkBuffer instanceBuffer);
+
+    VkDescriptorSetLayout m_SetLayout{};
+
+    std::vector<std::unique_ptr<Buffer>> m_UniformBuffers{};
+    std::vector<VkDescriptorSet> m_DescriptorSets{};
+};
@@ -0,0 +1,174 @@
+#include "FrustumCuller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/geometric.hpp>
+
+#include "jul/CpuProfiler.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define JUL_CULL_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define JUL_CULL_SSE 1
+#endif
+
+std::array<glm::vec4, 6> FrustumCuller::ExtractPlanes(const glm::mat4& viewProjection)
+{
+    // Gribb and Hartmann, glm matrices are column major
+    const glm::vec4 row0{ viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0] };
+    const glm::vec4 row1{ viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1] };
+    const glm::vec4 row2{ viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2] };
+    const glm::vec4 row3{ viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3] };
+
+    // The near plane assumes a -1 to 1 depth range, for a 0 to 1 projection it is slightly conservative
+    std::array<glm::vec4, 6> planes{
+        row3 + row0,  // Left
+        row3 - row0,  // Right
+        row3 + row1,  // Bottom
+        row3 - row1,  // Top
+        row3 + row2,  // Near
+        row3 - row2,  // Far
+    };
+
+    for(glm::vec4& plane : planes)
+        plane /= glm::length(glm::vec3{ plane });
+
+    return planes;
+}
+
+void FrustumCuller::Clear()
+{
+    m_Count = 0;
+    m_VisibleCount = 0;
+
+    m_CenterX.clear();
+    m_CenterY.clear();
+    m_CenterZ.clear();
+    m_ExtentX.clear();
+    m_ExtentY.clear();
+    m_ExtentZ.clear();
+    m_Radius.clear();
+}
+
+uint32_t FrustumCuller::Add(const Bounds& worldBounds)
+{
+    m_CenterX.push_back(worldBounds.center.x);
+    m_CenterY.push_back(worldBounds.center.y);
+    m_CenterZ.push_back(worldBounds.center.z);
+    m_ExtentX.push_back(worldBounds.extents.x);
+    m_ExtentY.push_back(worldBounds.extents.y);
+    m_ExtentZ.push_back(worldBounds.extents.z);
+    m_Radius.push_back(worldBounds.radius);
+
+    return m_Count++;
+}
+
+void FrustumCuller::Cull(const glm::mat4& viewProjection)
+{
+    JUL_PROFILE_ZONE("FrustumCuller::Cull");
+
+    const std::array<glm::vec4, 6> planes = ExtractPlanes(viewProjection);
+
+    // Pad to whole lanes, the padding results are never read
+    const uint32_t paddedCount = (m_Count + LANE_COUNT - 1) / LANE_COUNT * LANE_COUNT;
+    for(std::vector<float>* component :
+        { &m_CenterX, &m_CenterY, &m_CenterZ, &m_ExtentX, &m_ExtentY, &m_ExtentZ, &m_Radius })
+        component->resize(paddedCount);
+
+    m_Visible.resize(paddedCount);
+
+    for(uint32_t begin = 0; begin < paddedCount; begin += LANE_COUNT)
+        CullLanes(planes, begin);
+
+    m_VisibleCount = static_cast<uint32_t>(std::count(m_Visible.begin(), m_Visible.begin() + m_Count, uint8_t{ 1 }));
+}
+
+// Per plane the box and sphere give their own projected radius, the smaller one is the tighter test
+// Infinite bounds make the box radius NaN, the min then falls back to the infinite sphere radius
+void FrustumCuller::CullLanes(const std::array<glm::vec4, 6>& planes, uint32_t begin)
+{
+#if JUL_CULL_AVX
+    const __m256 centerX = _mm256_loadu_ps(&m_CenterX[begin]);
+    const __m256 centerY = _mm256_loadu_ps(&m_CenterY[begin]);
+    const __m256 centerZ = _mm256_loadu_ps(&m_CenterZ[begin]);
+    const __m256 extentX = _mm256_loadu_ps(&m_ExtentX[begin]);
+    const __m256 extentY = _mm256_loadu_ps(&m_ExtentY[begin]);
+    const __m256 extentZ = _mm256_loadu_ps(&m_ExtentZ[begin]);
+    const __m256 radius = _mm256_loadu_ps(&m_Radius[begin]);
+
+    __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+    for(const glm::vec4& plane : planes)
+    {
+        const __m256 distance =
+            _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(centerX, _mm256_set1_ps(plane.x)),
+                                        _mm256_mul_ps(centerY, _mm256_set1_ps(plane.y))),
+                          _mm256_add_ps(_mm256_mul_ps(centerZ, _mm256_set1_ps(plane.z)), _mm256_set1_ps(plane.w)));
+
+        const __m256 boxRadius =
+            _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(extentX, _mm256_set1_ps(std::abs(plane.x))),
+                                        _mm256_mul_ps(extentY, _mm256_set1_ps(std::abs(plane.y)))),
+                          _mm256_mul_ps(extentZ, _mm256_set1_ps(std::abs(plane.z))));
+
+        const __m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_min_ps(boxRadius, radius));
+        visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+    }
+
+    const int mask = _mm256_movemask_ps(visible);
+    for(uint32_t lane = 0; lane < LANE_COUNT; ++lane)
+        m_Visible[begin + lane] = static_cast<uint8_t>((mask >> lane) & 1);
+
+#elif JUL_CULL_SSE
+    for(uint32_t half = begin; half < begin + LANE_COUNT; half += 4)
+    {
+        const __m128 centerX = _mm_loadu_ps(&m_CenterX[half]);
+        const __m128 centerY = _mm_loadu_ps(&m_CenterY[half]);
+        const __m128 centerZ = _mm_loadu_ps(&m_CenterZ[half]);
+        const __m128 extentX = _mm_loadu_ps(&m_ExtentX[half]);
+        const __m128 extentY = _mm_loadu_ps(&m_ExtentY[half]);
+        const __m128 extentZ = _mm_loadu_ps(&m_ExtentZ[half]);
+        const __m128 radius = _mm_loadu_ps(&m_Radius[half]);
+
+        __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+        for(const glm::vec4& plane : planes)
+        {
+            const __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(plane.x)), _mm_mul_ps(centerY, _mm_set1_ps(plane.y))),
+                _mm_add_ps(_mm_mul_ps(centerZ, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+
+            const __m128 boxRadius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(extentX, _mm_set1_ps(std::abs(plane.x))),
+                                                           _mm_mul_ps(extentY, _mm_set1_ps(std::abs(plane.y)))),
+                                                _mm_mul_ps(extentZ, _mm_set1_ps(std::abs(plane.z))));
+
+            const __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_min_ps(boxRadius, radius));
+            visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, negativeRadius));
+        }
+
+        const int mask = _mm_movemask_ps(visible);
+        for(uint32_t lane = 0; lane < 4; ++lane)
+            m_Visible[half + lane] = static_cast<uint8_t>((mask >> lane) & 1);
+    }
+
+#else
+    for(uint32_t index = begin; index < begin + LANE_COUNT; ++index)
+    {
+        bool visible = true;
+
+        for(const glm::vec4& plane : planes)
+        {
+            const float distance =
+                m_CenterX[index] * plane.x + m_CenterY[index] * plane.y + m_CenterZ[index] * plane.z + plane.w;
+
+            const float boxRadius = m_ExtentX[index] * std::abs(plane.x) + m_ExtentY[index] * std::abs(plane.y) +
+                                    m_ExtentZ[index] * std::abs(plane.z);
+
+            visible = visible and distance >= -std::min(m_Radius[index], boxRadius);
+        }
+
+        m_Visible[index] = static_cast<uint8_t>(visible);
+    }
+#endif
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+#include <vector>
+
+#include "Bounds.h"
+
+// Culls world space bounds against the view frustum
+// Bounds are stored SoA so one SIMD register holds the same component of 8 (AVX) or 4 (SSE) bounds
+class FrustumCuller final
+{
+public:
+    // Normalized planes pointing into the frustum, xyz is the normal and w the distance
+    [[nodiscard]] static std::array<glm::vec4, 6> ExtractPlanes(const glm::mat4& viewProjection);
+
+    void Clear();
+
+    // Returns the index to look the result up with
+    uint32_t Add(const Bounds& worldBounds);
+
+    void Cull(const glm::mat4& viewProjection);
+
+    [[nodiscard]] bool IsVisible(uint32_t index) const { return m_Visible[index] != 0; }
+
+    [[nodiscard]] uint32_t GetVisibleCount() const { return m_VisibleCount; }
+    [[nodiscard]] uint32_t GetCulledCount() const { return m_Count - m_VisibleCount; }
+
+    inline static constexpr uint32_t LANE_COUNT{ 8 };
+
+private:
+    void CullLanes(const std::array<glm::vec4, 6>& planes, uint32_t begin);
+
+    std::vector<float> m_CenterX{};
+    std::vector<float> m_CenterY{};
+    std::vector<float> m_CenterZ{};
+    std::vector<float> m_ExtentX{};
+    std::vector<float> m_ExtentY{};
+    std::vector<float> m_ExtentZ{};
+    std::vector<float> m_Radius{};
+
+    std::vector<uint8_t> m_Visible{};
+
+    uint32_t m_Count{};
+    uint32_t m_VisibleCount{};
+};
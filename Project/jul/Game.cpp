@@ -1,11 +1,18 @@
 #include "Game.h"
 
+#include <array>
+#include <chrono>
 #include <iostream>
 
+#include "jul/CpuProfiler.h"
 #include "jul/GameTime.h"
+#include "jul/GpuProfiler.h"
+#include "jul/Input.h"
 #include "jul/MathExtensions.h"
+#include "jul/PipelineCache.h"
 #include "jul/SwapChain.h"
 #include "jul/Texture.h"
+#include "jul/TextureLoader.h"
 
 #define GLM_FORCE_RADIANS
 #include <tiny_obj_loader.h>
@@ -17,67 +24,124 @@
 
 Game::Game()
 {
-    m_Textures["Grass"] = std::make_unique<Texture>("resources/Diorama/T_Grass_Color.png");
-    m_Textures["Car"] = std::make_unique<Texture>("resources/Diorama/T_FordGT40_Color.png");
-    m_Textures["Konker"] = std::make_unique<Texture>("resources/Diorama/T_Konker_Color.png");
-    m_Textures["Clothing"] = std::make_unique<Texture>("resources/Diorama/T_Clothing_Color.png");
-
-    m_Textures["defaultBlack"] = std::make_unique<Texture>("resources/Default/defaultBlack.png");
-    m_Textures["defaultNormal"] = std::make_unique<Texture>("resources/Default/defaultNormal.png");
-    m_Textures["defaultWhite"] = std::make_unique<Texture>("resources/Default/defaultWhite.png");
-    m_Textures["uv_grid"] = std::make_unique<Texture>("resources/Default/uv_grid.png");
-    m_Textures["uv_grid_2"] = std::make_unique<Texture>("resources/Default/uv_grid_2.png");
-    m_Textures["uv_grid_3"] = std::make_unique<Texture>("resources/Default/uv_grid_3.png");
-
-    m_Textures["subaru_Outside_BaseColor"] = std::make_unique<Texture>("resources/Car/subaru_Outside_BaseColor.png");
-    m_Textures["subaru_Outside_Normal"] = std::make_unique<Texture>("resources/Car/subaru_Outside_Normal.png");
-    m_Textures["subaru_Outside_Metallic"] = std::make_unique<Texture>("resources/Car/subaru_Outside_Metallic.png");
-    m_Textures["subaru_Outside_Roughness"] = std::make_unique<Texture>("resources/Car/subaru_Outside_Roughness.png");
-
-    m_Textures["fire_BaseColor"] = std::make_unique<Texture>("resources/FireHydrant/fire_hydrant_Base_Color.png");
-    m_Textures["fire_Normal"] = std::make_unique<Texture>("resources/FireHydrant/fire_hydrant_Normal_OpenGL.png");
-    m_Textures["fire_Metallic"] = std::make_unique<Texture>("resources/FireHydrant/fire_hydrant_Metallic.png");
-    m_Textures["fire_Roughness"] = std::make_unique<Texture>("resources/FireHydrant/fire_hydrant_Roughness.png");
-
-
-    m_Materials["test"] =
-        std::make_unique<Material>(std::vector<const Texture*>{ m_Textures["subaru_Outside_BaseColor"].get(),
-                                                                m_Textures["subaru_Outside_Normal"].get(),
-                                                                m_Textures["subaru_Outside_Metallic"].get(),
-                                                                m_Textures["subaru_Outside_Roughness"].get() });
-
-    m_Materials["subaru"] =
-        std::make_unique<Material>(std::vector<const Texture*>{ m_Textures["subaru_Outside_BaseColor"].get(),
-                                                                m_Textures["subaru_Outside_Normal"].get(),
-                                                                m_Textures["subaru_Outside_Metallic"].get(),
-                                                                m_Textures["subaru_Outside_Roughness"].get() });
-
-    m_Materials["grid"] = std::make_unique<Material>(std::vector<const Texture*>{ m_Textures["uv_grid_3"].get(),
-                                                                                  m_Textures["defaultNormal"].get(),
-                                                                                  m_Textures["defaultBlack"].get(),
-                                                                                  m_Textures["uv_grid"].get() });
-
-
-    m_Materials["fire"] = std::make_unique<Material>(std::vector<const Texture*>{ m_Textures["fire_BaseColor"].get(),
-                                                                                  m_Textures["fire_Normal"].get(),
-                                                                                  m_Textures["fire_Metallic"].get(),
-                                                                                  m_Textures["fire_Roughness"].get() });
-
-    m_Pipline2D = std::make_unique<Pipeline>(Shader{ "shaders/shader2D.vert.spv", "shaders/shader2D.frag.spv" },
-                                             Shader::CreateVertexInputStateInfo<Mesh::Vertex2D>(),
-                                             sizeof(UniformBufferObject2D),
-                                             sizeof(MeshPushConstants),
-                                             std::nullopt,
-                                             VK_CULL_MODE_NONE,
-                                             VK_FALSE,
-                                             VK_FALSE);
-
-    m_Pipline3D = std::make_unique<Pipeline>(Shader{ "shaders/shader3D.vert.spv", "shaders/shader3D.frag.spv" },
-                                             Shader::CreateVertexInputStateInfo<Mesh::Vertex3D>(),
-                                             sizeof(UniformBufferObject3D),
-                                             sizeof(MeshPushConstants),
-                                             Material::GetMaterialSetLayout(),
-                                             VK_CULL_MODE_NONE);
+    m_GeometryBuffer3D = std::make_unique<GeometryBuffer>(sizeof(Mesh::Vertex3D), 1 << 18, 1 << 20);
+    m_InstanceBuffer3D = std::make_unique<InstanceBuffer>(4'096, 16'384);
+
+    m_FrameUniforms2D = std::make_unique<FrameUniforms>(sizeof(UniformBufferObject2D));
+    m_FrameUniforms3D = std::make_unique<FrameUniforms>(sizeof(UniformBufferObject3D), m_InstanceBuffer3D->GetBuffer());
+
+    // Pipelines build on the thread pool while textures and meshes load, the first Bind waits for them
+    m_Pipline2D = std::make_unique<Pipeline>(
+        PipelineDescription{
+            .vertexPath = "shaders/shader2D.vert.spv",
+            .fragmentPath = "shaders/shader2D.frag.spv",
+            .vertexInputState = Shader::CreateVertexInputStateInfo<Mesh::Vertex2D>(),
+            .pushConstantSize = sizeof(MeshPushConstants),
+            .fixedFunctionState = { .cullMode = VK_CULL_MODE_NONE,
+                                    .depthTestEnable = VK_FALSE,
+                                    .depthWriteEnable = VK_FALSE },
+        },
+        *m_FrameUniforms2D,
+        &m_ThreadPool);
+
+    // Bindless materials look their textures up in the shader instead of binding a set per material
+    const char* fragmentShader3D =
+        Material::IsBindless() ? "shaders/shader3DBindless.frag.spv" : "shaders/shader3D.frag.spv";
+
+    m_Pipline3D = std::make_unique<Pipeline>(
+        PipelineDescription{
+            .vertexPath = "shaders/shader3D.vert.spv",
+            .fragmentPath = fragmentShader3D,
+            .vertexInputState = Shader::CreateVertexInputStateInfo<Mesh::Vertex3D>(),
+            .materialSetLayout = Material::GetMaterialSetLayout(),
+            .fixedFunctionState = { .cullMode = VK_CULL_MODE_NONE },
+            .permutation = ShaderPermutation{},
+        },
+        *m_FrameUniforms3D,
+        &m_ThreadPool);
+
+    // Every image decodes on the thread pool, each upload is recorded when its decode finishes and submitted in batches
+    const auto textureLoadStart = std::chrono::steady_clock::now();
+    TextureLoader textureLoader{ m_ThreadPool };
+
+    // Normal maps hold directions and are sampled linear, the rest is sRGB color
+    using enum Texture::Usage;
+
+    textureLoader.Request("resources/Diorama/T_Grass_Color.png", Color, m_TextureNames["Grass"]);
+    textureLoader.Request("resources/Diorama/T_FordGT40_Color.png", Color, m_TextureNames["Car"]);
+    textureLoader.Request("resources/Diorama/T_Konker_Color.png", Color, m_TextureNames["Konker"]);
+    textureLoader.Request("resources/Diorama/T_Clothing_Color.png", Color, m_TextureNames["Clothing"]);
+
+    textureLoader.Request("resources/Default/defaultBlack.png", Color, m_TextureNames["defaultBlack"]);
+    textureLoader.Request("resources/Default/defaultNormal.png", Data, m_TextureNames["defaultNormal"]);
+    textureLoader.Request("resources/Default/defaultWhite.png", Color, m_TextureNames["defaultWhite"]);
+    textureLoader.Request("resources/Default/uv_grid.png", Color, m_TextureNames["uv_grid"]);
+    textureLoader.Request("resources/Default/uv_grid_2.png", Color, m_TextureNames["uv_grid_2"]);
+    textureLoader.Request("resources/Default/uv_grid_3.png", Color, m_TextureNames["uv_grid_3"]);
+
+    textureLoader.Request("resources/Car/subaru_Outside_BaseColor.png",
+                          Color,
+                          m_TextureNames["subaru_Outside_BaseColor"]);
+    textureLoader.Request("resources/Car/subaru_Outside_Normal.png", Data, m_TextureNames["subaru_Outside_Normal"]);
+    textureLoader.RequestOrm("",
+                             "resources/Car/subaru_Outside_Roughness.png",
+                             "resources/Car/subaru_Outside_Metallic.png",
+                             m_TextureNames["subaru_Outside_ORM"]);
+
+    textureLoader.Request("resources/FireHydrant/fire_hydrant_Base_Color.png", Color, m_TextureNames["fire_BaseColor"]);
+    textureLoader.Request("resources/FireHydrant/fire_hydrant_Normal_OpenGL.png", Data, m_TextureNames["fire_Normal"]);
+    textureLoader.RequestOrm("",
+                             "resources/FireHydrant/fire_hydrant_Roughness.png",
+                             "resources/FireHydrant/fire_hydrant_Metallic.png",
+                             m_TextureNames["fire_ORM"]);
+
+    // The grid has no metal and uses the grid pattern as roughness
+    textureLoader.RequestOrm("", "resources/Default/uv_grid.png", "", m_TextureNames["grid_ORM"]);
+
+    textureLoader.Finish(m_Textures);
+
+    const std::chrono::duration<double, std::milli> loadTime = std::chrono::steady_clock::now() - textureLoadStart;
+    std::cout << "Loaded " << m_Textures.GetCount() << " textures in " << loadTime.count() << " ms on "
+              << m_ThreadPool.GetThreadCount() << " threads" << std::endl;
+
+
+    m_MaterialNames["test"] =
+        m_Materials.Emplace(std::vector<const Texture*>{ FindTexture("subaru_Outside_BaseColor"),
+                                                         FindTexture("subaru_Outside_Normal"),
+                                                         FindTexture("subaru_Outside_ORM") });
+
+    m_MaterialNames["subaru"] =
+        m_Materials.Emplace(std::vector<const Texture*>{ FindTexture("subaru_Outside_BaseColor"),
+                                                         FindTexture("subaru_Outside_Normal"),
+                                                         FindTexture("subaru_Outside_ORM") });
+
+    m_MaterialNames["grid"] =
+        m_Materials.Emplace(std::vector<const Texture*>{ FindTexture("uv_grid_3"),
+                                                         FindTexture("defaultNormal"),
+                                                         FindTexture("grid_ORM") });
+
+
+    m_MaterialNames["fire"] =
+        m_Materials.Emplace(std::vector<const Texture*>{ FindTexture("fire_BaseColor"),
+                                                         FindTexture("fire_Normal"),
+                                                         FindTexture("fire_ORM") });
+
+    // Builds the variants materials need next to the base pipeline, the grid leaves out its flat normal map
+    for(auto&& material : m_Materials.GetValues())
+        m_Pipline3D->GetVariant(material.get());
+
+    // 2D is registered first so it is drawn before 3D
+    m_Pipeline2DId = m_RenderQueue.RegisterPipeline(m_Pipline2D.get(), "2D Pass");
+    m_Pipeline3DId =
+        m_RenderQueue.RegisterPipeline(m_Pipline3D.get(), "3D Pass", m_InstanceBuffer3D.get());
+
+    if(OcclusionCuller::IsSupported())
+    {
+        m_OcclusionCuller = std::make_unique<OcclusionCuller>();
+        m_RenderQueue.SetOcclusionCuller(m_OcclusionCuller.get());
+    }
+
+    m_UseCpuOcclusion = not m_OcclusionCuller;
 
 
     const std::vector<Mesh::Vertex2D> triangleVertices = {
@@ -89,13 +153,12 @@ Game::Game()
     const std::vector<uint32_t> triangleIndeces = { 0, 1, 2 };
 
 
-    AddMesh2D("Triable",
-              Mesh{
-                  triangleIndeces,
-                  Mesh::VertexData{.data = (void*)triangleVertices.data(),
-                                   .vertexCount = static_cast<uint32_t>(triangleVertices.size()),
-                                   .typeSize = sizeof(Mesh::Vertex2D)},
-                  nullptr
+    AddMesh2D(Mesh{
+        triangleIndeces,
+        Mesh::VertexData{.data = (void*)triangleVertices.data(),
+                         .vertexCount = static_cast<uint32_t>(triangleVertices.size()),
+                         .typeSize = sizeof(Mesh::Vertex2D)},
+        nullptr
     });
 
 
@@ -108,72 +171,213 @@ Game::Game()
 
     const std::vector<uint32_t> squareIndices = { 0, 1, 2, 0, 2, 3 };
 
-    AddMesh2D("Square",
-              Mesh{
-                  squareIndices,
-                  Mesh::VertexData{.data = (void*)squareVertices.data(),
-                                   .vertexCount = static_cast<uint32_t>(squareVertices.size()),
-                                   .typeSize = sizeof(Mesh::Vertex2D)},
-                  nullptr
+    AddMesh2D(Mesh{
+        squareIndices,
+        Mesh::VertexData{.data = (void*)squareVertices.data(),
+                         .vertexCount = static_cast<uint32_t>(squareVertices.size()),
+                         .typeSize = sizeof(Mesh::Vertex2D)},
+        nullptr
     });
 
-    AddMesh2D("Circle2D", GenerateCircle({ 0, 0 }, { 0.4f, 0.6f }));
-    AddMesh3D("Airplane", LoadMesh("resources/Airplane/Airplane.obj", m_Materials["grid"].get()));
-    AddMesh3D("Diorama", LoadMesh("resources/Diorama/DioramaGP.obj", m_Materials["grid"].get()));
+    AddMesh2D(GenerateCircle({ 0, 0 }, { 0.4f, 0.6f }));
+    const MeshHandle airplaneMesh = AddMesh3D(LoadMesh("resources/Airplane/Airplane.obj", FindMaterial("grid")));
+
+    // The path moves the plane while the plane itself only spins around its own axis
+    m_AirplanePathTransformId = m_Transforms.Add();
+    m_AirplaneTransformId =
+        m_Transforms.Add(m_AirplanePathTransformId, glm::vec3{ 0.0f }, glm::quat{ 1.0f, 0.0f, 0.0f, 0.0f }, glm::vec3{ 0.01f });
+
+    // The ground and walls of the diorama hide most of what is behind them
+    OcclusionRasterizer::OccluderMesh dioramaOccluder{};
+    const MeshHandle dioramaMesh =
+        AddMesh3D(LoadMesh("resources/Diorama/DioramaGP.obj", FindMaterial("grid"), &dioramaOccluder));
+    const uint32_t dioramaTransformId = m_Transforms.Add();
+    m_Occluders.push_back({ m_OcclusionRasterizer.AddOccluderMesh(std::move(dioramaOccluder)), dioramaMesh });
+
+
+    const MeshHandle carMesh = AddMesh3D(LoadMesh("resources/Car/Subaru.obj", FindMaterial("subaru")));
+    const uint32_t carTransformId = m_Transforms.Add(TransformSystem::NO_PARENT,
+                                                     glm::vec3(-6.89595, 4.0f, -0.306714),
+                                                     glm::angleAxis(glm::pi<float>(), glm::vec3(0.0f, 1.0f, 0.0f)),
+                                                     glm::vec3(0.01f, 0.01f, 0.01f));
 
 
-    auto& carMesh = AddMesh3D("Subaru", LoadMesh("resources/Car/Subaru.obj", m_Materials["subaru"].get()));
-    carMesh.m_ModelMatrix = translate(glm::mat4(1.0f), glm::vec3(-6.89595, 4.0f, -0.306714)) *
-                            rotate(glm::mat4(1.0f), glm::pi<float>(), glm::vec3(0.0f, 1.0f, 0.0f)) *
-                            scale(glm::mat4(1.0f), glm::vec3(0.01f, 0.01f, 0.01f));
+    const MeshHandle fireMeshHandle = AddMesh3D(LoadMesh("resources/FireHydrant/fire_hydrant.obj", FindMaterial("fire")));
+    const uint32_t fireTransformId = m_Transforms.Add(TransformSystem::NO_PARENT,
+                                                      glm::vec3(-8.07224, 3.65116, 2.53493),
+                                                      glm::quat{ 1.0f, 0.0f, 0.0f, 0.0f },
+                                                      glm::vec3(0.01f, 0.01f, 0.01f));
+
+    m_Transforms.Update();
+
+    // Scatter copies of the fire hydrant, all of them are drawn by a single instanced draw
+    Mesh& fireMesh = m_Meshes3D.At(fireMeshHandle);
+    constexpr int fireGridSize{ 8 };
+    fireMesh.EnableInstancing(*m_InstanceBuffer3D, fireGridSize * fireGridSize);
+
+    for(int x = 0; x < fireGridSize; ++x)
+    {
+        for(int z = 0; z < fireGridSize; ++z)
+        {
+            const glm::vec3 offset{ static_cast<float>(x) * 0.5f, 0.0f, static_cast<float>(z) * 0.5f };
+            const glm::vec4 tint{ 0.5f + 0.5f * static_cast<float>(x) / fireGridSize,
+                                  1.0f,
+                                  0.5f + 0.5f * static_cast<float>(z) / fireGridSize,
+                                  1.0f };
+
+            fireMesh.AddInstance(glm::translate(glm::mat4(1.0f), offset) * m_Transforms.GetWorldMatrix(fireTransformId),
+                                 tint);
+        }
+    }
+
+    m_SceneObjects = {
+        { "Airplane", airplaneMesh, m_AirplaneTransformId },
+        { "Diorama", dioramaMesh, dioramaTransformId },
+        { "Subaru", carMesh, carTransformId },
+        { "Fire", fireMeshHandle, fireTransformId },
+    };
+
+    // Everything but the airplane stays put, so the tree is built once and only refit after
+    std::vector<Bounds> sceneBounds{};
+    for(const SceneObject& sceneObject : m_SceneObjects)
+    {
+        Mesh& mesh = m_Meshes3D.At(sceneObject.meshHandle);
+        mesh.m_ModelMatrix = m_Transforms.GetWorldMatrix(sceneObject.transformId);
+        sceneBounds.push_back(mesh.GetWorldBounds());
+    }
 
+    m_SceneBvh.Build(sceneBounds);
+}
 
-    auto& fireMesh = AddMesh3D("Fire", LoadMesh("resources/FireHydrant/fire_hydrant.obj", m_Materials["fire"].get()));
-    fireMesh.m_ModelMatrix = translate(glm::mat4(1.0f), glm::vec3(-8.07224, 3.65116, 2.53493)) *
-                             scale(glm::mat4(1.0f), glm::vec3(0.01f, 0.01f, 0.01f));
+Game::~Game()
+{
+    // Pipeline builds on the workers finish before any member goes away, not only the ones declared before the pool
+    m_ThreadPool.WaitIdle();
 }
 
-Game::~Game() = default;
+Texture* Game::FindTexture(const std::string& name) const { return m_Textures.Get(m_TextureNames.at(name)); }
+
+Material* Game::FindMaterial(const std::string& name) const { return m_Materials.Get(m_MaterialNames.at(name)); }
 
 void Game::Update()
 {
+    JUL_PROFILE_ZONE("Game::Update");
     m_Camera.Update();
 
-    // Update plane position
-    const float planePosition = jul::math::ClampLoop(jul::GameTime::GetElapsedTimeF() * 50.0f, -100.0f, 100.0f);
-    m_Meshes3D["Airplane"]->m_ModelMatrix = glm::translate(glm::mat4(1.0f), { 0, 25, planePosition }) *
-                                            glm::scale(glm::mat4(1.0f), { 0.01f, 0.01f, 0.01f }) *
-                                            glm::rotate(glm::mat4(1.0f), jul::GameTime::GetElapsedTimeF(), { 0, 0, 1 });
-}
+    if(Input::GetKeyDown(GLFW_KEY_F1))
+    {
+        if(GpuProfiler::WriteJson("gpu_profile.json"))
+            std::cout << "GPU profile written to gpu_profile.json" << std::endl;
+    }
 
-void Game::Draw(VkCommandBuffer commandBuffer, int imageIndex)
-{
-    UniformBufferObject2D ubo2D{};
+    if(Input::GetKeyDown(GLFW_KEY_F2))
+        CpuProfiler::CaptureFrames(120, "cpu_trace.json");
+
+    if(Input::GetKeyDown(GLFW_KEY_F6))
     {
-        ubo2D.proj = m_Camera.GetOrthoProjectionMatrix();
+        PipelineCache::Save();
+        std::cout << "Pipeline cache saved" << std::endl;
+    }
+
+    if(Input::GetKeyDown(GLFW_KEY_F7))
+    {
+        constexpr auto debugViewCount = static_cast<uint32_t>(ShaderPermutation::DebugView::Count);
+        const uint32_t nextDebugView = (static_cast<uint32_t>(m_DebugView) + 1) % debugViewCount;
+        m_DebugView = static_cast<ShaderPermutation::DebugView>(nextDebugView);
+        m_Pipline3D->SetDebugView(m_DebugView);
+
+        constexpr std::array<const char*, debugViewCount> debugViewNames{ "off",      "base color", "normal",
+                                                                          "metallic", "roughness",  "occlusion" };
+        std::cout << "Debug view " << debugViewNames[static_cast<uint32_t>(m_DebugView)] << " ("
+                  << m_Pipline3D->GetVariantCount() << " 3D variants)" << std::endl;
     }
-    m_Pipline2D->Bind(commandBuffer, imageIndex);
-    m_Pipline2D->UpdateUBO(imageIndex, &ubo2D, sizeof(ubo2D));
 
-    for(auto&& mesh : m_Meshes2D)
+    if(Input::GetKeyDown(GLFW_KEY_F4))
     {
+        m_UseCpuOcclusion = not m_UseCpuOcclusion;
+        std::cout << "CPU occlusion culling " << (m_UseCpuOcclusion ? "on" : "off") << std::endl;
+    }
 
-        MeshPushConstants meshPushConstant{};
+    if(Input::GetKeyDown(GLFW_KEY_F3))
+    {
+        const RenderQueue::Stats& stats = m_RenderQueue.GetStats();
+        std::cout << "Draws: " << stats.drawCount << " (" << stats.instanceCount << " instances)\n"
+                  << "Draw calls: " << stats.drawCalls << " (" << stats.indirectCommands << " indirect commands)\n"
+                  << "Uploaded instances: " << stats.uploadedInstances << '\n'
+                  << "Frustum culled: " << m_SceneObjects.size() - m_VisibleObjectIds.size() << " of "
+                  << m_SceneObjects.size() << " (" << m_SceneBvh.GetNodeCount() << " BVH nodes)\n"
+                  << "CPU occlusion culled: " << m_CpuOcclusionCulledCount << '\n'
+                  << "Occlusion tested: " << (m_OcclusionCuller ? m_OcclusionCuller->GetObjectCount() : 0) << '\n'
+                  << "Pipeline binds: " << stats.naivePipelineBinds << " -> " << stats.pipelineBinds << '\n'
+                  << "Material binds: " << stats.naiveMaterialBinds << " -> " << stats.materialBinds << '\n'
+                  << "Mesh binds: " << stats.naiveMeshBinds << " -> " << stats.meshBinds << '\n';
+
+        // Issued and dropped by the command encoder
+        const CommandEncoder::Stats& encoderStats = m_RenderQueue.GetEncoderStats();
+        auto printCounter = [](const char* name, const CommandEncoder::Counter& counter)
         {
-            meshPushConstant.model = mesh.second->m_ModelMatrix;
-        }
-        m_Pipline2D->UpdatePushConstant(commandBuffer, &meshPushConstant, sizeof(meshPushConstant));
+            std::cout << name << ": " << counter.issued << " (" << counter.dropped << " dropped)\n";
+        };
+
+        printCounter("Encoder pipelines", encoderStats.pipelines);
+        printCounter("Encoder descriptor sets", encoderStats.descriptorSets);
+        printCounter("Encoder vertex buffers", encoderStats.vertexBuffers);
+        printCounter("Encoder index buffers", encoderStats.indexBuffers);
+        printCounter("Encoder push constants", encoderStats.pushConstants);
+        printCounter("Encoder dynamic state", encoderStats.dynamicState);
+        printCounter("Encoder fixed function state", encoderStats.fixedFunctionState);
+
+        // Stays flat as materials are added, only new permutations add pipelines
+        const PipelineStateCache& pipelineStateCache = VulkanGlobals::GetPipelineStateCache();
+        std::cout << "Pipelines: " << pipelineStateCache.GetPipelineCount() << " for "
+                  << pipelineStateCache.GetRequestCount() << " requests ("
+                  << pipelineStateCache.GetLayoutCount() << " layouts)\n";
+        std::cout << std::flush;
+    }
 
+    // Update plane position
+    const float planePosition = jul::math::ClampLoop(jul::GameTime::GetElapsedTimeF() * 50.0f, -100.0f, 100.0f);
+    m_Transforms.SetPosition(m_AirplanePathTransformId, { 0, 25, planePosition });
+    m_Transforms.SetRotation(m_AirplaneTransformId, glm::angleAxis(jul::GameTime::GetElapsedTimeF(), glm::vec3{ 0, 0, 1 }));
+    m_Transforms.Update();
 
-        // Update Material
-        Material* material = mesh.second->GetMaterial();
-        if(material != nullptr)
-            m_Pipline2D->UpdateMaterial(commandBuffer, *material);
+    // Only meshes that moved are written back and refit in the scene BVH
+    for(uint32_t objectId = 0; objectId < m_SceneObjects.size(); ++objectId)
+    {
+        const SceneObject& sceneObject = m_SceneObjects[objectId];
+        if(not m_Transforms.WasUpdated(sceneObject.transformId))
+            continue;
 
-        // Draw mesh
-        mesh.second->Draw(commandBuffer);
+        Mesh& mesh = m_Meshes3D.At(sceneObject.meshHandle);
+        mesh.m_ModelMatrix = m_Transforms.GetWorldMatrix(sceneObject.transformId);
+        m_SceneBvh.SetBounds(objectId, mesh.GetWorldBounds());
     }
 
+    m_SceneBvh.Refit();
+
+    // Picks the mesh in the middle of the screen
+    if(Input::GetKeyDown(GLFW_KEY_F5))
+    {
+        const std::optional<Bvh::RayHit> hit = m_SceneBvh.QueryRay({ .origin = m_Camera.GetPosition(),
+                                                                     .direction = m_Camera.GetForward(),
+                                                                     .maxDistance = m_Camera.GetFarClipping() });
+        if(hit.has_value())
+            std::cout << "Picked " << m_SceneObjects[hit->objectId].name << " at " << hit->distance << std::endl;
+        else
+            std::cout << "Picked nothing" << std::endl;
+    }
+}
+
+void Game::PrepareDraw(VkCommandBuffer commandBuffer, int imageIndex)
+{
+    JUL_PROFILE_ZONE("Game::PrepareDraw");
+
+    UniformBufferObject2D ubo2D{};
+    {
+        ubo2D.proj = m_Camera.GetOrthoProjectionMatrix();
+    }
+    m_FrameUniforms2D->Update(imageIndex, &ubo2D, sizeof(ubo2D));
+
     UniformBufferObject3D ubo3D{};
     {
         auto projectionMatrix = m_Camera.GetProjectionMatrix();
@@ -182,27 +386,69 @@ void Game::Draw(VkCommandBuffer commandBuffer, int imageIndex)
         ubo3D.viewProjection = projectionMatrix * m_Camera.GetViewMatrix();
         ubo3D.viewPosition = glm::vec4(m_Camera.GetPosition(), 1.0f);
     }
+    m_FrameUniforms3D->Update(imageIndex, &ubo3D, sizeof(ubo3D));
 
-    m_Pipline3D->Bind(commandBuffer, imageIndex);
-    m_Pipline3D->UpdateUBO(imageIndex, &ubo3D, sizeof(ubo3D));
+    m_RenderQueue.Clear();
 
-    for(auto&& mesh : m_Meshes3D)
+    for(auto&& mesh : m_Meshes2D.GetValues())
+        m_RenderQueue.Add(m_Pipeline2DId, mesh.get(), mesh->m_ModelMatrix, 0.0f);
+
+    const glm::mat4 cullViewProjection = m_Camera.GetProjectionMatrix() * m_Camera.GetViewMatrix();
+    m_VisibleObjectIds.clear();
+    m_SceneBvh.QueryFrustum(cullViewProjection, m_FrustumCuller, m_VisibleObjectIds);
+
+    m_CpuOcclusionCulledCount = 0;
+    if(m_UseCpuOcclusion)
     {
-        MeshPushConstants meshPushConstant{};
+        m_OcclusionRasterizer.Clear(cullViewProjection);
+        for(const Occluder& occluder : m_Occluders)
+            m_OcclusionRasterizer.AddOccluder(occluder.occluderMeshId, m_Meshes3D.At(occluder.meshHandle).m_ModelMatrix);
+
+        m_OcclusionRasterizer.Rasterize();
+    }
+
+    for(const uint32_t objectId : m_VisibleObjectIds)
+    {
+        Mesh* meshPtr = &m_Meshes3D.At(m_SceneObjects[objectId].meshHandle);
+
+        if(m_UseCpuOcclusion and not m_OcclusionRasterizer.IsVisible(m_SceneBvh.GetBounds(objectId)))
         {
-            meshPushConstant.model = mesh.second->m_ModelMatrix;
+            ++m_CpuOcclusionCulledCount;
+            continue;
         }
-        m_Pipline3D->UpdatePushConstant(commandBuffer, &meshPushConstant, sizeof(meshPushConstant));
-
 
-        // Update Material
-        Material* material = mesh.second->GetMaterial();
-        if(material != nullptr)
-            m_Pipline3D->UpdateMaterial(commandBuffer, *material);
+        const glm::vec3 meshPosition = meshPtr->m_ModelMatrix[3];
+        const float depth = glm::distance(meshPosition, m_Camera.GetPosition()) / m_Camera.GetFarClipping();
 
-        // Draw mesh
-        mesh.second->Draw(commandBuffer);
+        if(meshPtr->IsInstanced())
+            m_RenderQueue.AddInstanced(m_Pipeline3DId, meshPtr, depth);
+        else
+            m_RenderQueue.Add(m_Pipeline3DId, meshPtr, meshPtr->m_ModelMatrix, depth);
     }
+
+    m_RenderQueue.Sort();
+    m_RenderQueue.Prepare(commandBuffer, imageIndex);
+
+    if(m_OcclusionCuller)
+        m_OcclusionCuller->CullEarly(commandBuffer, imageIndex, ubo3D.viewProjection);
+}
+
+void Game::Draw(VkCommandBuffer commandBuffer, int imageIndex)
+{
+    JUL_PROFILE_ZONE("Game::Draw");
+    m_RenderQueue.Submit(commandBuffer, imageIndex, OcclusionCuller::Phase::Early);
+}
+
+void Game::CullOcclusion(VkCommandBuffer commandBuffer, int imageIndex)
+{
+    if(m_OcclusionCuller)
+        m_OcclusionCuller->CullLate(commandBuffer, imageIndex);
+}
+
+void Game::DrawLate(VkCommandBuffer commandBuffer, int imageIndex)
+{
+    JUL_PROFILE_ZONE("Game::DrawLate");
+    m_RenderQueue.Submit(commandBuffer, imageIndex, OcclusionCuller::Phase::Late);
 }
 
 void Game::OnResize() { m_Camera.SetAspect(VulkanGlobals::GetSwapChain().GetAspect()); }
@@ -238,8 +484,9 @@ void ComputeTangents(std::vector<Mesh::Vertex3D>& vertices, const std::vector<ui
     }
 }
 
-Mesh Game::LoadMesh(const std::string& meshPath, Material* material)
+Mesh Game::LoadMesh(const std::string& meshPath, Material* material, OcclusionRasterizer::OccluderMesh* occluderMesh)
 {
+    JUL_PROFILE_ZONE("Game::LoadMesh");
     tinyobj::attrib_t attrib;
     std::vector<tinyobj::shape_t> shapes;
     std::vector<tinyobj::material_t> materials;
@@ -290,13 +537,26 @@ Mesh Game::LoadMesh(const std::string& meshPath, Material* material)
 
     ComputeTangents(vertices, indices);
 
-    return Mesh{
+    if(occluderMesh != nullptr)
+    {
+        occluderMesh->positions.reserve(vertices.size());
+        for(const Mesh::Vertex3D& vertex : vertices)
+            occluderMesh->positions.push_back(vertex.position);
+
+        occluderMesh->indices = indices;
+    }
+
+    Mesh mesh{
         indices,
         Mesh::VertexData{.data = (void*)vertices.data(),
                          .vertexCount = static_cast<uint32_t>(vertices.size()),
                          .typeSize = sizeof(Mesh::Vertex3D)},
-        material
+        material,
+        *m_GeometryBuffer3D
     };
+
+    mesh.SetBounds(Bounds::FromVertices(vertices));
+    return mesh;
 }
 
 Mesh Game::GenerateCircle(glm::vec2 center, glm::vec2 size, uint32_t segmentCount)
@@ -1,9 +1,20 @@
 #pragma once
 #include <vulkan/vulkan_core.h>
 
+#include "Bvh.h"
 #include "Camera.h"
+#include "FrameUniforms.h"
+#include "FrustumCuller.h"
+#include "GeometryBuffer.h"
+#include "InstanceBuffer.h"
 #include "Mesh.h"
+#include "OcclusionCuller.h"
+#include "OcclusionRasterizer.h"
 #include "Pipeline.h"
+#include "RenderQueue.h"
+#include "SlotMap.h"
+#include "ThreadPool.h"
+#include "TransformSystem.h"
 
 class Game final
 {
@@ -31,34 +42,87 @@ public:
     ~Game();
 
     void Update();
+
+    // Recorded before the render pass begins
+    void PrepareDraw(VkCommandBuffer commandBuffer, int imageIndex);
+    // Draws what was visible last frame, everything when there is no occlusion culling
     void Draw(VkCommandBuffer commandBuffer, int imageIndex);
+    // Recorded between the render passes
+    void CullOcclusion(VkCommandBuffer commandBuffer, int imageIndex);
+    // Draws what the early pass missed
+    void DrawLate(VkCommandBuffer commandBuffer, int imageIndex);
     void OnResize();
 
 private:
-    Mesh& AddMesh3D(const std::string& name, Mesh&& mesh)
-    {
-        return *(m_Meshes3D[name] = std::make_unique<Mesh>(std::move(mesh)));
-    }
+    MeshHandle AddMesh3D(Mesh&& mesh) { return m_Meshes3D.Emplace(std::move(mesh)); }
+    MeshHandle AddMesh2D(Mesh&& mesh) { return m_Meshes2D.Emplace(std::move(mesh)); }
 
-    Mesh& AddMesh2D(const std::string& name, Mesh&& mesh)
-    {
-        return *(m_Meshes2D[name] = std::make_unique<Mesh>(std::move(mesh)));
-    }
+    // Names are only looked up while loading, everything after that uses handles
+    [[nodiscard]] Texture* FindTexture(const std::string& name) const;
+    [[nodiscard]] Material* FindMaterial(const std::string& name) const;
 
-    Mesh LoadMesh(const std::string& meshPath, Material* material);
+    // Also fills occluderMesh with the positions and indices when given
+    Mesh LoadMesh(const std::string& meshPath, Material* material,
+                  OcclusionRasterizer::OccluderMesh* occluderMesh = nullptr);
     Mesh GenerateCircle(glm::vec2 center, glm::vec2 size = { 1, 1 }, uint32_t segmentSize = 64);
 
+    std::unique_ptr<FrameUniforms> m_FrameUniforms2D{};
+    std::unique_ptr<FrameUniforms> m_FrameUniforms3D{};
     std::unique_ptr<Pipeline> m_Pipline2D{};
     std::unique_ptr<Pipeline> m_Pipline3D{};
 
+    // Every 3D mesh lives in here so the 3D pass can be drawn indirectly
+    std::unique_ptr<GeometryBuffer> m_GeometryBuffer3D{};
+    std::unique_ptr<InstanceBuffer> m_InstanceBuffer3D{};
+    // Null when the device can't draw the culled commands
+    std::unique_ptr<OcclusionCuller> m_OcclusionCuller{};
+
+    ThreadPool m_ThreadPool{};
+    RenderQueue m_RenderQueue{};
+
+    struct SceneObject
+    {
+        std::string name;
+        MeshHandle meshHandle;
+        uint32_t transformId;
+    };
+
+    // Every 3D mesh, the index is the object id in the scene BVH
+    std::vector<SceneObject> m_SceneObjects{};
+    Bvh m_SceneBvh{};
+    std::vector<uint32_t> m_VisibleObjectIds{};
+    FrustumCuller m_FrustumCuller{};
+
+    TransformSystem m_Transforms{};
+    uint32_t m_AirplanePathTransformId{};
+    uint32_t m_AirplaneTransformId{};
+
+    struct Occluder
+    {
+        uint32_t occluderMeshId;
+        MeshHandle meshHandle;
+    };
+
+    // CPU occlusion culling, the fallback when the GPU culler is not supported
+    OcclusionRasterizer m_OcclusionRasterizer{ 256, 128, &m_ThreadPool };
+    std::vector<Occluder> m_Occluders{};
+    bool m_UseCpuOcclusion{};
+    uint32_t m_CpuOcclusionCulledCount{};
+    ShaderPermutation::DebugView m_DebugView{};
+    uint32_t m_Pipeline2DId{};
+    uint32_t m_Pipeline3DId{};
+
 
     Camera m_Camera{
         glm::vec3{0, 1, -2},
         80
     };
 
-    std::unordered_map<std::string, std::unique_ptr<Mesh>> m_Meshes2D{};
-    std::unordered_map<std::string, std::unique_ptr<Mesh>> m_Meshes3D{};
-    std::unordered_map<std::string, std::unique_ptr<Texture>> m_Textures;
-    std::unordered_map<std::string, std::unique_ptr<Material>> m_Materials;
+    SlotMap<Mesh> m_Meshes2D{};
+    SlotMap<Mesh> m_Meshes3D{};
+    SlotMap<Texture> m_Textures{};
+    SlotMap<Material> m_Materials{};
+
+    std::unordered_map<std::string, TextureHandle> m_TextureNames{};
+    std::unordered_map<std::string, MaterialHandle> m_MaterialNames{};
 };
@@ -0,0 +1,96 @@
+#include "GeometryBuffer.h"
+
+#include <algorithm>
+
+#include "CommandEncoder.h"
+#include "vulkanbase/VulkanUtil.h"
+
+GeometryBuffer::GeometryBuffer(uint32_t vertexStride, uint32_t vertexCapacity, uint32_t indexCapacity) :
+    m_VertexStride(vertexStride),
+    m_VertexCapacity(vertexCapacity),
+    m_IndexCapacity(indexCapacity)
+{
+    m_VertexBuffer = std::make_unique<Buffer>(
+        static_cast<VkDeviceSize>(m_VertexCapacity) * m_VertexStride, VERTEX_USAGE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    m_IndexBuffer = std::make_unique<Buffer>(
+        static_cast<VkDeviceSize>(m_IndexCapacity) * sizeof(uint32_t), INDEX_USAGE, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+}
+
+GeometryBuffer::Allocation GeometryBuffer::Add(const void* vertexData, uint32_t vertexCount,
+                                               const std::vector<uint32_t>& indices)
+{
+    const auto indexCount = static_cast<uint32_t>(indices.size());
+
+    if(m_VertexCount + vertexCount > m_VertexCapacity)
+    {
+        const uint32_t newCapacity = std::max(m_VertexCapacity * 2, m_VertexCount + vertexCount);
+        Grow(m_VertexBuffer,
+             VERTEX_USAGE,
+             static_cast<VkDeviceSize>(m_VertexCount) * m_VertexStride,
+             static_cast<VkDeviceSize>(newCapacity) * m_VertexStride);
+        m_VertexCapacity = newCapacity;
+    }
+
+    if(m_IndexCount + indexCount > m_IndexCapacity)
+    {
+        const uint32_t newCapacity = std::max(m_IndexCapacity * 2, m_IndexCount + indexCount);
+        Grow(m_IndexBuffer,
+             INDEX_USAGE,
+             static_cast<VkDeviceSize>(m_IndexCount) * sizeof(uint32_t),
+             static_cast<VkDeviceSize>(newCapacity) * sizeof(uint32_t));
+        m_IndexCapacity = newCapacity;
+    }
+
+    Upload(*m_VertexBuffer,
+           vertexData,
+           static_cast<VkDeviceSize>(vertexCount) * m_VertexStride,
+           static_cast<VkDeviceSize>(m_VertexCount) * m_VertexStride);
+
+    Upload(*m_IndexBuffer,
+           indices.data(),
+           static_cast<VkDeviceSize>(indexCount) * sizeof(uint32_t),
+           static_cast<VkDeviceSize>(m_IndexCount) * sizeof(uint32_t));
+
+    // Indices stay local to the mesh, the vertex offset is added by the draw
+    const Allocation allocation{
+        .firstIndex = m_IndexCount,
+        .indexCount = indexCount,
+        .vertexOffset = static_cast<int32_t>(m_VertexCount),
+    };
+
+    m_VertexCount += vertexCount;
+    m_IndexCount += indexCount;
+
+    return allocation;
+}
+
+void GeometryBuffer::Bind(CommandEncoder& encoder) const
+{
+    encoder.BindVertexBuffer(*m_VertexBuffer);
+    encoder.BindIndexBuffer(*m_IndexBuffer);
+}
+
+void GeometryBuffer::Grow(std::unique_ptr<Buffer>& buffer, VkBufferUsageFlags usage, VkDeviceSize usedSize,
+                          VkDeviceSize newSize)
+{
+    auto newBuffer = std::make_unique<Buffer>(newSize, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    if(usedSize > 0)
+        vulkanUtil::CopyBuffer(*buffer, *newBuffer, usedSize);
+
+    buffer = std::move(newBuffer);
+}
+
+void GeometryBuffer::Upload(Buffer& buffer, const void* data, VkDeviceSize size, VkDeviceSize offset)
+{
+    if(size == 0)
+        return;
+
+    Buffer stagingBuffer{ size,
+                          VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+
+    stagingBuffer.Upload(const_cast<void*>(data), static_cast<uint32_t>(size));
+    vulkanUtil::CopyBuffer(stagingBuffer, buffer, size, 0, offset);
+}
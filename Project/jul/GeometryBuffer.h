@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <memory>
+#include <vector>
+
+#include "Buffer.h"
+
+class CommandEncoder;
+
+// One vertex and index buffer shared by every mesh of the same vertex type
+// Meshes that share a geometry buffer can be drawn together by a single (multi) indirect draw
+class GeometryBuffer final
+{
+public:
+    struct Allocation
+    {
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        int32_t vertexOffset;
+    };
+
+    GeometryBuffer(uint32_t vertexStride, uint32_t vertexCapacity, uint32_t indexCapacity);
+
+    GeometryBuffer(GeometryBuffer&&) = delete;
+    GeometryBuffer(const GeometryBuffer&) = delete;
+    GeometryBuffer& operator=(GeometryBuffer&&) = delete;
+    GeometryBuffer& operator=(const GeometryBuffer&) = delete;
+
+    // Grows the buffers when they are full, only call while the GPU is not using them
+    [[nodiscard]] Allocation Add(const void* vertexData, uint32_t vertexCount, const std::vector<uint32_t>& indices);
+
+    void Bind(CommandEncoder& encoder) const;
+
+    [[nodiscard]] uint32_t GetVertexCount() const { return m_VertexCount; }
+    [[nodiscard]] uint32_t GetIndexCount() const { return m_IndexCount; }
+
+private:
+    static void Grow(std::unique_ptr<Buffer>& buffer, VkBufferUsageFlags usage, VkDeviceSize usedSize,
+                     VkDeviceSize newSize);
+
+    static void Upload(Buffer& buffer, const void* data, VkDeviceSize size, VkDeviceSize offset);
+
+    uint32_t m_VertexStride;
+
+    uint32_t m_VertexCount{};
+    uint32_t m_VertexCapacity;
+    uint32_t m_IndexCount{};
+    uint32_t m_IndexCapacity;
+
+    std::unique_ptr<Buffer> m_VertexBuffer;
+    std::unique_ptr<Buffer> m_IndexBuffer;
+
+    inline static constexpr VkBufferUsageFlags VERTEX_USAGE{ VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+                                                             VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                                             VK_BUFFER_USAGE_TRANSFER_DST_BIT };
+
+    inline static constexpr VkBufferUsageFlags INDEX_USAGE{ VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                                                            VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                                            VK_BUFFER_USAGE_TRANSFER_DST_BIT };
+};
@@ -0,0 +1,261 @@
+#include "GpuProfiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <string_view>
+
+#include "vulkanbase/VulkanGlobals.h"
+
+namespace
+{
+    // Zone names come from code and asset names, so they can hold anything a JSON string can't
+    void WriteJsonString(std::ostream& stream, std::string_view text)
+    {
+        stream << '"';
+        for(const char character : text)
+        {
+            if(character == '"' or character == '\\')
+            {
+                stream << '\\' << character;
+            }
+            else if(static_cast<unsigned char>(character) < 0x20)
+            {
+                char escaped[7]{};
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(character));
+                stream << escaped;
+            }
+            else
+            {
+                stream << character;
+            }
+        }
+        stream << '"';
+    }
+}  // namespace
+
+void GpuProfiler::Init(uint32_t queueFamilyIndex)
+{
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(VulkanGlobals::GetPhysicalDevice(), &properties);
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(VulkanGlobals::GetPhysicalDevice(), &queueFamilyCount, nullptr);
+
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(
+        VulkanGlobals::GetPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+
+    const uint32_t validBits = queueFamilies[queueFamilyIndex].timestampValidBits;
+    if(validBits == 0 or properties.limits.timestampPeriod <= 0.0f)
+    {
+        std::cerr << "GPU profiler disabled, timestamps are not supported on the graphics queue\n";
+        return;
+    }
+
+    s_TimestampPeriod = properties.limits.timestampPeriod;
+    s_TimestampMask = validBits >= 64 ? ~uint64_t{ 0 } : (uint64_t{ 1 } << validBits) - 1;
+
+    const VkQueryPoolCreateInfo queryPoolInfo{
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = MAX_QUERIES_PER_FRAME * FRAME_LATENCY,
+    };
+
+    if(vkCreateQueryPool(VulkanGlobals::GetDevice(), &queryPoolInfo, nullptr, &s_QueryPool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create timestamp query pool!");
+}
+
+void GpuProfiler::Cleanup()
+{
+    if(s_QueryPool != VK_NULL_HANDLE)
+        vkDestroyQueryPool(VulkanGlobals::GetDevice(), s_QueryPool, nullptr);
+
+    s_QueryPool = VK_NULL_HANDLE;
+}
+
+void GpuProfiler::BeginFrame(VkCommandBuffer commandBuffer)
+{
+    if(not IsSupported())
+        return;
+
+    const auto slotIndex = static_cast<uint32_t>(s_FrameIndex % FRAME_LATENCY);
+    FrameSlot& slot = s_FrameSlots[slotIndex];
+
+    // The slot was last used FRAME_LATENCY frames ago, so its results should be ready by now
+    if(slot.pendingResults)
+        ResolveSlot(slot, slotIndex);
+
+    slot.zones.clear();
+    slot.queryCount = 0;
+    s_OpenZones.clear();
+    s_CurrentSlotPtr = &slot;
+
+    vkCmdResetQueryPool(commandBuffer, s_QueryPool, slotIndex * MAX_QUERIES_PER_FRAME, MAX_QUERIES_PER_FRAME);
+}
+
+void GpuProfiler::EndFrame()
+{
+    if(s_CurrentSlotPtr == nullptr)
+        return;
+
+    // Zones left open can't be resolved
+    while(not s_OpenZones.empty())
+    {
+        if(s_OpenZones.back() >= 0)
+            s_CurrentSlotPtr->zones.erase(s_CurrentSlotPtr->zones.begin() + s_OpenZones.back());
+        s_OpenZones.pop_back();
+    }
+
+    s_CurrentSlotPtr->pendingResults = not s_CurrentSlotPtr->zones.empty();
+    s_CurrentSlotPtr = nullptr;
+    ++s_FrameIndex;
+}
+
+void GpuProfiler::BeginZone(VkCommandBuffer commandBuffer, const std::string& name)
+{
+    if(s_CurrentSlotPtr == nullptr)
+        return;
+
+    // Out of queries, mark the zone so EndZone knows to skip it
+    if(s_CurrentSlotPtr->queryCount + 2 > MAX_QUERIES_PER_FRAME)
+    {
+        s_OpenZones.push_back(-1);
+        return;
+    }
+
+    const auto slotIndex = static_cast<uint32_t>(s_FrameIndex % FRAME_LATENCY);
+    const uint32_t beginQuery = slotIndex * MAX_QUERIES_PER_FRAME + s_CurrentSlotPtr->queryCount;
+    s_CurrentSlotPtr->queryCount += 2;
+
+    s_OpenZones.push_back(static_cast<int>(s_CurrentSlotPtr->zones.size()));
+    s_CurrentSlotPtr->zones.push_back({ GetNameIndex(name), beginQuery, beginQuery + 1 });
+
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, s_QueryPool, beginQuery);
+}
+
+void GpuProfiler::EndZone(VkCommandBuffer commandBuffer)
+{
+    if(s_CurrentSlotPtr == nullptr or s_OpenZones.empty())
+        return;
+
+    const int zoneIndex = s_OpenZones.back();
+    s_OpenZones.pop_back();
+
+    if(zoneIndex < 0)
+        return;
+
+    vkCmdWriteTimestamp(commandBuffer,
+                        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                        s_QueryPool,
+                        s_CurrentSlotPtr->zones[zoneIndex].endQuery);
+}
+
+void GpuProfiler::ResolveSlot(FrameSlot& slot, uint32_t slotIndex)
+{
+    slot.pendingResults = false;
+
+    // Every query is followed by its availability value
+    std::vector<uint64_t> results(static_cast<size_t>(slot.queryCount) * 2);
+    const VkResult result = vkGetQueryPoolResults(VulkanGlobals::GetDevice(),
+                                                  s_QueryPool,
+                                                  slotIndex * MAX_QUERIES_PER_FRAME,
+                                                  slot.queryCount,
+                                                  results.size() * sizeof(uint64_t),
+                                                  results.data(),
+                                                  sizeof(uint64_t) * 2,
+                                                  VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+    if(result != VK_SUCCESS and result != VK_NOT_READY)
+        return;
+
+    std::unordered_map<uint32_t, std::pair<double, uint32_t>> frameTotals{};
+
+    for(const Zone& zone : slot.zones)
+    {
+        const uint32_t beginLocal = zone.beginQuery - slotIndex * MAX_QUERIES_PER_FRAME;
+        const uint32_t endLocal = zone.endQuery - slotIndex * MAX_QUERIES_PER_FRAME;
+
+        // Not finished yet, drop it instead of waiting
+        if(results[beginLocal * 2 + 1] == 0 or results[endLocal * 2 + 1] == 0)
+            continue;
+
+        const uint64_t begin = results[beginLocal * 2] & s_TimestampMask;
+        const uint64_t end = results[endLocal * 2] & s_TimestampMask;
+        const uint64_t ticks = end >= begin ? end - begin : 0;
+
+        auto& total = frameTotals[zone.nameIndex];
+        total.first += static_cast<double>(ticks) * s_TimestampPeriod / 1'000'000.0;
+        total.second++;
+    }
+
+    for(auto&& [nameIndex, total] : frameTotals)
+    {
+        const std::string& name = s_Names[nameIndex];
+
+        std::deque<double>& history = s_History[name];
+        history.push_front(total.first);
+        if(static_cast<int>(history.size()) > AMOUNT_OF_FRAMES_TO_AVERAGE)
+            history.pop_back();
+
+        ZoneTiming& timing = s_Timings[name];
+        timing.lastMs = total.first;
+        timing.callCount = total.second;
+        timing.averageMs =
+            std::accumulate(history.begin(), history.end(), 0.0) / static_cast<double>(history.size());
+        timing.minMs = *std::ranges::min_element(history);
+        timing.maxMs = *std::ranges::max_element(history);
+    }
+}
+
+uint32_t GpuProfiler::GetNameIndex(const std::string& name)
+{
+    auto&& iterator = s_NameIndices.find(name);
+    if(iterator != s_NameIndices.end())
+        return iterator->second;
+
+    const auto nameIndex = static_cast<uint32_t>(s_Names.size());
+    s_Names.push_back(name);
+    s_NameIndices.emplace(name, nameIndex);
+    return nameIndex;
+}
+
+bool GpuProfiler::WriteJson(const std::filesystem::path& path)
+{
+    std::ofstream file(path);
+    if(not file.is_open())
+    {
+        std::cerr << "Failed to write GPU profile to: " << path.string() << '\n';
+        return false;
+    }
+
+    std::vector<std::string> names{};
+    names.reserve(s_Timings.size());
+    for(auto&& timing : s_Timings)
+        names.push_back(timing.first);
+    std::ranges::sort(names);
+
+    file << "{\n";
+    file << "  \"frame\": " << s_FrameIndex << ",\n";
+    file << "  \"timestampPeriodNs\": " << s_TimestampPeriod << ",\n";
+    file << "  \"averagedFrames\": " << AMOUNT_OF_FRAMES_TO_AVERAGE << ",\n";
+    file << "  \"zones\": [";
+
+    for(size_t i = 0; i < names.size(); ++i)
+    {
+        const ZoneTiming& timing = s_Timings.at(names[i]);
+
+        file << (i == 0 ? "\n" : ",\n");
+        file << "    { \"name\": ";
+        WriteJsonString(file, names[i]);
+        file << ", \"lastMs\": " << timing.lastMs
+             << ", \"averageMs\": " << timing.averageMs << ", \"minMs\": " << timing.minMs
+             << ", \"maxMs\": " << timing.maxMs << ", \"calls\": " << timing.callCount << " }";
+    }
+
+    file << "\n  ]\n}\n";
+    return true;
+}
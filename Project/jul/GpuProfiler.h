@@ -0,0 +1,101 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <array>
+#include <deque>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Timestamp query based GPU profiler
+// Zones are recorded into the frame command buffer and resolved FRAME_LATENCY frames later,
+// results that are not available yet get dropped so reading them back never stalls the CPU
+class GpuProfiler final
+{
+public:
+    struct ZoneTiming
+    {
+        double lastMs{};
+        double averageMs{};
+        double minMs{};
+        double maxMs{};
+        uint32_t callCount{};  // Amount of times the zone was recorded in the last resolved frame
+    };
+
+    static void Init(uint32_t queueFamilyIndex);
+    static void Cleanup();
+
+    // Has to be called outside a render pass before any zone is recorded for the frame
+    static void BeginFrame(VkCommandBuffer commandBuffer);
+    static void EndFrame();
+
+    static void BeginZone(VkCommandBuffer commandBuffer, const std::string& name);
+    static void EndZone(VkCommandBuffer commandBuffer);
+
+    // Reports a file that can't be written instead of throwing, returns whether it was written
+    static bool WriteJson(const std::filesystem::path& path);
+
+    [[nodiscard]] static bool IsSupported() { return s_QueryPool != VK_NULL_HANDLE; }
+
+    [[nodiscard]] static const std::unordered_map<std::string, ZoneTiming>& GetTimings() { return s_Timings; }
+
+private:
+    struct Zone
+    {
+        uint32_t nameIndex;
+        uint32_t beginQuery;
+        uint32_t endQuery;
+    };
+
+    struct FrameSlot
+    {
+        std::vector<Zone> zones{};
+        uint32_t queryCount{};
+        bool pendingResults{};
+    };
+
+    static void ResolveSlot(FrameSlot& slot, uint32_t slotIndex);
+    [[nodiscard]] static uint32_t GetNameIndex(const std::string& name);
+
+    inline static VkQueryPool s_QueryPool{};
+    inline static double s_TimestampPeriod{};
+    inline static uint64_t s_TimestampMask{};
+
+    inline static uint64_t s_FrameIndex{};
+    inline static FrameSlot* s_CurrentSlotPtr{};
+
+    inline static constexpr uint32_t FRAME_LATENCY{ 3 };
+    inline static constexpr uint32_t MAX_QUERIES_PER_FRAME{ 256 };
+    inline static constexpr int AMOUNT_OF_FRAMES_TO_AVERAGE{ 60 };
+
+    inline static std::array<FrameSlot, FRAME_LATENCY> s_FrameSlots{};
+    inline static std::vector<int> s_OpenZones{};
+
+    inline static std::vector<std::string> s_Names{};
+    inline static std::unordered_map<std::string, uint32_t> s_NameIndices{};
+    inline static std::unordered_map<std::string, std::deque<double>> s_History{};
+    inline static std::unordered_map<std::string, ZoneTiming> s_Timings{};
+};
+
+// Scoped helper so zones can't be left open
+class GpuZone final
+{
+public:
+    GpuZone(VkCommandBuffer commandBuffer, const std::string& name) :
+        m_CommandBuffer(commandBuffer)
+    {
+        GpuProfiler::BeginZone(m_CommandBuffer, name);
+    }
+
+    ~GpuZone() { GpuProfiler::EndZone(m_CommandBuffer); }
+
+    GpuZone(GpuZone&&) = delete;
+    GpuZone(const GpuZone&) = delete;
+    GpuZone& operator=(GpuZone&&) = delete;
+    GpuZone& operator=(const GpuZone&) = delete;
+
+private:
+    VkCommandBuffer m_CommandBuffer;
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+// Index into a slot map plus the generation of the slot when the handle was made
+// The generation changes when the slot is freed, so handles to removed objects are detected instead of aliasing
+template<typename T>
+struct Handle
+{
+    inline static constexpr uint32_t INVALID_INDEX{ std::numeric_limits<uint32_t>::max() };
+
+    uint32_t index{ INVALID_INDEX };
+    uint32_t generation{};
+
+    [[nodiscard]] bool IsValid() const { return index != INVALID_INDEX; }
+
+    bool operator==(const Handle&) const = default;
+};
+
+class Mesh;
+class Texture;
+class Material;
+
+using MeshHandle = Handle<Mesh>;
+using TextureHandle = Handle<Texture>;
+using MaterialHandle = Handle<Material>;
@@ -0,0 +1,148 @@
+#include "InstanceBuffer.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "SwapChain.h"
+#include "vulkanbase/VulkanGlobals.h"
+
+InstanceBuffer::InstanceBuffer(uint32_t dynamicCapacity, uint32_t persistentCapacity) :
+    m_Instances(dynamicCapacity + persistentCapacity),
+    m_DynamicCapacity(dynamicCapacity),
+    m_AllocatedCount(dynamicCapacity)
+{
+    const VkDeviceSize bufferSize{ m_Instances.size() * sizeof(InstanceData) };
+
+    m_DeviceBuffer = std::make_unique<Buffer>(bufferSize,
+                                              VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    const int frameCount = VulkanGlobals::GetSwapChain().GetImageCount();
+    m_StagingBuffers.reserve(frameCount);
+
+    for(int i = 0; i < frameCount; ++i)
+    {
+        m_StagingBuffers.emplace_back(
+            std::make_unique<Buffer>(bufferSize,
+                                     VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+
+        m_StagingBuffers[i]->Map(bufferSize);
+    }
+}
+
+uint32_t InstanceBuffer::Allocate(uint32_t instanceCount)
+{
+    if(m_AllocatedCount + instanceCount > m_Instances.size())
+        throw std::runtime_error("instance buffer is full!");
+
+    const uint32_t firstInstance = m_AllocatedCount;
+    m_AllocatedCount += instanceCount;
+    return firstInstance;
+}
+
+void InstanceBuffer::Write(uint32_t firstInstance, const InstanceData* instances, uint32_t instanceCount)
+{
+    if(instanceCount == 0)
+        return;
+
+    std::copy_n(instances, instanceCount, m_Instances.begin() + firstInstance);
+    m_DirtyRanges.push_back({ firstInstance, firstInstance + instanceCount });
+}
+
+void InstanceBuffer::ClearDynamic() { m_DynamicCount = 0; }
+
+uint32_t InstanceBuffer::AddDynamic(const InstanceData& instance)
+{
+    if(m_DynamicCount >= m_DynamicCapacity)
+        throw std::runtime_error("instance buffer ran out of dynamic instances!");
+
+    m_Instances[m_DynamicCount] = instance;
+    return m_DynamicCount++;
+}
+
+void InstanceBuffer::RecordUpload(VkCommandBuffer commandBuffer, int imageIndex)
+{
+    m_UploadedInstanceCount = 0;
+
+    if(m_DynamicCount > 0)
+        m_DirtyRanges.push_back({ 0, m_DynamicCount });
+
+    if(m_DirtyRanges.empty())
+        return;
+
+    // Merge overlapping and touching ranges so every instance is copied once
+    std::ranges::sort(m_DirtyRanges, {}, &Range::begin);
+
+    m_CopyRegions.clear();
+    Buffer& stagingBuffer = *m_StagingBuffers[imageIndex];
+
+    auto addRegion = [this, &stagingBuffer](const Range& range)
+    {
+        const auto offset = static_cast<uint32_t>(range.begin * sizeof(InstanceData));
+        const auto size = static_cast<uint32_t>((range.end - range.begin) * sizeof(InstanceData));
+
+        stagingBuffer.Upload(&m_Instances[range.begin], size, offset);
+        m_CopyRegions.push_back({ .srcOffset = offset, .dstOffset = offset, .size = size });
+        m_UploadedInstanceCount += range.end - range.begin;
+    };
+
+    Range mergedRange = m_DirtyRanges.front();
+    for(const Range& range : m_DirtyRanges)
+    {
+        if(range.begin <= mergedRange.end)
+        {
+            mergedRange.end = std::max(mergedRange.end, range.end);
+            continue;
+        }
+
+        addRegion(mergedRange);
+        mergedRange = range;
+    }
+    addRegion(mergedRange);
+
+    m_DirtyRanges.clear();
+
+    // The previous frame may still be reading the instances
+    VkBufferMemoryBarrier barrier{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_READ_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = *m_DeviceBuffer,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+    };
+
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0,
+                         0,
+                         nullptr,
+                         1,
+                         &barrier,
+                         0,
+                         nullptr);
+
+    vkCmdCopyBuffer(commandBuffer,
+                    stagingBuffer,
+                    *m_DeviceBuffer,
+                    static_cast<uint32_t>(m_CopyRegions.size()),
+                    m_CopyRegions.data());
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                         0,
+                         0,
+                         nullptr,
+                         1,
+                         &barrier,
+                         0,
+                         nullptr);
+}
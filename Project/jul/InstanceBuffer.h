@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+#include <memory>
+#include <vector>
+
+#include "Buffer.h"
+
+// Device local storage buffer with the per instance data of the indirect pipelines
+//
+// | dynamic, rewritten every frame by the render queue | persistent, ranges owned by instanced meshes |
+//
+// Writes go to a CPU copy and only the dirty ranges are copied to the device buffer
+class InstanceBuffer final
+{
+public:
+    // Matches the std430 InstanceData struct in shader3D.vert
+    struct InstanceData
+    {
+        glm::mat4 modelMatrix;
+        glm::vec4 tint;
+        uint32_t materialIndex;
+        uint32_t padding[3];
+    };
+
+    static_assert(sizeof(InstanceData) == 96);
+
+    InstanceBuffer(uint32_t dynamicCapacity, uint32_t persistentCapacity);
+
+    InstanceBuffer(InstanceBuffer&&) = delete;
+    InstanceBuffer(const InstanceBuffer&) = delete;
+    InstanceBuffer& operator=(InstanceBuffer&&) = delete;
+    InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+    // Ranges are never freed, instanced meshes live as long as the buffer
+    [[nodiscard]] uint32_t Allocate(uint32_t instanceCount);
+    void Write(uint32_t firstInstance, const InstanceData* instances, uint32_t instanceCount);
+
+    void ClearDynamic();
+    [[nodiscard]] uint32_t AddDynamic(const InstanceData& instance);
+
+    // Has to be recorded outside of a render pass
+    void RecordUpload(VkCommandBuffer commandBuffer, int imageIndex);
+
+    [[nodiscard]] VkBuffer GetBuffer() const { return *m_DeviceBuffer; }
+    [[nodiscard]] uint32_t GetUploadedInstanceCount() const { return m_UploadedInstanceCount; }
+
+private:
+    struct Range
+    {
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    std::vector<InstanceData> m_Instances{};
+    std::vector<Range> m_DirtyRanges{};
+    std::vector<VkBufferCopy> m_CopyRegions{};
+
+    uint32_t m_DynamicCapacity;
+    uint32_t m_DynamicCount{};
+    uint32_t m_AllocatedCount;
+
+    uint32_t m_UploadedInstanceCount{};
+
+    std::unique_ptr<Buffer> m_DeviceBuffer;
+    std::vector<std::unique_ptr<Buffer>> m_StagingBuffers{};
+};
@@ -0,0 +1,241 @@
+#include "Ktx2File.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace
+{
+    constexpr std::array<uint8_t, 12> IDENTIFIER{ 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+    // Identifier, header and index, the level index follows right after
+    constexpr size_t HEADER_SIZE{ 80 };
+    constexpr size_t LEVEL_INDEX_ENTRY_SIZE{ 24 };
+
+    constexpr std::string_view WRITER_KEY{ "KTXwriter" };
+    constexpr std::string_view WRITER_NAME{ "Vulkan-inator TextureCompressor" };
+
+    // Custom key, its value is the four RGBA8 bytes of the uniform texel
+    constexpr std::string_view UNIFORM_TEXEL_KEY{ "JULuniformTexel" };
+
+    // Basic data format descriptor of a block compressed format, see the Khronos Data Format Specification
+    struct BlockFormat
+    {
+        uint32_t colorModel;
+        uint32_t blockSize;
+        uint32_t channelCount;
+        bool srgb;
+    };
+
+    // Only the formats the compressor writes
+    std::optional<BlockFormat> FindBlockFormat(VkFormat format)
+    {
+        switch(format)
+        {
+            case VK_FORMAT_BC1_RGB_UNORM_BLOCK: return BlockFormat{ 128, 8, 1, false };
+            case VK_FORMAT_BC1_RGB_SRGB_BLOCK: return BlockFormat{ 128, 8, 1, true };
+            case VK_FORMAT_BC4_UNORM_BLOCK: return BlockFormat{ 131, 8, 1, false };
+            case VK_FORMAT_BC5_UNORM_BLOCK: return BlockFormat{ 132, 16, 2, false };
+            case VK_FORMAT_BC7_UNORM_BLOCK: return BlockFormat{ 134, 16, 1, false };
+            case VK_FORMAT_BC7_SRGB_BLOCK: return BlockFormat{ 134, 16, 1, true };
+            default: return std::nullopt;
+        }
+    }
+
+    template<typename Value>
+    Value Read(std::span<const std::byte> data, size_t offset)
+    {
+        if(offset + sizeof(Value) > data.size())
+            throw std::runtime_error("KTX2 file is truncated!");
+
+        Value value{};
+        std::memcpy(&value, data.data() + offset, sizeof(Value));
+        return value;
+    }
+
+    template<typename Value>
+    void Append(std::vector<uint8_t>& bytes, Value value)
+    {
+        const size_t offset = bytes.size();
+        bytes.resize(offset + sizeof(Value));
+        std::memcpy(bytes.data() + offset, &value, sizeof(Value));
+    }
+
+    template<typename Value>
+    void Patch(std::vector<uint8_t>& bytes, size_t offset, Value value)
+    {
+        std::memcpy(bytes.data() + offset, &value, sizeof(Value));
+    }
+
+    void AlignTo(std::vector<uint8_t>& bytes, size_t alignment)
+    {
+        bytes.resize((bytes.size() + alignment - 1) / alignment * alignment);
+    }
+
+    // Every entry is padded to 4 bytes
+    void AppendKeyValue(std::vector<uint8_t>& bytes, std::string_view key, std::span<const uint8_t> value)
+    {
+        Append(bytes, static_cast<uint32_t>(key.size() + 1 + value.size()));
+        bytes.insert(bytes.end(), key.begin(), key.end());
+        bytes.push_back(0);
+        bytes.insert(bytes.end(), value.begin(), value.end());
+        AlignTo(bytes, 4);
+    }
+}  // namespace
+
+Ktx2File::Ktx2File(const std::filesystem::path& filePath) :
+    m_File(filePath)
+{
+    const std::span<const std::byte> data = m_File.GetData();
+
+    if(data.size() < HEADER_SIZE or std::memcmp(data.data(), IDENTIFIER.data(), IDENTIFIER.size()) != 0)
+        throw std::runtime_error(filePath.string() + " is not a KTX2 file!");
+
+    m_Format = static_cast<VkFormat>(Read<uint32_t>(data, 12));
+    const auto width = Read<uint32_t>(data, 20);
+    const auto height = Read<uint32_t>(data, 24);
+    const auto depth = Read<uint32_t>(data, 28);
+    const auto layerCount = Read<uint32_t>(data, 32);
+    const auto faceCount = Read<uint32_t>(data, 36);
+    const auto levelCount = std::max(Read<uint32_t>(data, 40), 1u);
+    const auto supercompression = Read<uint32_t>(data, 44);
+
+    if(m_Format == VK_FORMAT_UNDEFINED or supercompression != 0)
+        throw std::runtime_error(filePath.string() + " is supercompressed, only plain KTX2 files are supported!");
+
+    if(width == 0 or height == 0 or depth != 0 or layerCount > 1 or faceCount != 1)
+        throw std::runtime_error(filePath.string() + " is not a single 2D image!");
+
+    const std::optional<BlockFormat> blockFormat = FindBlockFormat(m_Format);
+    if(not blockFormat.has_value())
+        throw std::runtime_error(filePath.string() + " uses a format the texture compressor doesn't write!");
+
+    // Unknown keys are skipped
+    const auto kvdOffset = Read<uint32_t>(data, 56);
+    const auto kvdLength = Read<uint32_t>(data, 60);
+    for(size_t entryOffset = kvdOffset; entryOffset + 4 <= static_cast<size_t>(kvdOffset) + kvdLength;)
+    {
+        const auto entryLength = Read<uint32_t>(data, entryOffset);
+        if(entryLength > data.size() - entryOffset - 4)
+            throw std::runtime_error(filePath.string() + " has a key value entry outside of the file!");
+
+        const std::string_view entry{ reinterpret_cast<const char*>(data.data() + entryOffset + 4), entryLength };
+        const size_t keyEnd = entry.find('\0');
+        if(entry.substr(0, keyEnd) == UNIFORM_TEXEL_KEY and entry.size() == keyEnd + 5)
+        {
+            std::array<uint8_t, 4> texel{};
+            std::memcpy(texel.data(), entry.data() + keyEnd + 1, texel.size());
+            m_UniformTexel = texel;
+        }
+
+        entryOffset += (4 + entryLength + 3) / 4 * 4;
+    }
+
+    for(uint32_t levelIndex = 0; levelIndex < levelCount; ++levelIndex)
+    {
+        const size_t entryOffset = HEADER_SIZE + levelIndex * LEVEL_INDEX_ENTRY_SIZE;
+        const auto byteOffset = Read<uint64_t>(data, entryOffset);
+        const auto byteLength = Read<uint64_t>(data, entryOffset + 8);
+
+        if(byteOffset > data.size() or byteLength > data.size() - byteOffset)
+            throw std::runtime_error(filePath.string() + " has a mip level outside of the file!");
+
+        const uint32_t levelWidth = std::max(width >> levelIndex, 1u);
+        const uint32_t levelHeight = std::max(height >> levelIndex, 1u);
+
+        // The upload copies whole blocks, a short level would be read past its end
+        const uint64_t expectedLength = uint64_t{ (levelWidth + 3) / 4 } * ((levelHeight + 3) / 4) *
+                                        blockFormat->blockSize * std::max(layerCount, 1u) * faceCount;
+        if(byteLength != expectedLength)
+            throw std::runtime_error(filePath.string() + " has a mip level with the wrong size!");
+
+        m_Levels.push_back({
+            .width = levelWidth,
+            .height = levelHeight,
+            .data = data.subspan(byteOffset, byteLength),
+        });
+    }
+}
+
+void Ktx2File::Write(const std::filesystem::path& filePath, VkFormat format, uint32_t width, uint32_t height,
+                     const std::vector<std::vector<uint8_t>>& levels,
+                     const std::optional<std::array<uint8_t, 4>>& uniformTexel)
+{
+    const std::optional<BlockFormat> foundBlockFormat = FindBlockFormat(format);
+    if(not foundBlockFormat.has_value())
+        throw std::invalid_argument("KTX2 writing isn't supported for this format!");
+
+    const BlockFormat& blockFormat = *foundBlockFormat;
+    const auto levelCount = static_cast<uint32_t>(levels.size());
+
+    std::vector<uint8_t> bytes(IDENTIFIER.begin(), IDENTIFIER.end());
+
+    // Block compressed formats have a type size of 1, depth 0 and layer count 0 mean a plain 2D image
+    for(const uint32_t headerValue : { static_cast<uint32_t>(format), 1u, width, height, 0u, 0u, 1u, levelCount, 0u })
+        Append(bytes, headerValue);
+
+    // Offsets are patched in once the sections are written
+    const size_t indexOffset = bytes.size();
+    bytes.resize(HEADER_SIZE + levelCount * LEVEL_INDEX_ENTRY_SIZE);
+
+    const size_t dfdOffset = bytes.size();
+    const uint32_t descriptorBlockSize = 24 + 16 * blockFormat.channelCount;
+    Append(bytes, 4 + descriptorBlockSize);
+    Append(bytes, 0u);
+    Append(bytes, 2u | descriptorBlockSize << 16);
+    Append(bytes, blockFormat.colorModel | 1u << 8 | (blockFormat.srgb ? 2u : 1u) << 16);
+    Append(bytes, 3u | 3u << 8);
+    Append(bytes, blockFormat.blockSize);
+    Append(bytes, 0u);
+
+    // Channels split the block evenly, BC5 is red then green
+    const uint32_t sampleBits = blockFormat.blockSize * 8 / blockFormat.channelCount;
+    for(uint32_t channel = 0; channel < blockFormat.channelCount; ++channel)
+    {
+        Append(bytes, channel * sampleBits | (sampleBits - 1) << 16 | channel << 24);
+        Append(bytes, 0u);
+        Append(bytes, 0u);
+        Append(bytes, UINT32_MAX);
+    }
+    const size_t dfdLength = bytes.size() - dfdOffset;
+
+    // Keys are sorted by their bytes
+    const size_t kvdOffset = bytes.size();
+    if(uniformTexel.has_value())
+        AppendKeyValue(bytes, UNIFORM_TEXEL_KEY, *uniformTexel);
+
+    // The writer name is stored with its terminator
+    const std::string writerName{ WRITER_NAME };
+    AppendKeyValue(bytes,
+                   WRITER_KEY,
+                   std::span{ reinterpret_cast<const uint8_t*>(writerName.c_str()), writerName.size() + 1 });
+    const size_t kvdLength = bytes.size() - kvdOffset;
+
+    Patch(bytes, indexOffset, static_cast<uint32_t>(dfdOffset));
+    Patch(bytes, indexOffset + 4, static_cast<uint32_t>(dfdLength));
+    Patch(bytes, indexOffset + 8, static_cast<uint32_t>(kvdOffset));
+    Patch(bytes, indexOffset + 12, static_cast<uint32_t>(kvdLength));
+
+    // The smallest level is stored first, every level starts on a block
+    for(uint32_t levelIndex = levelCount; levelIndex-- > 0;)
+    {
+        AlignTo(bytes, blockFormat.blockSize);
+
+        const size_t entryOffset = HEADER_SIZE + levelIndex * LEVEL_INDEX_ENTRY_SIZE;
+        Patch(bytes, entryOffset, static_cast<uint64_t>(bytes.size()));
+        Patch(bytes, entryOffset + 8, static_cast<uint64_t>(levels[levelIndex].size()));
+        Patch(bytes, entryOffset + 16, static_cast<uint64_t>(levels[levelIndex].size()));
+
+        bytes.insert(bytes.end(), levels[levelIndex].begin(), levels[levelIndex].end());
+    }
+
+    std::ofstream file{ filePath, std::ios::binary | std::ios::trunc };
+    if(not file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size())))
+        throw std::runtime_error("Failed to write " + filePath.string() + "!");
+}
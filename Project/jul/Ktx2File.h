@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "MappedFile.h"
+
+// The part of KTX2 the texture pipeline uses, one 2D image with its mips and no supercompression
+//
+// Files are memory mapped, the level spans point straight into the mapping
+class Ktx2File final
+{
+public:
+    struct Level
+    {
+        uint32_t width;
+        uint32_t height;
+        std::span<const std::byte> data;
+    };
+
+    // Throws when the file isn't a KTX2 file this loader can read
+    explicit Ktx2File(const std::filesystem::path& filePath);
+
+    [[nodiscard]] VkFormat GetFormat() const { return m_Format; }
+    // Level 0 is the full size image
+    [[nodiscard]] const std::vector<Level>& GetLevels() const { return m_Levels; }
+    // The RGBA8 value every texel of the source image had, the blocks can't tell without decoding them
+    [[nodiscard]] const std::optional<std::array<uint8_t, 4>>& GetUniformTexel() const { return m_UniformTexel; }
+
+    // Only the BC formats the compressor writes are supported, levels start at the full size image
+    static void Write(const std::filesystem::path& filePath, VkFormat format, uint32_t width, uint32_t height,
+                      const std::vector<std::vector<uint8_t>>& levels,
+                      const std::optional<std::array<uint8_t, 4>>& uniformTexel = std::nullopt);
+
+private:
+    MappedFile m_File;
+    VkFormat m_Format{};
+    std::vector<Level> m_Levels{};
+    std::optional<std::array<uint8_t, 4>> m_UniformTexel{};
+};
@@ -0,0 +1,87 @@
+#include "MappedFile.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::filesystem::path& filePath)
+{
+    const std::string errorPrefix = "Failed to map " + filePath.string() + ": ";
+
+#ifdef _WIN32
+    const HANDLE file = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if(file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error(errorPrefix + "can't open the file!");
+
+    LARGE_INTEGER fileSize{};
+    if(not GetFileSizeEx(file, &fileSize) or fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        throw std::runtime_error(errorPrefix + "the file is empty!");
+    }
+
+    // The view keeps the mapping alive, so both handles can be closed right away
+    const HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if(mapping == nullptr)
+        throw std::runtime_error(errorPrefix + "can't create the mapping!");
+
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if(view == nullptr)
+        throw std::runtime_error(errorPrefix + "can't map the view!");
+
+    m_Data = static_cast<const std::byte*>(view);
+    m_Size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    const int file = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if(file == -1)
+        throw std::runtime_error(errorPrefix + "can't open the file!");
+
+    struct stat fileStat{};
+    if(fstat(file, &fileStat) != 0 or fileStat.st_size == 0)
+    {
+        close(file);
+        throw std::runtime_error(errorPrefix + "the file is empty!");
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    void* view = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if(view == MAP_FAILED)
+        throw std::runtime_error(errorPrefix + "mmap failed!");
+
+    m_Data = static_cast<const std::byte*>(view);
+    m_Size = static_cast<size_t>(fileStat.st_size);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    if(m_Data == nullptr)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(m_Data);
+#else
+    munmap(const_cast<std::byte*>(m_Data), m_Size);
+#endif
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept :
+    m_Data(other.m_Data),
+    m_Size(other.m_Size)
+{
+    other.m_Data = nullptr;
+    other.m_Size = 0;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+// Read only view of a whole file, the pages are loaded by the OS when they are touched
+class MappedFile final
+{
+public:
+    explicit MappedFile(const std::filesystem::path& filePath);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Page aligned, so it can be reinterpreted as any type with a smaller alignment
+    [[nodiscard]] std::span<const std::byte> GetData() const { return { m_Data, m_Size }; }
+
+private:
+    const std::byte* m_Data{};
+    size_t m_Size{};
+};
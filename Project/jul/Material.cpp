@@ -3,62 +3,57 @@
 #include <vulkan/vk_enum_string_helper.h>
 #include <vulkanbase/VulkanGlobals.h>
 
+#include <array>
 #include <stdexcept>
 #include <vector>
 
+#include "DescriptorAllocator.h"
 #include "Texture.h"
 
 using namespace std::string_literals;
 
-Material::Material(const std::vector<const Texture*>& textures) :
+Material::Material(const std::vector<const Texture*>& textures,
+                   const glm::vec4& colorFactor,
+                   float metallicFactor,
+                   float roughnessFactor) :
     m_Texture(textures)
 {
-    const VkDescriptorSetAllocateInfo allocInfo{
-        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-        .descriptorPool = g_MaterialPool,
-        .descriptorSetCount = 1,
-        .pSetLayouts = &g_MaterialSetLayout,
-    };
-
-    auto result = vkAllocateDescriptorSets(VulkanGlobals::GetDevice(), &allocInfo, &m_DescriptorSet);
-    if(result != VK_SUCCESS)
-        throw std::runtime_error{ "failed to allocate descriptor sets! For Material, error: "s +
-                                  string_VkResult(result) };
+    if(m_Texture.size() != TEXTURES_PER_MATERIAL)
+        throw std::runtime_error("Materials need a color, normal and ORM texture!");
 
+    m_Features = CreateFeatures(m_Texture);
 
-    std::vector<VkWriteDescriptorSet> descriptorWrites;
-    descriptorWrites.reserve(m_Texture.size());
-
-    for(size_t textureIndex{}; textureIndex < m_Texture.size(); ++textureIndex)
+    if(IsBindless())
     {
-        const VkDescriptorImageInfo& descriptorInfo = m_Texture[textureIndex]->GetDescriptorInfo();
-
-        descriptorWrites.emplace_back(VkWriteDescriptorSet{
-            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-            .dstSet = m_DescriptorSet,
-            .dstBinding = static_cast<uint32_t>(textureIndex),
-            .dstArrayElement = 0,
-            .descriptorCount = 1,
-            .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-
-            .pImageInfo = &descriptorInfo,
-            .pBufferInfo = nullptr,
-            .pTexelBufferView = nullptr,
-        });
+        WriteTableEntry(colorFactor, metallicFactor, roughnessFactor);
+        m_DescriptorSet = g_BindlessSet;
+        return;
     }
 
-    vkUpdateDescriptorSets(
-        VulkanGlobals::GetDevice(), uint32_t(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+    std::array<VkDescriptorImageInfo, TEXTURES_PER_MATERIAL> textureInfos{};
+    for(size_t textureIndex{}; textureIndex < m_Texture.size(); ++textureIndex)
+        textureInfos[textureIndex] = m_Texture[textureIndex]->GetDescriptorInfo();
+
+    // Pools are chained by the allocator, so creating materials at runtime never runs out
+    DescriptorAllocator& descriptorAllocator = VulkanGlobals::GetDescriptorAllocator();
+    m_DescriptorSet = descriptorAllocator.Allocate(g_MaterialSetLayout);
+    descriptorAllocator.Write(m_DescriptorSet, g_MaterialSetLayout, textureInfos.data());
 }
 
-void Material::CreateMaterialPool(int maxMaterialCount, int maxTexturesPerMaterial)
+void Material::Init()
 {
+    if(VulkanGlobals::IsDescriptorIndexingEnabled())
+    {
+        CreateBindlessSet();
+        return;
+    }
+
     std::vector<VkDescriptorSetLayoutBinding> bindings{};
 
-    for(size_t textureIndex{}; textureIndex < maxTexturesPerMaterial; ++textureIndex)
+    for(uint32_t textureIndex{}; textureIndex < TEXTURES_PER_MATERIAL; ++textureIndex)
     {
         bindings.push_back({
-            .binding = static_cast<uint32_t>(textureIndex),
+            .binding = textureIndex,
             .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
             .descriptorCount = 1,
             .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
@@ -66,34 +61,168 @@ void Material::CreateMaterialPool(int maxMaterialCount, int maxTexturesPerMateri
         });
     }
 
-    const VkDescriptorSetLayoutCreateInfo setInfo{ .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-                                                   .bindingCount = static_cast<uint32_t>(bindings.size()),
-                                                   .pBindings = bindings.data() };
+    g_MaterialSetLayout = VulkanGlobals::GetDescriptorAllocator().GetLayout(bindings);
+}
 
+void Material::Cleanup()
+{
+    // Without descriptor indexing the layout belongs to the descriptor allocator
+    if(IsBindless())
+    {
+        vkDestroyDescriptorSetLayout(VulkanGlobals::GetDevice(), g_MaterialSetLayout, nullptr);
+        vkDestroyDescriptorPool(VulkanGlobals::GetDevice(), g_MaterialPool, nullptr);
+    }
 
-    if(vkCreateDescriptorSetLayout(VulkanGlobals::GetDevice(), &setInfo, nullptr, &g_MaterialSetLayout) != VK_SUCCESS)
-        throw std::runtime_error("Failed to create vkCreateDescriptorSetLayout!");
+    g_MaterialSetLayout = VK_NULL_HANDLE;
+    g_MaterialPool = VK_NULL_HANDLE;
+    g_BindlessSet = VK_NULL_HANDLE;
+    g_MaterialTableBuffer.reset();
+    g_BindlessTextureIndices.clear();
+}
 
+Material::Features Material::CreateFeatures(const std::vector<const Texture*>& textures)
+{
+    // Only placeholders holding the value the shaders fall back to can be left out
+    auto holdsValue = [](const Texture* texture, uint8_t red, uint8_t green, uint8_t blue)
+    {
+        const std::optional<std::array<uint8_t, 4>>& texel = texture->GetUniformTexel();
+        return texel.has_value() and (*texel)[0] == red and (*texel)[1] == green and (*texel)[2] == blue;
+    };
 
-    const VkDescriptorPoolSize poolSize{ .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                                         .descriptorCount = static_cast<uint32_t>(bindings.size() * maxMaterialCount)
+    // A flat tangent space normal, no occlusion, full roughness and no metal
+    return {
+        .normalMap = not holdsValue(textures[1], 128, 128, 255),
+        .ormMap = not holdsValue(textures[2], 255, 255, 0),
+    };
+}
 
+void Material::WriteTableEntry(const glm::vec4& colorFactor, float metallicFactor, float roughnessFactor)
+{
+    if(m_Id >= MAX_BINDLESS_MATERIAL_COUNT)
+        throw std::runtime_error("Bindless material table is full!");
+
+    MaterialData materialData{
+        .colorTexture = GetBindlessTextureIndex(*m_Texture[0]),
+        .normalTexture = GetBindlessTextureIndex(*m_Texture[1]),
+        .ormTexture = GetBindlessTextureIndex(*m_Texture[2]),
+        .colorFactor = colorFactor,
+        .metallicFactor = metallicFactor,
+        .roughnessFactor = roughnessFactor,
+    };
+
+    // Only new entries are written, so frames in flight never read a changing entry
+    g_MaterialTableBuffer->Upload(&materialData, sizeof(MaterialData), static_cast<uint32_t>(m_Id * sizeof(MaterialData)));
+}
+
+void Material::CreateBindlessSet()
+{
+    const std::array<VkDescriptorSetLayoutBinding, 2> bindings{
+        VkDescriptorSetLayoutBinding{ .binding = 0,
+                                     .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                                     .descriptorCount = MAX_BINDLESS_TEXTURE_COUNT,
+                                     .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT },
+
+        // Material table
+        VkDescriptorSetLayoutBinding{ .binding = 1,
+                                     .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                     .descriptorCount = 1,
+                                     .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT },
+    };
+
+    // Textures are written while the set is bound, unwritten slots are never read
+    const std::array<VkDescriptorBindingFlagsEXT, 2> bindingFlags{
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT,
+        0,
+    };
+
+    const VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT,
+        .bindingCount = static_cast<uint32_t>(bindingFlags.size()),
+        .pBindingFlags = bindingFlags.data(),
+    };
+
+    const VkDescriptorSetLayoutCreateInfo setInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = &bindingFlagsInfo,
+        .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT,
+        .bindingCount = static_cast<uint32_t>(bindings.size()),
+        .pBindings = bindings.data(),
+    };
+
+    if(vkCreateDescriptorSetLayout(VulkanGlobals::GetDevice(), &setInfo, nullptr, &g_MaterialSetLayout) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create bindless descriptor set layout!");
+
+    const std::array<VkDescriptorPoolSize, 2> poolSizes{
+        VkDescriptorPoolSize{ .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                             .descriptorCount = MAX_BINDLESS_TEXTURE_COUNT },
+        VkDescriptorPoolSize{ .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 1 },
     };
 
     const VkDescriptorPoolCreateInfo poolInfo{
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-        .flags = 0,
-        .maxSets = static_cast<uint32_t>(maxMaterialCount),
-        .poolSizeCount = static_cast<uint32_t>(1),
-        .pPoolSizes = &poolSize,
+        .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT,
+        .maxSets = 1,
+        .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+        .pPoolSizes = poolSizes.data(),
     };
 
     if(vkCreateDescriptorPool(VulkanGlobals::GetDevice(), &poolInfo, nullptr, &g_MaterialPool) != VK_SUCCESS)
-        throw std::runtime_error("failed to create vkCreateDescriptorPool!");
+        throw std::runtime_error("Failed to create bindless descriptor pool!");
+
+    const VkDescriptorSetAllocateInfo allocInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = g_MaterialPool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &g_MaterialSetLayout,
+    };
+
+    auto result = vkAllocateDescriptorSets(VulkanGlobals::GetDevice(), &allocInfo, &g_BindlessSet);
+    if(result != VK_SUCCESS)
+        throw std::runtime_error{ "failed to allocate bindless descriptor set! error: "s + string_VkResult(result) };
+
+    constexpr VkDeviceSize tableSize{ MAX_BINDLESS_MATERIAL_COUNT * sizeof(MaterialData) };
+    g_MaterialTableBuffer =
+        std::make_unique<Buffer>(tableSize,
+                                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    g_MaterialTableBuffer->Map(tableSize);
+
+    const VkDescriptorBufferInfo tableInfo{ .buffer = *g_MaterialTableBuffer, .offset = 0, .range = tableSize };
+
+    const VkWriteDescriptorSet tableWrite{
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = g_BindlessSet,
+        .dstBinding = 1,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .pBufferInfo = &tableInfo,
+    };
+
+    vkUpdateDescriptorSets(VulkanGlobals::GetDevice(), 1, &tableWrite, 0, nullptr);
 }
 
-void Material::Cleanup()
+uint32_t Material::GetBindlessTextureIndex(const Texture& texture)
 {
-    vkDestroyDescriptorSetLayout(VulkanGlobals::GetDevice(), g_MaterialSetLayout, nullptr);
-    vkDestroyDescriptorPool(VulkanGlobals::GetDevice(), g_MaterialPool, nullptr);
+    if(auto found = g_BindlessTextureIndices.find(&texture); found != g_BindlessTextureIndices.end())
+        return found->second;
+
+    const auto textureIndex = static_cast<uint32_t>(g_BindlessTextureIndices.size());
+    if(textureIndex >= MAX_BINDLESS_TEXTURE_COUNT)
+        throw std::runtime_error("Bindless texture array is full!");
+
+    const VkWriteDescriptorSet textureWrite{
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = g_BindlessSet,
+        .dstBinding = 0,
+        .dstArrayElement = textureIndex,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .pImageInfo = &texture.GetDescriptorInfo(),
+    };
+
+    vkUpdateDescriptorSets(VulkanGlobals::GetDevice(), 1, &textureWrite, 0, nullptr);
+
+    g_BindlessTextureIndices.emplace(&texture, textureIndex);
+    return textureIndex;
 }
@@ -1,30 +1,92 @@
 #pragma once
 
 
+#include <glm/vec4.hpp>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
+#include "Buffer.h"
 #include "vulkan/vulkan_core.h"
 
 class Texture;
 
+// A color, normal and ORM texture, ORM packs occlusion, roughness and metallic into RGB
+//
+// With descriptor indexing every material shares one set with all textures and a table of material entries,
+// shaders index the table with the material id so the set is bound once per pipeline instead of once per material
 class Material final
 {
 public:
-    Material(const std::vector<const Texture*>& textures);
+    // Matches the std430 MaterialData struct in shader3DBindless.frag
+    struct MaterialData
+    {
+        uint32_t colorTexture;
+        uint32_t normalTexture;
+        uint32_t ormTexture;
+        uint32_t texturePadding;
+        glm::vec4 colorFactor;
+        float metallicFactor;
+        float roughnessFactor;
+        float padding[2];
+    };
 
-    static void CreateMaterialPool(int maxMaterialCount, int maxTexturesPerMaterial);
+    static_assert(sizeof(MaterialData) == 48);
+
+    // Which of the optional textures hold information, the others are left out of the shader permutation
+    struct Features
+    {
+        bool normalMap{ true };
+        bool ormMap{ true };
+    };
+
+    Material(const std::vector<const Texture*>& textures,
+             const glm::vec4& colorFactor = glm::vec4{ 1.0f },
+             float metallicFactor = 1.0f,
+             float roughnessFactor = 1.0f);
+
+    // Creates the bindless set when descriptor indexing is enabled, otherwise the per material layout
+    static void Init();
     static void Cleanup();
 
+    [[nodiscard]] static bool IsBindless() { return g_BindlessSet != VK_NULL_HANDLE; }
+
+    // The shared set for bindless materials
     [[nodiscard]] VkDescriptorSet GetDescriptorSet() const { return m_DescriptorSet; }
 
+    // Also the index in the material table
+    [[nodiscard]] uint32_t GetId() const { return m_Id; }
+
+    [[nodiscard]] const Features& GetFeatures() const { return m_Features; }
+
     [[nodiscard]] static VkDescriptorSetLayout GetMaterialSetLayout() { return g_MaterialSetLayout; }
 
+    inline static constexpr uint32_t TEXTURES_PER_MATERIAL{ 3 };
+    inline static constexpr uint32_t MAX_BINDLESS_TEXTURE_COUNT{ 1'024 };
+    inline static constexpr uint32_t MAX_BINDLESS_MATERIAL_COUNT{ 1'024 };
+
 private:
+    [[nodiscard]] static Features CreateFeatures(const std::vector<const Texture*>& textures);
+
+    void WriteTableEntry(const glm::vec4& colorFactor, float metallicFactor, float roughnessFactor);
+
+    static void CreateBindlessSet();
+    // Textures shared between materials only take one slot
+    [[nodiscard]] static uint32_t GetBindlessTextureIndex(const Texture& texture);
+
     std::vector<const Texture*> m_Texture;
+    Features m_Features{};
 
     VkDescriptorSet m_DescriptorSet{};
 
+    uint32_t m_Id{ s_NextId++ };
+    inline static uint32_t s_NextId{};
+
     inline static VkDescriptorSetLayout g_MaterialSetLayout{};
+    // Only used by the bindless set, it needs an update after bind pool
     inline static VkDescriptorPool g_MaterialPool{};
-};
 
+    inline static VkDescriptorSet g_BindlessSet{};
+    inline static std::unique_ptr<Buffer> g_MaterialTableBuffer{};
+    inline static std::unordered_map<const Texture*, uint32_t> g_BindlessTextureIndices{};
+};
@@ -1,5 +1,11 @@
 #include "Mesh.h"
 
+#include <stdexcept>
+
+#include "CommandEncoder.h"
+#include "GeometryBuffer.h"
+#include "InstanceBuffer.h"
+#include "Material.h"
 #include "vulkanbase/VulkanUtil.h"
 
 Mesh::Mesh(const std::vector<uint32_t>& indicies, const VertexData& vertexData, Material* material) :
@@ -39,13 +45,103 @@ Mesh::Mesh(const std::vector<uint32_t>& indicies, const VertexData& vertexData,
     vulkanUtil::CopyBuffer(*m_StagingBuffer, *m_IndexBuffer, indicesBufferSize);
 }
 
-void Mesh::Draw(VkCommandBuffer commandBuffer) const
+Mesh::Mesh(const std::vector<uint32_t>& indicies, const VertexData& vertexData, Material* material,
+           GeometryBuffer& geometryBuffer) :
+    m_MaterialPtr(material),
+    m_GeometryBufferPtr(&geometryBuffer)
+{
+    const GeometryBuffer::Allocation allocation =
+        geometryBuffer.Add(vertexData.data, vertexData.vertexCount, indicies);
+
+    m_NumIndices = allocation.indexCount;
+    m_FirstIndex = allocation.firstIndex;
+    m_VertexOffset = allocation.vertexOffset;
+}
+
+void Mesh::EnableInstancing(InstanceBuffer& instanceBuffer, uint32_t maxInstanceCount)
+{
+    if(m_InstanceBufferPtr != nullptr)
+        throw std::runtime_error("mesh instancing is already enabled!");
+
+    m_InstanceBufferPtr = &instanceBuffer;
+    m_FirstInstance = instanceBuffer.Allocate(maxInstanceCount);
+    m_MaxInstanceCount = maxInstanceCount;
+}
+
+uint32_t Mesh::AddInstance(const glm::mat4& modelMatrix, const glm::vec4& tint)
+{
+    if(not IsInstanced())
+        throw std::runtime_error("mesh instancing is not enabled!");
+
+    if(m_InstanceCount >= m_MaxInstanceCount)
+        throw std::runtime_error("mesh has no room for more instances!");
+
+    WriteInstance(m_InstanceCount, modelMatrix, tint);
+
+    // Adding only grows the bounds, no need to go over the other instances
+    const Bounds& instanceBounds = m_InstanceWorldBounds.emplace_back(m_Bounds.Transformed(modelMatrix));
+    m_InstanceBounds = m_InstanceCount == 0 ? instanceBounds : Bounds::Merge(m_InstanceBounds, instanceBounds);
+
+    return m_InstanceCount++;
+}
+
+void Mesh::SetInstance(uint32_t instanceIndex, const glm::mat4& modelMatrix, const glm::vec4& tint)
+{
+    if(not IsInstanced())
+        throw std::runtime_error("mesh instancing is not enabled!");
+
+    if(instanceIndex >= m_InstanceCount)
+        throw std::runtime_error("mesh instance index is out of range!");
+
+    WriteInstance(instanceIndex, modelMatrix, tint);
+
+    // The old position may have been the edge of the bounds, so they are rebuilt
+    m_InstanceWorldBounds[instanceIndex] = m_Bounds.Transformed(modelMatrix);
+    m_InstanceBounds = m_InstanceWorldBounds.front();
+    for(const Bounds& instanceBounds : m_InstanceWorldBounds)
+        m_InstanceBounds = Bounds::Merge(m_InstanceBounds, instanceBounds);
+}
+
+void Mesh::WriteInstance(uint32_t instanceIndex, const glm::mat4& modelMatrix, const glm::vec4& tint)
+{
+    const InstanceBuffer::InstanceData instance{
+        .modelMatrix = modelMatrix,
+        .tint = tint,
+        .materialIndex = m_MaterialPtr != nullptr ? m_MaterialPtr->GetId() : 0,
+    };
+
+    m_InstanceBufferPtr->Write(m_FirstInstance + instanceIndex, &instance, 1);
+}
+
+Bounds Mesh::GetWorldBounds() const
+{
+    if(IsInstanced())
+        return m_InstanceBounds;
+
+    return m_Bounds.Transformed(m_ModelMatrix);
+}
+
+void Mesh::Draw(CommandEncoder& encoder) const
+{
+    Bind(encoder);
+    DrawIndexed(encoder);
+}
+
+void Mesh::Bind(CommandEncoder& encoder) const
+{
+    if(m_GeometryBufferPtr != nullptr)
+    {
+        m_GeometryBufferPtr->Bind(encoder);
+        return;
+    }
+
+    encoder.BindVertexBuffer(*m_VertexBuffer);
+    encoder.BindIndexBuffer(*m_IndexBuffer);
+}
+
+void Mesh::DrawIndexed(VkCommandBuffer commandBuffer) const
 {
-    VkBuffer vertexBuffers[] = { *m_VertexBuffer };
-    VkDeviceSize offsets[] = { 0 };
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-    vkCmdBindIndexBuffer(commandBuffer, *m_IndexBuffer, 0, VK_INDEX_TYPE_UINT32);
-    vkCmdDrawIndexed(commandBuffer, m_NumIndices, 1, 0, 0, 0);
+    vkCmdDrawIndexed(commandBuffer, m_NumIndices, 1, m_FirstIndex, m_VertexOffset, 0);
 }
 
 const VkVertexInputBindingDescription Mesh::Vertex2D::BINDING_DESCRIPTION{
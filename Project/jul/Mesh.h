@@ -9,8 +9,12 @@
 #include <memory>
 #include <vector>
 
+#include "Bounds.h"
 #include "Buffer.h"
 
+class CommandEncoder;
+class GeometryBuffer;
+class InstanceBuffer;
 class Material;
 class Mesh final
 {
@@ -52,10 +56,42 @@ public:
 
     Mesh(const std::vector<uint32_t>& indicies, const VertexData& vertexData, Material* material);
 
-    void Draw(VkCommandBuffer commandBuffer) const;
+    // Stores the mesh in a shared geometry buffer instead of its own buffers
+    Mesh(const std::vector<uint32_t>& indicies, const VertexData& vertexData, Material* material,
+         GeometryBuffer& geometryBuffer);
+
+    void Draw(CommandEncoder& encoder) const;
+
+    // Split up draw so consecutive draws of the same mesh only bind once
+    void Bind(CommandEncoder& encoder) const;
+    void DrawIndexed(VkCommandBuffer commandBuffer) const;
+
+    // Reserves room for maxInstanceCount instances, all of them are drawn by one instanced draw
+    void EnableInstancing(InstanceBuffer& instanceBuffer, uint32_t maxInstanceCount);
+    uint32_t AddInstance(const glm::mat4& modelMatrix, const glm::vec4& tint = glm::vec4{ 1.0f });
+    // Only instances that were added can be set, the world bounds are rebuilt around the new position
+    void SetInstance(uint32_t instanceIndex, const glm::mat4& modelMatrix, const glm::vec4& tint = glm::vec4{ 1.0f });
+
+    [[nodiscard]] bool IsInstanced() const { return m_InstanceBufferPtr != nullptr; }
+    [[nodiscard]] uint32_t GetFirstInstance() const { return m_FirstInstance; }
+    [[nodiscard]] uint32_t GetInstanceCount() const { return m_InstanceCount; }
 
     [[nodiscard]] Material* GetMaterial() const { return m_MaterialPtr; }
 
+    // Local space, meshes without bounds are never culled
+    void SetBounds(const Bounds& bounds) { m_Bounds = bounds; }
+    [[nodiscard]] const Bounds& GetBounds() const { return m_Bounds; }
+
+    // Around the model matrix, or around every instance for instanced meshes
+    [[nodiscard]] Bounds GetWorldBounds() const;
+
+    [[nodiscard]] uint32_t GetId() const { return m_Id; }
+
+    [[nodiscard]] const GeometryBuffer* GetGeometryBuffer() const { return m_GeometryBufferPtr; }
+    [[nodiscard]] uint32_t GetFirstIndex() const { return m_FirstIndex; }
+    [[nodiscard]] uint32_t GetIndexCount() const { return m_NumIndices; }
+    [[nodiscard]] int32_t GetVertexOffset() const { return m_VertexOffset; }
+
     glm::mat4 m_ModelMatrix = glm::mat4(1.0f);  // Trivial set and get
 
 private:
@@ -66,6 +102,26 @@ private:
     Material* m_MaterialPtr;
 
     uint32_t m_NumIndices;
+
+    GeometryBuffer* m_GeometryBufferPtr{};
+    uint32_t m_FirstIndex{};
+    int32_t m_VertexOffset{};
+
+    InstanceBuffer* m_InstanceBufferPtr{};
+    uint32_t m_FirstInstance{};
+    uint32_t m_InstanceCount{};
+    uint32_t m_MaxInstanceCount{};
+
+    Bounds m_Bounds{ Bounds::Infinite() };
+
+    void WriteInstance(uint32_t instanceIndex, const glm::mat4& modelMatrix, const glm::vec4& tint);
+
+    // World bounds of every instance and the bounds around all of them
+    std::vector<Bounds> m_InstanceWorldBounds{};
+    Bounds m_InstanceBounds{};
+
+    uint32_t m_Id{ s_NextId++ };
+    inline static uint32_t s_NextId{};
 };
 
 namespace std
@@ -0,0 +1,155 @@
+#include "MipChain.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+#include "jul/CpuProfiler.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define JUL_MIP_SSE 1
+#endif
+
+namespace
+{
+    // Fine enough that every 8 bit sRGB value round trips
+    constexpr uint32_t LINEAR_TO_SRGB_SIZE{ 4'096 };
+
+    struct ConversionTables
+    {
+        std::array<float, 256> srgbToLinear;
+        std::array<uint8_t, LINEAR_TO_SRGB_SIZE> linearToSrgb;
+    };
+
+    const ConversionTables& GetConversionTables()
+    {
+        static const ConversionTables tables = []
+        {
+            ConversionTables newTables{};
+
+            for(uint32_t value = 0; value < 256; ++value)
+            {
+                const float srgb = static_cast<float>(value) / 255.0f;
+                newTables.srgbToLinear[value] =
+                    srgb <= 0.04045f ? srgb / 12.92f : std::pow((srgb + 0.055f) / 1.055f, 2.4f);
+            }
+
+            for(uint32_t index = 0; index < LINEAR_TO_SRGB_SIZE; ++index)
+            {
+                const float linear = static_cast<float>(index) / static_cast<float>(LINEAR_TO_SRGB_SIZE - 1);
+                const float srgb =
+                    linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+                newTables.linearToSrgb[index] = static_cast<uint8_t>(std::lround(srgb * 255.0f));
+            }
+
+            return newTables;
+        }();
+
+        return tables;
+    }
+
+    uint8_t QuantizeLinear(float value)
+    {
+        return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+    uint8_t QuantizeSrgb(float value)
+    {
+        const float index = std::clamp(value, 0.0f, 1.0f) * static_cast<float>(LINEAR_TO_SRGB_SIZE - 1) + 0.5f;
+        return GetConversionTables().linearToSrgb[static_cast<uint32_t>(index)];
+    }
+
+    // Averages 2x2 texels, the last row and column are repeated on odd sizes
+    void Downsample(const float* source, uint32_t sourceWidth, uint32_t sourceHeight, float* destination,
+                    uint32_t width, uint32_t height, uint32_t channelCount)
+    {
+        for(uint32_t y = 0; y < height; ++y)
+        {
+            const size_t sourceRowSize = static_cast<size_t>(sourceWidth) * channelCount;
+            const float* row0 = source + static_cast<size_t>(std::min(y * 2, sourceHeight - 1)) * sourceRowSize;
+            const float* row1 = source + static_cast<size_t>(std::min(y * 2 + 1, sourceHeight - 1)) * sourceRowSize;
+            float* destinationRow = destination + static_cast<size_t>(y) * width * channelCount;
+
+            for(uint32_t x = 0; x < width; ++x)
+            {
+                const size_t column0 = static_cast<size_t>(std::min(x * 2, sourceWidth - 1)) * channelCount;
+                const size_t column1 = static_cast<size_t>(std::min(x * 2 + 1, sourceWidth - 1)) * channelCount;
+                float* destinationTexel = destinationRow + static_cast<size_t>(x) * channelCount;
+
+#if JUL_MIP_SSE
+                if(channelCount == 4)
+                {
+                    const __m128 top = _mm_add_ps(_mm_loadu_ps(row0 + column0), _mm_loadu_ps(row0 + column1));
+                    const __m128 bottom = _mm_add_ps(_mm_loadu_ps(row1 + column0), _mm_loadu_ps(row1 + column1));
+                    _mm_storeu_ps(destinationTexel, _mm_mul_ps(_mm_add_ps(top, bottom), _mm_set1_ps(0.25f)));
+                    continue;
+                }
+#endif
+                for(size_t channel = 0; channel < channelCount; ++channel)
+                    destinationTexel[channel] = (row0[column0 + channel] + row0[column1 + channel] +
+                                                 row1[column0 + channel] + row1[column1 + channel]) *
+                                                0.25f;
+            }
+        }
+    }
+}
+
+MipChain::MipChain(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channelCount, bool srgb)
+{
+    JUL_PROFILE_ZONE("MipChain::MipChain");
+
+    const uint32_t levelCount = GetLevelCount(width, height);
+
+    size_t dataSize{};
+    for(uint32_t levelIndex = 0; levelIndex < levelCount; ++levelIndex)
+    {
+        const uint32_t levelWidth = std::max(width >> levelIndex, 1u);
+        const uint32_t levelHeight = std::max(height >> levelIndex, 1u);
+
+        m_Levels.push_back({ .width = levelWidth, .height = levelHeight, .offset = dataSize });
+        dataSize += static_cast<size_t>(levelWidth) * levelHeight * channelCount;
+    }
+
+    m_Data.resize(dataSize);
+    std::memcpy(m_Data.data(), pixels, static_cast<size_t>(width) * height * channelCount);
+
+    const ConversionTables& tables = GetConversionTables();
+
+    // Alpha is never sRGB encoded
+    std::vector<float> source(static_cast<size_t>(width) * height * channelCount);
+    for(size_t component = 0; component < source.size(); ++component)
+    {
+        const bool isColor = srgb and component % channelCount != 3;
+        source[component] =
+            isColor ? tables.srgbToLinear[pixels[component]] : static_cast<float>(pixels[component]) / 255.0f;
+    }
+
+    std::vector<float> destination{};
+    for(uint32_t levelIndex = 1; levelIndex < levelCount; ++levelIndex)
+    {
+        const Level& previousLevel = m_Levels[levelIndex - 1];
+        const Level& level = m_Levels[levelIndex];
+
+        destination.resize(static_cast<size_t>(level.width) * level.height * channelCount);
+        Downsample(source.data(), previousLevel.width, previousLevel.height, destination.data(), level.width,
+                   level.height, channelCount);
+
+        uint8_t* levelPixels = m_Data.data() + level.offset;
+        for(size_t component = 0; component < destination.size(); ++component)
+        {
+            const bool isColor = srgb and component % channelCount != 3;
+            levelPixels[component] =
+                isColor ? QuantizeSrgb(destination[component]) : QuantizeLinear(destination[component]);
+        }
+
+        std::swap(source, destination);
+    }
+}
+
+uint32_t MipChain::GetLevelCount(uint32_t width, uint32_t height)
+{
+    return static_cast<uint32_t>(std::bit_width(std::max({ width, height, 1u })));
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Full mip chain of an 8 bit image with one to four channels, for formats the GPU can't blit with linear filtering
+//
+// Every level is a 2x2 box filter of the one above it. Filtering happens on linear floats and the previous level is
+// kept in floats, so sRGB color doesn't darken and the rounding error doesn't pile up down the chain
+class MipChain final
+{
+public:
+    struct Level
+    {
+        uint32_t width;
+        uint32_t height;
+        // Into GetData, levels are tightly packed one after the other
+        size_t offset;
+    };
+
+    // The base level is copied as is, with srgb every channel but the alpha of RGBA is decoded before filtering
+    MipChain(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channelCount, bool srgb);
+
+    [[nodiscard]] const std::vector<Level>& GetLevels() const { return m_Levels; }
+    [[nodiscard]] const std::vector<uint8_t>& GetData() const { return m_Data; }
+
+    // Down to and including 1x1
+    [[nodiscard]] static uint32_t GetLevelCount(uint32_t width, uint32_t height);
+
+private:
+    std::vector<Level> m_Levels{};
+    std::vector<uint8_t> m_Data{};
+};
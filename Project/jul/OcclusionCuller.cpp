@@ -0,0 +1,500 @@
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+#include "jul/CpuProfiler.h"
+#include "jul/DescriptorAllocator.h"
+#include "jul/GpuProfiler.h"
+#include "SwapChain.h"
+#include "vulkanbase/VulkanGlobals.h"
+#include "vulkanbase/VulkanUtil.h"
+
+OcclusionCuller::OcclusionCuller()
+{
+    const VkDevice device = VulkanGlobals::GetDevice();
+    const int frameCount = VulkanGlobals::GetSwapChain().GetImageCount();
+
+    m_HiZPipeline = std::make_unique<ComputePipeline>(
+        "shaders/hizBuild.comp.spv",
+        std::vector<VkDescriptorType>{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE },
+        static_cast<uint32_t>(sizeof(HiZConstants)));
+
+    m_CullPipeline = std::make_unique<ComputePipeline>("shaders/occlusionCull.comp.spv",
+                                                       std::vector<VkDescriptorType>{
+                                                           VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                                           VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                                           VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                                           VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                                           VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                                           VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                                                       },
+                                                       static_cast<uint32_t>(sizeof(CullConstants)));
+
+    constexpr VkDeviceSize objectBufferSize{ sizeof(CullObject) * MAX_OBJECT_COUNT };
+    m_ObjectBuffers.reserve(frameCount);
+    for(int i = 0; i < frameCount; ++i)
+    {
+        m_ObjectBuffers.emplace_back(
+            std::make_unique<Buffer>(objectBufferSize,
+                                     VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+
+        m_ObjectBuffers[i]->Map(objectBufferSize);
+    }
+
+    m_VisibilityBuffer = std::make_unique<Buffer>(sizeof(uint32_t) * VISIBILITY_COUNT,
+                                                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                                      VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    m_DrawnEarlyBuffer = std::make_unique<Buffer>(
+        sizeof(uint32_t) * MAX_OBJECT_COUNT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    // Both phases get their own commands and counts
+    constexpr VkBufferUsageFlags drawBufferUsage{ VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                                  VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                                                  VK_BUFFER_USAGE_TRANSFER_DST_BIT };
+
+    m_DrawCommandBuffer = std::make_unique<Buffer>(sizeof(VkDrawIndexedIndirectCommand) * MAX_OBJECT_COUNT * 2,
+                                                   drawBufferUsage,
+                                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    m_DrawCountBuffer = std::make_unique<Buffer>(
+        sizeof(uint32_t) * MAX_BATCH_COUNT * 2, drawBufferUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    // Fetched by texel, filtering would mix depths
+    const VkSamplerCreateInfo samplerInfo{
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter = VK_FILTER_NEAREST,
+        .minFilter = VK_FILTER_NEAREST,
+        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+        .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .maxLod = VK_LOD_CLAMP_NONE,
+    };
+
+    if(vkCreateSampler(device, &samplerInfo, nullptr, &m_Sampler) != VK_SUCCESS)
+        throw std::runtime_error("failed to create occlusion culling sampler!");
+
+    // Allocated once for the deepest pyramid, a resize only writes them again
+    DescriptorAllocator& descriptorAllocator = VulkanGlobals::GetDescriptorAllocator();
+
+    m_HiZSets.reserve(MAX_HIZ_LEVEL_COUNT);
+    for(uint32_t level = 0; level < MAX_HIZ_LEVEL_COUNT; ++level)
+        m_HiZSets.push_back(descriptorAllocator.Allocate(m_HiZPipeline->GetDescriptorSetLayout()));
+
+    // Cull sets are transient, CullEarly allocates one every frame
+    m_CullSets.resize(frameCount);
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+    const VkDevice device = VulkanGlobals::GetDevice();
+
+    DestroyHiZ();
+    vkDestroySampler(device, m_Sampler, nullptr);
+}
+
+bool OcclusionCuller::IsSupported()
+{
+    const VkPhysicalDeviceFeatures& features = VulkanGlobals::GetEnabledFeatures();
+    return features.multiDrawIndirect and features.drawIndirectFirstInstance;
+}
+
+void OcclusionCuller::Clear() { m_Objects.clear(); }
+
+void OcclusionCuller::Add(const Bounds& worldBounds, uint32_t visibilityId, uint32_t batchIndex, uint32_t firstCommand,
+                          const VkDrawIndexedIndirectCommand& command)
+{
+    if(m_Objects.size() >= MAX_OBJECT_COUNT)
+        throw std::runtime_error("occlusion culler ran out of objects!");
+
+    if(batchIndex >= MAX_BATCH_COUNT)
+        throw std::runtime_error("occlusion culler ran out of batches!");
+
+    m_Objects.push_back({
+        .center = glm::vec4{ worldBounds.center, 0.0f },
+        .extents = glm::vec4{ worldBounds.extents, 0.0f },
+        .visibilityIndex = visibilityId % VISIBILITY_COUNT,
+        .batchIndex = batchIndex,
+        .firstCommand = firstCommand,
+        .indexCount = command.indexCount,
+        .firstIndex = command.firstIndex,
+        .vertexOffset = command.vertexOffset,
+        .firstInstance = command.firstInstance,
+        .instanceCount = command.instanceCount,
+    });
+}
+
+void OcclusionCuller::CullEarly(VkCommandBuffer commandBuffer, int imageIndex, const glm::mat4& viewProjection)
+{
+    JUL_PROFILE_ZONE("OcclusionCuller::CullEarly");
+    const GpuZone zone{ commandBuffer, "Occlusion Early" };
+
+    // Safe to recreate here, the previous frame is done with the pyramid
+    SwapChain& swapChain = VulkanGlobals::GetSwapChain();
+    if(swapChain.GetDepthImageView() != m_DepthImageView)
+    {
+        DestroyHiZ();
+
+        m_DepthImage = swapChain.GetDepthImage();
+        m_DepthImageView = swapChain.GetDepthImageView();
+        m_DepthExtent = swapChain.GetExtent();
+
+        CreateHiZ(commandBuffer);
+        UpdateDescriptorSets();
+    }
+
+    // The frame pools were reset after the fence wait, the late phase binds the same set
+    m_CullSets[imageIndex] = AllocateCullSet(imageIndex);
+
+    if(not m_Objects.empty())
+        m_ObjectBuffers[imageIndex]->Upload(m_Objects.data(),
+                                            static_cast<uint32_t>(m_Objects.size() * sizeof(CullObject)));
+
+    m_CullConstants = {
+        .viewProjection = viewProjection,
+        .depthSize = { static_cast<float>(m_DepthExtent.width), static_cast<float>(m_DepthExtent.height) },
+        .objectCount = static_cast<uint32_t>(m_Objects.size()),
+        .phase = 0,
+        .commandRegionSize = MAX_OBJECT_COUNT,
+        .countRegionSize = MAX_BATCH_COUNT,
+        .hiZLevelCount = static_cast<uint32_t>(m_HiZLevelExtents.size()),
+    };
+
+    // The previous frame may still be reading the commands and counts
+    GlobalBarrier(commandBuffer,
+                  VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                  VK_PIPELINE_STAGE_TRANSFER_BIT,
+                  VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+                  VK_ACCESS_TRANSFER_WRITE_BIT);
+
+    // Nothing is visible on the first frame, the late phase draws whatever passes the test
+    if(not m_VisibilityCleared)
+    {
+        vkCmdFillBuffer(commandBuffer, *m_VisibilityBuffer, 0, VK_WHOLE_SIZE, 0);
+        m_VisibilityCleared = true;
+    }
+
+    vkCmdFillBuffer(commandBuffer, *m_DrawCountBuffer, 0, VK_WHOLE_SIZE, 0);
+
+    // Without the count the whole range is drawn, the slots the shader skips have to draw nothing
+    if(VulkanGlobals::GetDrawIndexedIndirectCount() == nullptr)
+        vkCmdFillBuffer(commandBuffer, *m_DrawCommandBuffer, 0, VK_WHOLE_SIZE, 0);
+
+    GlobalBarrier(commandBuffer,
+                  VK_PIPELINE_STAGE_TRANSFER_BIT,
+                  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                  VK_ACCESS_TRANSFER_WRITE_BIT,
+                  VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+    if(not m_Objects.empty())
+    {
+        m_CullPipeline->Bind(commandBuffer, m_CullSets[imageIndex]);
+        m_CullPipeline->UpdatePushConstant(commandBuffer, &m_CullConstants, sizeof(m_CullConstants));
+        vkCmdDispatch(commandBuffer, (m_CullConstants.objectCount + 63) / 64, 1, 1);
+    }
+
+    GlobalBarrier(commandBuffer,
+                  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                  VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                  VK_ACCESS_SHADER_WRITE_BIT,
+                  VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+}
+
+void OcclusionCuller::CullLate(VkCommandBuffer commandBuffer, int imageIndex)
+{
+    JUL_PROFILE_ZONE("OcclusionCuller::CullLate");
+
+    if(m_Objects.empty())
+        return;
+
+    const GpuZone zone{ commandBuffer, "Occlusion Late" };
+
+    DepthBarrier(commandBuffer,
+                 VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                 VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                 VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                 VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                 VK_ACCESS_SHADER_READ_BIT);
+
+    {
+        const GpuZone hiZZone{ commandBuffer, "HiZ Build" };
+
+        VkExtent2D sourceExtent = m_DepthExtent;
+        for(size_t level = 0; level < m_HiZLevelExtents.size(); ++level)
+        {
+            const VkExtent2D levelExtent = m_HiZLevelExtents[level];
+
+            const HiZConstants constants{
+                .sourceSize = { sourceExtent.width, sourceExtent.height },
+                .destinationSize = { levelExtent.width, levelExtent.height },
+                .sourceLevel = level == 0 ? 0 : static_cast<int32_t>(level) - 1,
+            };
+
+            m_HiZPipeline->Bind(commandBuffer, m_HiZSets[level]);
+            m_HiZPipeline->UpdatePushConstant(commandBuffer, &constants, sizeof(constants));
+            vkCmdDispatch(commandBuffer, (levelExtent.width + 7) / 8, (levelExtent.height + 7) / 8, 1);
+
+            // The next level reads this one
+            GlobalBarrier(commandBuffer,
+                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                          VK_ACCESS_SHADER_WRITE_BIT,
+                          VK_ACCESS_SHADER_READ_BIT);
+
+            sourceExtent = levelExtent;
+        }
+    }
+
+    m_CullConstants.phase = 1;
+    m_CullPipeline->Bind(commandBuffer, m_CullSets[imageIndex]);
+    m_CullPipeline->UpdatePushConstant(commandBuffer, &m_CullConstants, sizeof(m_CullConstants));
+    vkCmdDispatch(commandBuffer, (m_CullConstants.objectCount + 63) / 64, 1, 1);
+
+    GlobalBarrier(commandBuffer,
+                  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                  VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                  VK_ACCESS_SHADER_WRITE_BIT,
+                  VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+
+    DepthBarrier(commandBuffer,
+                 VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                 VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                 VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                 VK_ACCESS_SHADER_READ_BIT,
+                 VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+}
+
+void OcclusionCuller::DrawBatch(VkCommandBuffer commandBuffer, Phase phase, uint32_t batchIndex, uint32_t firstCommand,
+                                uint32_t commandCount)
+{
+    constexpr uint32_t stride{ sizeof(VkDrawIndexedIndirectCommand) };
+    const uint32_t region = phase == Phase::Late ? 1 : 0;
+
+    const VkDeviceSize commandOffset = static_cast<VkDeviceSize>(region * MAX_OBJECT_COUNT + firstCommand) * stride;
+
+    if(const PFN_vkCmdDrawIndexedIndirectCountKHR drawIndexedIndirectCount =
+           VulkanGlobals::GetDrawIndexedIndirectCount())
+    {
+        const VkDeviceSize countOffset = static_cast<VkDeviceSize>(region * MAX_BATCH_COUNT + batchIndex) *
+                                         sizeof(uint32_t);
+
+        drawIndexedIndirectCount(commandBuffer,
+                                 *m_DrawCommandBuffer,
+                                 commandOffset,
+                                 *m_DrawCountBuffer,
+                                 countOffset,
+                                 commandCount,
+                                 stride);
+        return;
+    }
+
+    vkCmdDrawIndexedIndirect(commandBuffer, *m_DrawCommandBuffer, commandOffset, commandCount, stride);
+}
+
+void OcclusionCuller::CreateHiZ(VkCommandBuffer commandBuffer)
+{
+    const VkDevice device = VulkanGlobals::GetDevice();
+
+    VkExtent2D levelExtent = m_DepthExtent;
+    do
+    {
+        levelExtent = { std::max((levelExtent.width + 1) / 2, 1u), std::max((levelExtent.height + 1) / 2, 1u) };
+        m_HiZLevelExtents.push_back(levelExtent);
+    } while((levelExtent.width > 1 or levelExtent.height > 1) and m_HiZLevelExtents.size() < MAX_HIZ_LEVEL_COUNT);
+
+    const auto levelCount = static_cast<uint32_t>(m_HiZLevelExtents.size());
+
+    const VkImageCreateInfo imageInfo{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = VK_FORMAT_R32_SFLOAT,
+        .extent = { m_HiZLevelExtents[0].width, m_HiZLevelExtents[0].height, 1 },
+        .mipLevels = levelCount,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+
+    if(vkCreateImage(device, &imageInfo, nullptr, &m_HiZImage) != VK_SUCCESS)
+        throw std::runtime_error("failed to create HiZ image!");
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetImageMemoryRequirements(device, m_HiZImage, &memoryRequirements);
+
+    const VkMemoryAllocateInfo allocateInfo{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .allocationSize = memoryRequirements.size,
+        .memoryTypeIndex =
+            vulkanUtil::FindMemoryType(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT),
+    };
+
+    if(vkAllocateMemory(device, &allocateInfo, nullptr, &m_HiZImageMemory) != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate HiZ image memory!");
+
+    vkBindImageMemory(device, m_HiZImage, m_HiZImageMemory, 0);
+
+    // One view over every level for sampling, one per level for writing
+    auto createView = [this, device](uint32_t baseLevel, uint32_t viewLevelCount)
+    {
+        const VkImageViewCreateInfo viewInfo{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .image = m_HiZImage,
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = VK_FORMAT_R32_SFLOAT,
+            .subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, baseLevel, viewLevelCount, 0, 1 },
+        };
+
+        VkImageView view{};
+        if(vkCreateImageView(device, &viewInfo, nullptr, &view) != VK_SUCCESS)
+            throw std::runtime_error("failed to create HiZ image view!");
+
+        return view;
+    };
+
+    m_HiZImageView = createView(0, levelCount);
+    for(uint32_t level = 0; level < levelCount; ++level)
+        m_HiZLevelViews.push_back(createView(level, 1));
+
+    // The pyramid stays in the general layout, it is written and sampled by compute only
+    const VkImageMemoryBarrier barrier{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = 0,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = m_HiZImage,
+        .subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount, 0, 1 },
+    };
+
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr,
+                         1,
+                         &barrier);
+}
+
+void OcclusionCuller::DestroyHiZ()
+{
+    const VkDevice device = VulkanGlobals::GetDevice();
+
+    for(const VkImageView levelView : m_HiZLevelViews)
+        vkDestroyImageView(device, levelView, nullptr);
+
+    vkDestroyImageView(device, m_HiZImageView, nullptr);
+    vkDestroyImage(device, m_HiZImage, nullptr);
+    vkFreeMemory(device, m_HiZImageMemory, nullptr);
+
+    m_HiZLevelViews.clear();
+    m_HiZLevelExtents.clear();
+    m_HiZImageView = VK_NULL_HANDLE;
+    m_HiZImage = VK_NULL_HANDLE;
+    m_HiZImageMemory = VK_NULL_HANDLE;
+}
+
+void OcclusionCuller::UpdateDescriptorSets()
+{
+    const DescriptorAllocator& descriptorAllocator = VulkanGlobals::GetDescriptorAllocator();
+    const auto levelCount = static_cast<uint32_t>(m_HiZLevelExtents.size());
+
+    for(uint32_t level = 0; level < levelCount; ++level)
+    {
+        // The first level reduces the depth attachment, the others the level before them
+        const std::array<VkDescriptorImageInfo, 2> imageInfos{
+            VkDescriptorImageInfo{
+                .sampler = m_Sampler,
+                .imageView = level == 0 ? m_DepthImageView : m_HiZImageView,
+                .imageLayout = level == 0 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL,
+            },
+            VkDescriptorImageInfo{
+                .imageView = m_HiZLevelViews[level],
+                .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+            },
+        };
+
+        descriptorAllocator.Write(m_HiZSets[level], m_HiZPipeline->GetDescriptorSetLayout(), imageInfos.data());
+    }
+}
+
+VkDescriptorSet OcclusionCuller::AllocateCullSet(int imageIndex) const
+{
+    DescriptorAllocator& descriptorAllocator = VulkanGlobals::GetDescriptorAllocator();
+    const VkDescriptorSetLayout layout = m_CullPipeline->GetDescriptorSetLayout();
+
+    // Laid out in binding order for the update template
+    struct CullDescriptors
+    {
+        std::array<VkDescriptorBufferInfo, 5> buffers;
+        VkDescriptorImageInfo hiZ;
+    };
+
+    const CullDescriptors cullDescriptors{
+        .buffers = {
+            VkDescriptorBufferInfo{ *m_ObjectBuffers[imageIndex], 0, VK_WHOLE_SIZE },
+            VkDescriptorBufferInfo{ *m_VisibilityBuffer, 0, VK_WHOLE_SIZE },
+            VkDescriptorBufferInfo{ *m_DrawnEarlyBuffer, 0, VK_WHOLE_SIZE },
+            VkDescriptorBufferInfo{ *m_DrawCommandBuffer, 0, VK_WHOLE_SIZE },
+            VkDescriptorBufferInfo{ *m_DrawCountBuffer, 0, VK_WHOLE_SIZE },
+        },
+        .hiZ = {
+            .sampler = m_Sampler,
+            .imageView = m_HiZImageView,
+            .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+        },
+    };
+
+    const VkDescriptorSet cullSet = descriptorAllocator.AllocateTransient(imageIndex, layout);
+    descriptorAllocator.Write(cullSet, layout, &cullDescriptors);
+    return cullSet;
+}
+
+void OcclusionCuller::DepthBarrier(VkCommandBuffer commandBuffer, VkImageLayout oldLayout, VkImageLayout newLayout,
+                                   VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage,
+                                   VkAccessFlags srcAccess, VkAccessFlags dstAccess) const
+{
+    VkImageAspectFlags aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+    if(vulkanUtil::HasStencilComponent(vulkanUtil::FindDepthFormat()))
+        aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+
+    const VkImageMemoryBarrier barrier{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = srcAccess,
+        .dstAccessMask = dstAccess,
+        .oldLayout = oldLayout,
+        .newLayout = newLayout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = m_DepthImage,
+        .subresourceRange = { aspectMask, 0, 1, 0, 1 },
+    };
+
+    vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+void OcclusionCuller::GlobalBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStage,
+                                    VkPipelineStageFlags dstStage, VkAccessFlags srcAccess, VkAccessFlags dstAccess)
+{
+    const VkMemoryBarrier barrier{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = srcAccess,
+        .dstAccessMask = dstAccess,
+    };
+
+    vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
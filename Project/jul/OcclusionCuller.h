@@ -0,0 +1,144 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <glm/mat4x4.hpp>
+#include <memory>
+#include <vector>
+
+#include "Bounds.h"
+#include "Buffer.h"
+#include "ComputePipeline.h"
+
+// Two phase occlusion culling against a hierarchical depth buffer, visibility never leaves the GPU
+//
+// Early: objects that were visible last frame are drawn
+// Late:  the early depth is reduced to a max depth pyramid (HiZ) and every object is tested against it,
+//        objects the early phase missed are drawn and the results become next frame's visible set
+//
+// An object is one indirect command, every batch owns the same command range in both phases
+// The cull shader appends into that range and counts the batch with an atomic, the count drives the draw
+class OcclusionCuller final
+{
+public:
+    enum class Phase
+    {
+        Early,
+        Late,
+    };
+
+    // Matches CullObject in occlusionCull.comp
+    struct CullObject
+    {
+        glm::vec4 center;
+        glm::vec4 extents;
+        uint32_t visibilityIndex;
+        uint32_t batchIndex;
+        uint32_t firstCommand;
+        uint32_t indexCount;
+        uint32_t firstIndex;
+        int32_t vertexOffset;
+        uint32_t firstInstance;
+        uint32_t instanceCount;
+    };
+
+    static_assert(sizeof(CullObject) == 64);
+
+    OcclusionCuller();
+    ~OcclusionCuller();
+
+    OcclusionCuller(OcclusionCuller&&) = delete;
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    OcclusionCuller& operator=(OcclusionCuller&&) = delete;
+    OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+    // The culled commands are drawn with a single multi draw that has to pick its first instance
+    [[nodiscard]] static bool IsSupported();
+
+    void Clear();
+
+    // The visibility id has to be the same every frame for the same object
+    void Add(const Bounds& worldBounds, uint32_t visibilityId, uint32_t batchIndex, uint32_t firstCommand,
+             const VkDrawIndexedIndirectCommand& command);
+
+    // Recorded before the first render pass
+    void CullEarly(VkCommandBuffer commandBuffer, int imageIndex, const glm::mat4& viewProjection);
+
+    // Recorded between the render passes, reads the depth the early phase wrote
+    void CullLate(VkCommandBuffer commandBuffer, int imageIndex);
+
+    void DrawBatch(VkCommandBuffer commandBuffer, Phase phase, uint32_t batchIndex, uint32_t firstCommand,
+                   uint32_t commandCount);
+
+    [[nodiscard]] uint32_t GetObjectCount() const { return static_cast<uint32_t>(m_Objects.size()); }
+
+    inline static constexpr uint32_t MAX_OBJECT_COUNT{ 4'096 };
+    inline static constexpr uint32_t MAX_BATCH_COUNT{ 256 };
+    inline static constexpr uint32_t VISIBILITY_COUNT{ 1 << 16 };
+    inline static constexpr uint32_t MAX_HIZ_LEVEL_COUNT{ 16 };
+
+private:
+    // Matches the push constants in occlusionCull.comp
+    struct CullConstants
+    {
+        glm::mat4 viewProjection;
+        glm::vec2 depthSize;
+        uint32_t objectCount;
+        uint32_t phase;
+        uint32_t commandRegionSize;
+        uint32_t countRegionSize;
+        uint32_t hiZLevelCount;
+    };
+
+    // Matches the push constants in hizBuild.comp
+    struct HiZConstants
+    {
+        glm::ivec2 sourceSize;
+        glm::ivec2 destinationSize;
+        int32_t sourceLevel;
+    };
+
+    void CreateHiZ(VkCommandBuffer commandBuffer);
+    void DestroyHiZ();
+    void UpdateDescriptorSets();
+    [[nodiscard]] VkDescriptorSet AllocateCullSet(int imageIndex) const;
+
+    void DepthBarrier(VkCommandBuffer commandBuffer, VkImageLayout oldLayout, VkImageLayout newLayout,
+                      VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage, VkAccessFlags srcAccess,
+                      VkAccessFlags dstAccess) const;
+
+    static void GlobalBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStage,
+                              VkPipelineStageFlags dstStage, VkAccessFlags srcAccess, VkAccessFlags dstAccess);
+
+    std::unique_ptr<ComputePipeline> m_HiZPipeline{};
+    std::unique_ptr<ComputePipeline> m_CullPipeline{};
+
+    std::vector<CullObject> m_Objects{};
+    std::vector<std::unique_ptr<Buffer>> m_ObjectBuffers{};
+
+    std::unique_ptr<Buffer> m_VisibilityBuffer{};
+    std::unique_ptr<Buffer> m_DrawnEarlyBuffer{};
+    std::unique_ptr<Buffer> m_DrawCommandBuffer{};
+    std::unique_ptr<Buffer> m_DrawCountBuffer{};
+    bool m_VisibilityCleared{};
+
+    VkSampler m_Sampler{};
+    std::vector<VkDescriptorSet> m_HiZSets{};
+    // Transient, valid until the image comes around again
+    std::vector<VkDescriptorSet> m_CullSets{};
+
+    // Level 0 is half the depth resolution, every level after that halves again rounding up
+    VkImage m_HiZImage{};
+    VkDeviceMemory m_HiZImageMemory{};
+    VkImageView m_HiZImageView{};
+    std::vector<VkImageView> m_HiZLevelViews{};
+    std::vector<VkExtent2D> m_HiZLevelExtents{};
+
+    // The depth attachment the pyramid was created for, it changes when the swap chain is recreated
+    VkImage m_DepthImage{};
+    VkImageView m_DepthImageView{};
+    VkExtent2D m_DepthExtent{};
+
+    CullConstants m_CullConstants{};
+};
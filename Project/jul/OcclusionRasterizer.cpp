@@ -0,0 +1,308 @@
+#include "OcclusionRasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "jul/CpuProfiler.h"
+#include "ThreadPool.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define JUL_RASTER_SSE 1
+#endif
+
+OcclusionRasterizer::OcclusionRasterizer(uint32_t width, uint32_t height, ThreadPool* threadPool) :
+    m_Width(width),
+    m_Height(height),
+    m_TileCountX(width / TILE_WIDTH),
+    m_TileCountY(height / TILE_HEIGHT),
+    m_ThreadPoolPtr(threadPool)
+{
+    // Rows are filled four pixels at a time and tiles may not be partial
+    if(width == 0 or height == 0 or width % TILE_WIDTH != 0 or height % TILE_HEIGHT != 0)
+        throw std::runtime_error("occlusion rasterizer size has to be a multiple of the tile size!");
+
+    m_Depth.resize(static_cast<size_t>(m_Width) * m_Height, CLEAR_DEPTH);
+    m_TileMaxDepth.resize(static_cast<size_t>(m_TileCountX) * m_TileCountY, CLEAR_DEPTH);
+    m_TileRowTriangles.resize(m_TileCountY);
+}
+
+uint32_t OcclusionRasterizer::AddOccluderMesh(OccluderMesh&& occluderMesh)
+{
+    m_OccluderMeshes.push_back(std::move(occluderMesh));
+    return static_cast<uint32_t>(m_OccluderMeshes.size() - 1);
+}
+
+void OcclusionRasterizer::Clear(const glm::mat4& viewProjection)
+{
+    m_ViewProjection = viewProjection;
+    m_Occluders.clear();
+}
+
+void OcclusionRasterizer::AddOccluder(uint32_t occluderMeshId, const glm::mat4& modelMatrix)
+{
+    m_Occluders.push_back({ occluderMeshId, modelMatrix });
+}
+
+void OcclusionRasterizer::Rasterize()
+{
+    JUL_PROFILE_ZONE("OcclusionRasterizer::Rasterize");
+
+    m_Triangles.clear();
+    for(std::vector<uint32_t>& tileRowTriangles : m_TileRowTriangles)
+        tileRowTriangles.clear();
+
+    {
+        JUL_PROFILE_ZONE("OcclusionRasterizer::Setup");
+
+        for(const OccluderInstance& occluder : m_Occluders)
+        {
+            const OccluderMesh& occluderMesh = m_OccluderMeshes[occluder.meshId];
+            const glm::mat4 modelViewProjection = m_ViewProjection * occluder.modelMatrix;
+
+            m_ClipPositions.resize(occluderMesh.positions.size());
+            for(size_t vertex = 0; vertex < occluderMesh.positions.size(); ++vertex)
+                m_ClipPositions[vertex] = modelViewProjection * glm::vec4{ occluderMesh.positions[vertex], 1.0f };
+
+            for(size_t index = 0; index + 2 < occluderMesh.indices.size(); index += 3)
+            {
+                SetupTriangle(m_ClipPositions[occluderMesh.indices[index]],
+                              m_ClipPositions[occluderMesh.indices[index + 1]],
+                              m_ClipPositions[occluderMesh.indices[index + 2]]);
+            }
+        }
+    }
+
+    // Every tile row only touches its own pixels and tiles, so the rows need no locking
+    if(m_ThreadPoolPtr != nullptr)
+    {
+        m_ThreadPoolPtr->ParallelFor(m_TileCountY, [this](uint32_t tileY) { RasterizeTileRow(tileY); });
+    }
+    else
+    {
+        for(uint32_t tileY = 0; tileY < m_TileCountY; ++tileY)
+            RasterizeTileRow(tileY);
+    }
+}
+
+bool OcclusionRasterizer::IsVisible(const Bounds& worldBounds) const
+{
+    if(worldBounds.IsInfinite())
+        return true;
+
+    const glm::vec3 boxMin = worldBounds.GetMin();
+    const glm::vec3 boxMax = worldBounds.GetMax();
+
+    glm::vec2 screenMin{ std::numeric_limits<float>::max() };
+    glm::vec2 screenMax{ std::numeric_limits<float>::lowest() };
+    float nearestDepth{ std::numeric_limits<float>::max() };
+
+    for(int corner = 0; corner < 8; ++corner)
+    {
+        const glm::vec3 position{ corner & 1 ? boxMax.x : boxMin.x,
+                                  corner & 2 ? boxMax.y : boxMin.y,
+                                  corner & 4 ? boxMax.z : boxMin.z };
+
+        const glm::vec4 clipPosition = m_ViewProjection * glm::vec4{ position, 1.0f };
+
+        // The box reaches behind the camera, its projection is unbounded
+        if(clipPosition.w <= NEAR_W)
+            return true;
+
+        const glm::vec3 ndc = glm::vec3{ clipPosition } / clipPosition.w;
+        const glm::vec2 pixel{ (ndc.x * 0.5f + 0.5f) * static_cast<float>(m_Width),
+                               (ndc.y * 0.5f + 0.5f) * static_cast<float>(m_Height) };
+
+        screenMin = glm::min(screenMin, pixel);
+        screenMax = glm::max(screenMax, pixel);
+        nearestDepth = std::min(nearestDepth, ndc.z);
+    }
+
+    // Every pixel the box touches counts, even partially
+    const int minX = std::max(static_cast<int>(std::floor(screenMin.x)), 0);
+    const int minY = std::max(static_cast<int>(std::floor(screenMin.y)), 0);
+    const int maxX = std::min(static_cast<int>(std::floor(screenMax.x)), static_cast<int>(m_Width) - 1);
+    const int maxY = std::min(static_cast<int>(std::floor(screenMax.y)), static_cast<int>(m_Height) - 1);
+
+    // Off screen
+    if(minX > maxX or minY > maxY)
+        return false;
+
+    for(int tileY = minY / static_cast<int>(TILE_HEIGHT); tileY <= maxY / static_cast<int>(TILE_HEIGHT); ++tileY)
+    {
+        for(int tileX = minX / static_cast<int>(TILE_WIDTH); tileX <= maxX / static_cast<int>(TILE_WIDTH); ++tileX)
+        {
+            // Everything in the tile is closer than the box
+            if(m_TileMaxDepth[tileY * m_TileCountX + tileX] < nearestDepth)
+                continue;
+
+            const int beginY = std::max(minY, tileY * static_cast<int>(TILE_HEIGHT));
+            const int endY = std::min(maxY + 1, (tileY + 1) * static_cast<int>(TILE_HEIGHT));
+            const int beginX = std::max(minX, tileX * static_cast<int>(TILE_WIDTH));
+            const int endX = std::min(maxX + 1, (tileX + 1) * static_cast<int>(TILE_WIDTH));
+
+            for(int y = beginY; y < endY; ++y)
+                for(int x = beginX; x < endX; ++x)
+                    if(m_Depth[y * m_Width + x] >= nearestDepth)
+                        return true;
+        }
+    }
+
+    return false;
+}
+
+void OcclusionRasterizer::SetupTriangle(const glm::vec4& clip0, const glm::vec4& clip1, const glm::vec4& clip2)
+{
+    if(clip0.w <= NEAR_W or clip1.w <= NEAR_W or clip2.w <= NEAR_W)
+        return;
+
+    auto toScreen = [this](const glm::vec4& clipPosition)
+    {
+        const glm::vec3 ndc = glm::vec3{ clipPosition } / clipPosition.w;
+        return glm::vec3{ (ndc.x * 0.5f + 0.5f) * static_cast<float>(m_Width),
+                          (ndc.y * 0.5f + 0.5f) * static_cast<float>(m_Height),
+                          ndc.z };
+    };
+
+    glm::vec3 screen0 = toScreen(clip0);
+    glm::vec3 screen1 = toScreen(clip1);
+    glm::vec3 screen2 = toScreen(clip2);
+
+    float area = (screen1.x - screen0.x) * (screen2.y - screen0.y) - (screen1.y - screen0.y) * (screen2.x - screen0.x);
+
+    // Occluders are rasterized from both sides, flip to the winding the edge functions expect
+    if(area < 0.0f)
+    {
+        std::swap(screen1, screen2);
+        area = -area;
+    }
+
+    if(area < std::numeric_limits<float>::epsilon())
+        return;
+
+    Triangle triangle{
+        .minX = std::max(static_cast<int>(std::floor(std::min({ screen0.x, screen1.x, screen2.x }))), 0),
+        .maxX = std::min(static_cast<int>(std::ceil(std::max({ screen0.x, screen1.x, screen2.x }))),
+                         static_cast<int>(m_Width) - 1),
+        .minY = std::max(static_cast<int>(std::floor(std::min({ screen0.y, screen1.y, screen2.y }))), 0),
+        .maxY = std::min(static_cast<int>(std::ceil(std::max({ screen0.y, screen1.y, screen2.y }))),
+                         static_cast<int>(m_Height) - 1),
+    };
+
+    if(triangle.minX > triangle.maxX or triangle.minY > triangle.maxY)
+        return;
+
+    auto edge = [](const glm::vec3& from, const glm::vec3& to)
+    { return glm::vec3{ from.y - to.y, to.x - from.x, from.x * to.y - from.y * to.x }; };
+
+    triangle.edges = { edge(screen0, screen1), edge(screen1, screen2), edge(screen2, screen0) };
+
+    // Depth is linear in screen space after the perspective divide
+    const float depthDeltaX = ((screen1.z - screen0.z) * (screen2.y - screen0.y) -
+                               (screen2.z - screen0.z) * (screen1.y - screen0.y)) /
+                              area;
+    const float depthDeltaY = ((screen2.z - screen0.z) * (screen1.x - screen0.x) -
+                               (screen1.z - screen0.z) * (screen2.x - screen0.x)) /
+                              area;
+
+    triangle.depthPlane = { depthDeltaX, depthDeltaY, screen0.z - depthDeltaX * screen0.x - depthDeltaY * screen0.y };
+
+    const auto triangleIndex = static_cast<uint32_t>(m_Triangles.size());
+    m_Triangles.push_back(triangle);
+
+    for(int tileY = triangle.minY / static_cast<int>(TILE_HEIGHT); tileY <= triangle.maxY / static_cast<int>(TILE_HEIGHT);
+        ++tileY)
+        m_TileRowTriangles[tileY].push_back(triangleIndex);
+}
+
+void OcclusionRasterizer::RasterizeTileRow(uint32_t tileY)
+{
+    JUL_PROFILE_ZONE("OcclusionRasterizer::RasterizeTileRow");
+
+    const int rowBegin = static_cast<int>(tileY * TILE_HEIGHT);
+    const int rowEnd = rowBegin + static_cast<int>(TILE_HEIGHT);
+
+    std::fill(m_Depth.begin() + static_cast<ptrdiff_t>(rowBegin) * m_Width,
+              m_Depth.begin() + static_cast<ptrdiff_t>(rowEnd) * m_Width,
+              CLEAR_DEPTH);
+
+    for(const uint32_t triangleIndex : m_TileRowTriangles[tileY])
+    {
+        const Triangle& triangle = m_Triangles[triangleIndex];
+
+        for(int y = std::max(triangle.minY, rowBegin); y <= std::min(triangle.maxY, rowEnd - 1); ++y)
+            RasterizeRow(triangle, y, triangle.minX, triangle.maxX);
+    }
+
+    for(uint32_t tileX = 0; tileX < m_TileCountX; ++tileX)
+    {
+        float maxDepth{ std::numeric_limits<float>::lowest() };
+
+        for(int y = rowBegin; y < rowEnd; ++y)
+        {
+            const auto rowIt = m_Depth.begin() + static_cast<ptrdiff_t>(y) * m_Width + tileX * TILE_WIDTH;
+            maxDepth = std::max(maxDepth, *std::max_element(rowIt, rowIt + TILE_WIDTH));
+        }
+
+        m_TileMaxDepth[tileY * m_TileCountX + tileX] = maxDepth;
+    }
+}
+
+// Samples at pixel centers, a pixel is covered when every edge function is positive
+void OcclusionRasterizer::RasterizeRow(const Triangle& triangle, int y, int minX, int maxX)
+{
+    const float centerY = static_cast<float>(y) + 0.5f;
+    float* rowPtr = &m_Depth[static_cast<size_t>(y) * m_Width];
+
+    const std::array<glm::vec3, 3>& edges = triangle.edges;
+    const glm::vec3& depthPlane = triangle.depthPlane;
+
+    // Start on a multiple of four, the width is a multiple of the tile width so a group never crosses the row
+    const int beginX = minX & ~3;
+
+#if JUL_RASTER_SSE
+    const __m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+    const __m128 zero = _mm_setzero_ps();
+
+    const __m128 edge0A = _mm_set1_ps(edges[0].x);
+    const __m128 edge1A = _mm_set1_ps(edges[1].x);
+    const __m128 edge2A = _mm_set1_ps(edges[2].x);
+    const __m128 edge0Row = _mm_set1_ps(edges[0].y * centerY + edges[0].z);
+    const __m128 edge1Row = _mm_set1_ps(edges[1].y * centerY + edges[1].z);
+    const __m128 edge2Row = _mm_set1_ps(edges[2].y * centerY + edges[2].z);
+    const __m128 depthA = _mm_set1_ps(depthPlane.x);
+    const __m128 depthRow = _mm_set1_ps(depthPlane.y * centerY + depthPlane.z);
+
+    for(int x = beginX; x <= maxX; x += 4)
+    {
+        const __m128 centerX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+
+        const __m128 inside =
+            _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edge0A, centerX), edge0Row), zero),
+                                  _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edge1A, centerX), edge1Row), zero)),
+                       _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edge2A, centerX), edge2Row), zero));
+
+        const __m128 depth = _mm_add_ps(_mm_mul_ps(depthA, centerX), depthRow);
+        const __m128 current = _mm_loadu_ps(rowPtr + x);
+
+        const __m128 write = _mm_and_ps(inside, _mm_cmplt_ps(depth, current));
+        _mm_storeu_ps(rowPtr + x, _mm_or_ps(_mm_and_ps(write, depth), _mm_andnot_ps(write, current)));
+    }
+
+#else
+    for(int x = beginX; x <= maxX; ++x)
+    {
+        const float centerX = static_cast<float>(x) + 0.5f;
+
+        bool inside = true;
+        for(const glm::vec3& edge : edges)
+            inside = inside and edge.x * centerX + edge.y * centerY + edge.z >= 0.0f;
+
+        const float depth = depthPlane.x * centerX + depthPlane.y * centerY + depthPlane.z;
+        if(inside and depth < rowPtr[x])
+            rowPtr[x] = depth;
+    }
+#endif
+}
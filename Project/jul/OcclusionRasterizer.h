@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <vector>
+
+#include "Bounds.h"
+
+class ThreadPool;
+
+// Software depth rasterizer for occlusion culling on the CPU, it needs no GPU so it works on any device
+//
+// Occluders are rasterized into a low resolution depth buffer, every row of tiles is its own task
+// and is filled four pixels at a time with SSE. Each tile keeps its farthest depth, so most bounds tests
+// are decided without reading a single pixel
+//
+// Depth is z / w of the view projection, smaller is closer
+class OcclusionRasterizer final
+{
+public:
+    struct OccluderMesh
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<uint32_t> indices;
+    };
+
+    // Without a thread pool every tile row is rasterized on the calling thread
+    OcclusionRasterizer(uint32_t width, uint32_t height, ThreadPool* threadPool = nullptr);
+
+    // Occluders should be simplified meshes, returns the id to add instances of it with
+    uint32_t AddOccluderMesh(OccluderMesh&& occluderMesh);
+
+    void Clear(const glm::mat4& viewProjection);
+    void AddOccluder(uint32_t occluderMeshId, const glm::mat4& modelMatrix);
+    void Rasterize();
+
+    // Conservative, only false when every pixel the box covers has an occluder in front of it
+    [[nodiscard]] bool IsVisible(const Bounds& worldBounds) const;
+
+    [[nodiscard]] float GetDepth(uint32_t x, uint32_t y) const { return m_Depth[y * m_Width + x]; }
+    [[nodiscard]] uint32_t GetWidth() const { return m_Width; }
+    [[nodiscard]] uint32_t GetHeight() const { return m_Height; }
+    [[nodiscard]] uint32_t GetTriangleCount() const { return static_cast<uint32_t>(m_Triangles.size()); }
+
+    inline static constexpr uint32_t TILE_WIDTH{ 8 };
+    inline static constexpr uint32_t TILE_HEIGHT{ 8 };
+    inline static constexpr float CLEAR_DEPTH{ 1.0f };
+
+    // Triangles with a vertex this close to the camera plane are skipped, fewer occluders is always safe
+    inline static constexpr float NEAR_W{ 1e-4f };
+
+private:
+    struct OccluderInstance
+    {
+        uint32_t meshId;
+        glm::mat4 modelMatrix;
+    };
+
+    // Edges are a * x + b * y + c and positive inside, depth is depthPlane.x * x + depthPlane.y * y + depthPlane.z
+    struct Triangle
+    {
+        std::array<glm::vec3, 3> edges;
+        glm::vec3 depthPlane;
+        int minX;
+        int maxX;
+        int minY;
+        int maxY;
+    };
+
+    void SetupTriangle(const glm::vec4& clip0, const glm::vec4& clip1, const glm::vec4& clip2);
+    void RasterizeTileRow(uint32_t tileY);
+    void RasterizeRow(const Triangle& triangle, int y, int minX, int maxX);
+
+    uint32_t m_Width;
+    uint32_t m_Height;
+    uint32_t m_TileCountX;
+    uint32_t m_TileCountY;
+    ThreadPool* m_ThreadPoolPtr;
+
+    glm::mat4 m_ViewProjection{ 1.0f };
+
+    std::vector<OccluderMesh> m_OccluderMeshes{};
+    std::vector<OccluderInstance> m_Occluders{};
+
+    std::vector<glm::vec4> m_ClipPositions{};
+    std::vector<Triangle> m_Triangles{};
+    std::vector<std::vector<uint32_t>> m_TileRowTriangles{};
+
+    std::vector<float> m_Depth{};
+    std::vector<float> m_TileMaxDepth{};
+};
@@ -1,155 +1,110 @@
 #include "Pipeline.h"
 
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#include "CpuProfiler.h"
+#include "FrameUniforms.h"
 #include "SwapChain.h"
 #include "vulkanbase/VulkanGlobals.h"
 
-Pipeline::Pipeline(const Shader& shader, VkPipelineVertexInputStateCreateInfo pipelineVertexInputStateInfo,
-                   VkDeviceSize uboSize, uint32_t pushConstantSize,
-                   std::optional<VkDescriptorSetLayout> materialSetLayout, VkCullModeFlagBits cullMode,
-                   VkBool32 depthTestEnable, VkBool32 depthWriteEnable) :
+Pipeline::Pipeline(const PipelineDescription& description, const FrameUniforms& frameUniforms,
+                   ThreadPool* threadPool) :
+    m_Description(description),
+    m_FrameUniformsPtr(&frameUniforms),
+    m_ThreadPoolPtr(threadPool),
     m_RenderPass(*&VulkanGlobals::GetRederPass())
 {
-    CreateDescriptorSetLayout();
-    CreateUniformbuffers(VulkanGlobals::GetSwapChain().GetImageCount(), uboSize);
-
-
-    const VkPipelineViewportStateCreateInfo viewportState{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
-        .viewportCount = 1,
-        .scissorCount = 1,
-    };
-
-    const VkPipelineRasterizationStateCreateInfo rasterizer{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
-        .depthClampEnable = VK_FALSE,
-        .rasterizerDiscardEnable = VK_FALSE,
-        .polygonMode = VK_POLYGON_MODE_FILL,
-        .cullMode = static_cast<VkCullModeFlags>(cullMode),
-        .frontFace = VK_FRONT_FACE_CLOCKWISE,
-        .depthBiasEnable = VK_FALSE,
-        .lineWidth = 1.0f,
-    };
-
-    const VkPipelineMultisampleStateCreateInfo multisampling{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
-        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
-        .sampleShadingEnable = VK_FALSE,
-    };
-
-    const VkPipelineDepthStencilStateCreateInfo depthStencil{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
-        .depthTestEnable = depthTestEnable,
-        .depthWriteEnable = depthWriteEnable,
-        .depthCompareOp = VK_COMPARE_OP_LESS,
-        .depthBoundsTestEnable = VK_FALSE,
-        .stencilTestEnable = VK_FALSE,
-        .front = {},
-        .back = {},
-        .minDepthBounds = 0.f,
-        .maxDepthBounds = 1.f,
-    };
-
-
-    const VkPipelineColorBlendAttachmentState colorBlendAttachment{
-        .blendEnable = VK_FALSE,
-        .colorWriteMask =
-            VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
-    };
-
-    const VkPipelineColorBlendStateCreateInfo colorBlending{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
-        .logicOpEnable = VK_FALSE,
-        .logicOp = VK_LOGIC_OP_COPY,
-        .attachmentCount = 1,
-        .pAttachments = &colorBlendAttachment,
-    };
-
-
-    std::vector<VkDynamicState> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
-    const VkPipelineDynamicStateCreateInfo dynamicState{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
-        .dynamicStateCount = static_cast<uint32_t>(dynamicStates.size()),
-        .pDynamicStates = dynamicStates.data(),
-    };
-
-    std::vector<VkDescriptorSetLayout> piplineLayoutSets{ m_DescriptorSetlayout };
-    if(materialSetLayout.has_value())
-        piplineLayoutSets.push_back(materialSetLayout.value());
-
-
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-        .setLayoutCount = static_cast<uint32_t>(piplineLayoutSets.size()),
-        .pSetLayouts = piplineLayoutSets.data(),
-        .pushConstantRangeCount = 0,
-    };
-
-    const VkPushConstantRange pushConstant{
-        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
-        .offset = 0,
-        .size = pushConstantSize,
-    };
-
-    if(pushConstantSize > 0)
-    {
-        pipelineLayoutInfo.pPushConstantRanges = &pushConstant;
-        pipelineLayoutInfo.pushConstantRangeCount = 1;
-    }
+    std::vector<VkDescriptorSetLayout> setLayouts{ frameUniforms.GetSetLayout() };
+    if(description.materialSetLayout.has_value())
+        setLayouts.push_back(description.materialSetLayout.value());
 
+    m_PipelineLayout = VulkanGlobals::GetPipelineStateCache().GetLayout(setLayouts, description.pushConstantSize);
 
-    if(vkCreatePipelineLayout(VulkanGlobals::GetDevice(), &pipelineLayoutInfo, nullptr, &m_PipelineLayout) !=
-       VK_SUCCESS)
-        throw std::runtime_error("failed to create pipeline layout!");
-
+    FindOrAddVariant(description.permutation);
+}
 
-    VkGraphicsPipelineCreateInfo pipelineInfo{};
+bool Pipeline::IsReady(uint32_t variantIndex) const
+{
+    const Variant& variant = m_Variants[variantIndex];
+    return variant.pipeline != VK_NULL_HANDLE or
+           variant.future.wait_for(std::chrono::seconds{ 0 }) == std::future_status::ready;
+}
 
-    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+void Pipeline::Wait(uint32_t variantIndex)
+{
+    Variant& variant = m_Variants[variantIndex];
+    if(variant.pipeline == VK_NULL_HANDLE)
+    {
+        JUL_PROFILE_ZONE("Pipeline::Wait");
+        variant.pipeline = variant.future.get();
+    }
+}
 
+uint32_t Pipeline::GetVariant(const Material* material)
+{
+    if(material == nullptr or not m_Description.permutation.has_value())
+        return 0;
 
-    VkPipelineShaderStageCreateInfo shaderStages[] = { shader.GetVertexInfo(), shader.GetFragmentInfo() };
+    const uint32_t materialId = material->GetId();
+    if(materialId < m_MaterialVariants.size() and m_MaterialVariants[materialId] != NO_VARIANT)
+        return m_MaterialVariants[materialId];
 
-    auto inputAssemblyState{ Shader::CreateInputAssemblyStateInfo() };
+    // Features are only ever turned off, so the variant is never more expensive than the base
+    const Material::Features& features = material->GetFeatures();
+    ShaderPermutation permutation = m_Description.permutation.value();
+    permutation.hasNormalMap = permutation.hasNormalMap and features.normalMap;
+    permutation.hasOrmMap = permutation.hasOrmMap and features.ormMap;
 
-    pipelineInfo.stageCount = 2;
-    pipelineInfo.pStages = shaderStages;
-    pipelineInfo.pVertexInputState = &pipelineVertexInputStateInfo;
-    pipelineInfo.pInputAssemblyState = &inputAssemblyState;
+    if(materialId >= m_MaterialVariants.size())
+        m_MaterialVariants.resize(materialId + 1, NO_VARIANT);
 
-    pipelineInfo.pViewportState = &viewportState;
-    pipelineInfo.pRasterizationState = &rasterizer;
-    pipelineInfo.pMultisampleState = &multisampling;
-    pipelineInfo.pColorBlendState = &colorBlending;
-    pipelineInfo.pDynamicState = &dynamicState;
-    pipelineInfo.layout = m_PipelineLayout;
-    pipelineInfo.renderPass = m_RenderPass;
-    pipelineInfo.subpass = 0;
-    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
-    pipelineInfo.pDepthStencilState = &depthStencil;
+    m_MaterialVariants[materialId] = FindOrAddVariant(permutation);
+    return m_MaterialVariants[materialId];
+}
 
-    if(vkCreateGraphicsPipelines(VulkanGlobals::GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_Pipeline) !=
-       VK_SUCCESS)
-        throw std::runtime_error("failed to create graphics pipeline!");
+void Pipeline::SetDebugView(ShaderPermutation::DebugView debugView)
+{
+    if(not m_Description.permutation.has_value() or m_Description.permutation->debugView == debugView)
+        return;
 
+    m_Description.permutation->debugView = debugView;
+    m_MaterialVariants.clear();
 
-    m_DescriptorPoolUPtr = std::make_unique<DescriptorPool>(VulkanGlobals::GetDevice(),
-                                                            VulkanGlobals::GetSwapChain().GetImageCount(),
-                                                            std::vector{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER },
-                                                            m_DescriptorSetlayout,
-                                                            m_UniformBuffers);
+    // Variant 0 always follows the base permutation, variants that were built before are kept for switching back
+    const uint32_t baseVariant = FindOrAddVariant(m_Description.permutation);
+    std::swap(m_Variants[0], m_Variants[baseVariant]);
 }
 
-Pipeline::~Pipeline()
+uint32_t Pipeline::FindOrAddVariant(const std::optional<ShaderPermutation>& permutation)
 {
-    vkDestroyPipeline(VulkanGlobals::GetDevice(), m_Pipeline, nullptr);
-    vkDestroyPipelineLayout(VulkanGlobals::GetDevice(), m_PipelineLayout, nullptr);
-    vkDestroyDescriptorSetLayout(VulkanGlobals::GetDevice(), m_DescriptorSetlayout, nullptr);
+    const auto found = std::ranges::find(m_Variants, permutation, &Variant::permutation);
+    if(found != m_Variants.end())
+        return static_cast<uint32_t>(found - m_Variants.begin());
+
+    if(m_Variants.size() >= MAX_VARIANT_COUNT)
+        throw std::runtime_error("Pipeline has too many variants!");
+
+    m_Variants.push_back({
+        .permutation = permutation,
+        .future = VulkanGlobals::GetPipelineStateCache().GetPipeline(
+            m_Description, permutation, m_PipelineLayout, m_RenderPass, m_ThreadPoolPtr),
+    });
+
+    return static_cast<uint32_t>(m_Variants.size() - 1);
 }
 
-void Pipeline::Bind(VkCommandBuffer commandBuffer, int imageIndex)
+void Pipeline::Bind(CommandEncoder& encoder, int imageIndex, uint32_t variantIndex)
 {
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline);
+    Wait(variantIndex);
+    encoder.BindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, m_Variants[variantIndex].pipeline);
+
+    // Shared pipelines don't know whose state they were built with, so it is set on every bind
+    if(VulkanGlobals::IsExtendedDynamicStateEnabled())
+        encoder.SetFixedFunctionState(m_Description.fixedFunctionState);
 
+    // Every pipeline sets the same viewport and scissor, the encoder only records them once
     VkViewport viewport{};
     viewport.x = 0.0f;
     viewport.y = 0.0f;
@@ -157,75 +112,23 @@ void Pipeline::Bind(VkCommandBuffer commandBuffer, int imageIndex)
     viewport.height = static_cast<float>(VulkanGlobals::GetSwapChain().GetExtent().height);
     viewport.minDepth = 0.0f;
     viewport.maxDepth = 1.0f;
-    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    encoder.SetViewport(viewport);
 
     VkRect2D scissor{};
     scissor.offset = { 0, 0 };
     scissor.extent = VulkanGlobals::GetSwapChain().GetExtent();
-    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-
-    vkCmdBindDescriptorSets(commandBuffer,
-                            VK_PIPELINE_BIND_POINT_GRAPHICS,
-                            m_PipelineLayout,
-                            0,  // Set 0
-                            1,
-                            m_DescriptorPoolUPtr->GetDescriptorSet(imageIndex),
-                            0,
-                            nullptr);
-}
-
-void Pipeline::CreateDescriptorSetLayout()
-{
-    const VkDescriptorSetLayoutBinding uboLayoutBinding{
-
-        .binding = 0,
-        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-        .descriptorCount = 1,
-        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-        .pImmutableSamplers = nullptr
-    };
-
-    const VkDescriptorSetLayoutCreateInfo layoutInfo{
+    encoder.SetScissor(scissor);
 
-        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-        .bindingCount = static_cast<uint32_t>(1),
-        .pBindings = &uboLayoutBinding
-    };
-
-    if(vkCreateDescriptorSetLayout(VulkanGlobals::GetDevice(), &layoutInfo, nullptr, &m_DescriptorSetlayout) !=
-       VK_SUCCESS)
-        throw std::runtime_error("fialed to create descriptor set layout!");
+    encoder.BindDescriptorSet(
+        VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, m_FrameUniformsPtr->GetDescriptorSet(imageIndex));
 }
 
-void Pipeline::CreateUniformbuffers(int maxFramesCount, VkDeviceSize uboBufferSize)
+void Pipeline::UpdatePushConstant(CommandEncoder& encoder, const void* pushConstants, uint32_t pushConstantSize)
 {
-    m_UniformBuffers.reserve(maxFramesCount);
-
-    for(size_t i = 0; i < maxFramesCount; i++)
-    {
-        m_UniformBuffers.emplace_back(
-            std::make_unique<Buffer>(uboBufferSize,
-                                     VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
-
-        m_UniformBuffers[i]->Map(uboBufferSize);
-    }
-}
-
-void Pipeline::UpdateUBO(int imageIndex, void* uboData, VkDeviceSize uboSize)
-{
-    m_UniformBuffers[imageIndex]->Upload(uboData, uboSize);
+    encoder.PushConstants(m_PipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, pushConstants, pushConstantSize);
 }
 
-void Pipeline::UpdatePushConstant(VkCommandBuffer commandBuffer, void* pushConstants, uint32_t pushConstantSize)
+void Pipeline::UpdateMaterial(CommandEncoder& encoder, const Material& material)
 {
-    vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, pushConstantSize, pushConstants);
-}
-
-void Pipeline::UpdateMaterial(VkCommandBuffer commandBuffer, const Material& material)
-{
-    auto* descriptorSet = material.GetDescriptorSet();
-
-    vkCmdBindDescriptorSets(
-        commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 1, 1, &descriptorSet, 0, nullptr);
+    encoder.BindDescriptorSet(VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 1, material.GetDescriptorSet());
 }
@@ -1,41 +1,78 @@
 #pragma once
 
 
+#include <future>
 #include <optional>
+#include <vector>
 
-#include "jul/DescriptorPool.h"
-#include "jul/Shader.h"
+#include "CommandEncoder.h"
 #include "Material.h"
+#include "PipelineStateCache.h"
 
+class FrameUniforms;
+class ThreadPool;
 
+// A graphics pipeline bound together with the uniforms it draws with
+//
+// The VkPipeline and layout come from the pipeline state cache, so pipelines with the same description share them
 class Pipeline
 {
 public:
-    Pipeline(const Shader& shader, VkPipelineVertexInputStateCreateInfo pipelineVertexInputStateInfo,
-             VkDeviceSize uboSize, uint32_t pushConstantSize = 0,
-             std::optional<VkDescriptorSetLayout> materialSetLayout = std::nullopt,
-             VkCullModeFlagBits cullMode = VK_CULL_MODE_FRONT_BIT, VkBool32 depthTestEnable = VK_TRUE,
-             VkBool32 depthWriteEnable = VK_TRUE);
+    // With a thread pool new VkPipelines are built on a worker
+    Pipeline(const PipelineDescription& description, const FrameUniforms& frameUniforms,
+             ThreadPool* threadPool = nullptr);
 
-    ~Pipeline();
+    ~Pipeline() = default;
 
-    void Bind(VkCommandBuffer commandBuffer, int imageIndex);
-    void UpdateUBO(int imageIndex, void* uboData, VkDeviceSize uboSize);
-    void UpdatePushConstant(VkCommandBuffer commandBuffer, void* pushConstants, uint32_t pushConstantSize);
-    void UpdateMaterial(VkCommandBuffer commandBuffer, const Material& material);
+    Pipeline(Pipeline&&) = delete;
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(Pipeline&&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    // True once the variant is built, binding it before then blocks until the worker is done
+    [[nodiscard]] bool IsReady(uint32_t variantIndex) const;
+
+    // Blocks until the worker is done, rethrows when the build failed
+    void Wait(uint32_t variantIndex = 0);
+
+    // The cheapest variant that can draw the material, variants with the same permutation are only built once
+    // Variant 0 is the base permutation, pipelines without a permutation only have that one
+    uint32_t GetVariant(const Material* material);
+    [[nodiscard]] uint32_t GetVariantCount() const { return static_cast<uint32_t>(m_Variants.size()); }
+
+    // Changes the base permutation, materials pick their variants again
+    void SetDebugView(ShaderPermutation::DebugView debugView);
+
+    // Waits on first use when the variant is still being built
+    void Bind(CommandEncoder& encoder, int imageIndex, uint32_t variantIndex = 0);
+    void UpdatePushConstant(CommandEncoder& encoder, const void* pushConstants, uint32_t pushConstantSize);
+    void UpdateMaterial(CommandEncoder& encoder, const Material& material);
+
+    // Every base permutation times every material feature set still fits
+    inline static constexpr uint32_t MAX_VARIANT_COUNT{ 32 };
 
 private:
-    void CreateDescriptorSetLayout();
-    void CreateUniformbuffers(int maxFramesCount, VkDeviceSize uboBufferSize);
+    struct Variant
+    {
+        std::optional<ShaderPermutation> permutation;
+        VkPipeline pipeline;
+        std::shared_future<VkPipeline> future;
+    };
 
+    [[nodiscard]] uint32_t FindOrAddVariant(const std::optional<ShaderPermutation>& permutation);
 
-    VkPipeline m_Pipeline{};
-    VkPipelineLayout m_PipelineLayout{};
+    PipelineDescription m_Description;
+    const FrameUniforms* m_FrameUniformsPtr;
+    ThreadPool* m_ThreadPoolPtr;
 
-    VkDescriptorSetLayout m_DescriptorSetlayout{};
+    std::vector<Variant> m_Variants{};
+    // Indexed by material id, NO_VARIANT until the material is first drawn
+    std::vector<uint32_t> m_MaterialVariants{};
 
-    std::vector<std::unique_ptr<Buffer>> m_UniformBuffers{};
-    std::unique_ptr<DescriptorPool> m_DescriptorPoolUPtr;
+    // Owned by the pipeline state cache
+    VkPipelineLayout m_PipelineLayout{};
 
     VkRenderPass m_RenderPass;
+
+    inline static constexpr uint32_t NO_VARIANT{ UINT32_MAX };
 };
@@ -0,0 +1,165 @@
+#include "PipelineCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include "vulkanbase/VulkanGlobals.h"
+
+void PipelineCache::Init(const std::filesystem::path& path)
+{
+    s_Path = path;
+    s_CreationStats = {};
+
+    const std::vector<char> data = LoadData();
+    s_LoadedSize = data.size();
+
+    const VkPipelineCacheCreateInfo cacheInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = data.size(),
+        .pInitialData = data.empty() ? nullptr : data.data(),
+    };
+
+    if(vkCreatePipelineCache(VulkanGlobals::GetDevice(), &cacheInfo, nullptr, &s_PipelineCache) != VK_SUCCESS)
+        throw std::runtime_error("failed to create pipeline cache!");
+}
+
+void PipelineCache::Cleanup()
+{
+    Save();
+
+    vkDestroyPipelineCache(VulkanGlobals::GetDevice(), s_PipelineCache, nullptr);
+    s_PipelineCache = VK_NULL_HANDLE;
+}
+
+void PipelineCache::Save()
+{
+    const VkDevice device = VulkanGlobals::GetDevice();
+
+    size_t dataSize{};
+    if(vkGetPipelineCacheData(device, s_PipelineCache, &dataSize, nullptr) != VK_SUCCESS)
+        throw std::runtime_error("failed to get pipeline cache size!");
+
+    std::vector<char> data(dataSize);
+    if(vkGetPipelineCacheData(device, s_PipelineCache, &dataSize, data.data()) != VK_SUCCESS)
+        throw std::runtime_error("failed to get pipeline cache data!");
+
+    data.resize(dataSize);
+
+    const FileHeader header = CreateHeader(data);
+
+    std::filesystem::path temporaryPath = s_Path;
+    temporaryPath += ".tmp";
+
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if(not file.is_open())
+        {
+            std::cerr << "Could not write pipeline cache to " << temporaryPath << '\n';
+            return;
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    std::error_code error{};
+    std::filesystem::rename(temporaryPath, s_Path, error);
+    if(error)
+        std::cerr << "Could not replace pipeline cache " << s_Path << ": " << error.message() << '\n';
+}
+
+void PipelineCache::AddCreationTime(double milliseconds)
+{
+    const std::lock_guard lock{ s_StatsMutex };
+    ++s_CreationStats.pipelineCount;
+    s_CreationStats.totalMs += milliseconds;
+}
+
+PipelineCache::CreationStats PipelineCache::GetCreationStats()
+{
+    const std::lock_guard lock{ s_StatsMutex };
+    return s_CreationStats;
+}
+
+PipelineCache::FileHeader PipelineCache::CreateHeader(const std::vector<char>& data)
+{
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(VulkanGlobals::GetPhysicalDevice(), &properties);
+
+    FileHeader header{
+        .magic = FILE_MAGIC,
+        .fileVersion = FILE_VERSION,
+        .vendorId = properties.vendorID,
+        .deviceId = properties.deviceID,
+        .driverVersion = properties.driverVersion,
+        .apiVersion = properties.apiVersion,
+        .dataSize = data.size(),
+        .dataHash = Hash(data),
+    };
+
+    std::ranges::copy(properties.pipelineCacheUUID, header.pipelineCacheUuid.begin());
+    return header;
+}
+
+std::vector<char> PipelineCache::LoadData()
+{
+    std::ifstream file(s_Path, std::ios::binary | std::ios::ate);
+    if(not file.is_open())
+        return {};
+
+    const auto fileSize = static_cast<size_t>(file.tellg());
+    if(fileSize < sizeof(FileHeader))
+        return {};
+
+    file.seekg(0);
+
+    FileHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    std::vector<char> data(fileSize - sizeof(FileHeader));
+    file.read(data.data(), static_cast<std::streamsize>(data.size()));
+
+    // Written by another device, driver or build, or cut short while saving
+    const FileHeader expected = CreateHeader(data);
+    if(header.magic != expected.magic or header.fileVersion != expected.fileVersion or
+       header.vendorId != expected.vendorId or header.deviceId != expected.deviceId or
+       header.driverVersion != expected.driverVersion or header.apiVersion != expected.apiVersion or
+       header.pipelineCacheUuid != expected.pipelineCacheUuid or header.dataSize != expected.dataSize or
+       header.dataHash != expected.dataHash)
+    {
+        std::cout << "Ignoring pipeline cache " << s_Path << ", it does not match this device and driver\n";
+        return {};
+    }
+
+    // The driver's own header has to agree as well
+    VkPipelineCacheHeaderVersionOne driverHeader{};
+    if(data.size() < sizeof(driverHeader))
+        return {};
+
+    std::memcpy(&driverHeader, data.data(), sizeof(driverHeader));
+    if(driverHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE or
+       driverHeader.vendorID != expected.vendorId or driverHeader.deviceID != expected.deviceId or
+       not std::ranges::equal(driverHeader.pipelineCacheUUID, expected.pipelineCacheUuid))
+    {
+        std::cout << "Ignoring pipeline cache " << s_Path << ", the driver header does not match\n";
+        return {};
+    }
+
+    return data;
+}
+
+uint64_t PipelineCache::Hash(const std::vector<char>& data)
+{
+    // FNV-1a, only used to catch truncated or corrupted files
+    uint64_t hash{ 14'695'981'039'346'656'037ull };
+    for(const char byte : data)
+    {
+        hash ^= static_cast<uint8_t>(byte);
+        hash *= 1'099'511'628'211ull;
+    }
+
+    return hash;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <vector>
+
+// Process wide VkPipelineCache that is kept on disk between runs
+//
+// The file starts with a header of the device and driver that wrote it, a file from another device, driver or
+// build is ignored instead of handed to the driver, the driver rejecting a bad cache is not something to rely on
+class PipelineCache final
+{
+public:
+    struct CreationStats
+    {
+        uint32_t pipelineCount{};
+        double totalMs{};
+    };
+
+    static void Init(const std::filesystem::path& path);
+    // Saves the cache before destroying it
+    static void Cleanup();
+
+    // Writes to a temporary file first, so a crash while saving never leaves a broken cache behind
+    static void Save();
+
+    // Safe to create pipelines with from any thread, the driver synchronizes access to the cache
+    [[nodiscard]] static VkPipelineCache Get() { return s_PipelineCache; }
+
+    // True when the cache was filled from disk at startup
+    [[nodiscard]] static bool IsWarm() { return s_LoadedSize > 0; }
+    [[nodiscard]] static size_t GetLoadedSize() { return s_LoadedSize; }
+
+    // Every pipeline reports how long it took to create, pipelines can be built on any thread
+    static void AddCreationTime(double milliseconds);
+    [[nodiscard]] static CreationStats GetCreationStats();
+
+private:
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t fileVersion;
+        uint32_t vendorId;
+        uint32_t deviceId;
+        uint32_t driverVersion;
+        uint32_t apiVersion;
+        std::array<uint8_t, VK_UUID_SIZE> pipelineCacheUuid;
+        uint64_t dataSize;
+        uint64_t dataHash;
+    };
+
+    [[nodiscard]] static FileHeader CreateHeader(const std::vector<char>& data);
+    [[nodiscard]] static std::vector<char> LoadData();
+    [[nodiscard]] static uint64_t Hash(const std::vector<char>& data);
+
+    inline static VkPipelineCache s_PipelineCache{};
+    inline static std::filesystem::path s_Path{};
+    inline static size_t s_LoadedSize{};
+    inline static CreationStats s_CreationStats{};
+    inline static std::mutex s_StatsMutex{};
+
+    // "JPLC"
+    inline static constexpr uint32_t FILE_MAGIC{ 0x434C504A };
+    inline static constexpr uint32_t FILE_VERSION{ 1 };
+};
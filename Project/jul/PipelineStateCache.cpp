@@ -0,0 +1,339 @@
+#include "PipelineStateCache.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+
+#include "CpuProfiler.h"
+#include "PipelineCache.h"
+#include "ThreadPool.h"
+#include "vulkanbase/VulkanGlobals.h"
+
+namespace
+{
+    // Dynamic topology has to stay within the class of the topology the pipeline was built with
+    uint64_t GetTopologyClass(VkPrimitiveTopology topology)
+    {
+        switch(topology)
+        {
+            case VK_PRIMITIVE_TOPOLOGY_POINT_LIST: return 0;
+            case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+            case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+            case VK_PRIMITIVE_TOPOLOGY_LINE_LIST_WITH_ADJACENCY:
+            case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP_WITH_ADJACENCY: return 1;
+            case VK_PRIMITIVE_TOPOLOGY_PATCH_LIST: return 3;
+            default: return 2;
+        }
+    }
+}
+
+PipelineStateCache::PipelineStateCache(VkDevice device) :
+    m_Device(device)
+{
+}
+
+PipelineStateCache::~PipelineStateCache()
+{
+    for(auto&& [key, pipelineFuture] : m_Pipelines)
+    {
+        try
+        {
+            vkDestroyPipeline(m_Device, pipelineFuture.get(), nullptr);
+        }
+        catch(const std::exception& exception)
+        {
+            std::cerr << "Pipeline " << key.vertexPath << " " << key.fragmentPath
+                      << " was never built: " << exception.what() << '\n';
+        }
+    }
+
+    for(auto&& [key, layout] : m_Layouts)
+        vkDestroyPipelineLayout(m_Device, layout, nullptr);
+}
+
+VkPipelineLayout PipelineStateCache::GetLayout(const std::vector<VkDescriptorSetLayout>& setLayouts,
+                                               uint32_t pushConstantSize)
+{
+    LayoutKey key{};
+    key.reserve(setLayouts.size() + 1);
+    for(VkDescriptorSetLayout setLayout : setLayouts)
+        key.push_back(reinterpret_cast<uint64_t>(setLayout));
+    key.push_back(pushConstantSize);
+
+    if(auto found = m_Layouts.find(key); found != m_Layouts.end())
+        return found->second;
+
+    const VkPushConstantRange pushConstant{
+        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+        .offset = 0,
+        .size = pushConstantSize,
+    };
+
+    const VkPipelineLayoutCreateInfo layoutInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = static_cast<uint32_t>(setLayouts.size()),
+        .pSetLayouts = setLayouts.data(),
+        .pushConstantRangeCount = pushConstantSize > 0 ? 1u : 0u,
+        .pPushConstantRanges = pushConstantSize > 0 ? &pushConstant : nullptr,
+    };
+
+    VkPipelineLayout layout{};
+    if(vkCreatePipelineLayout(m_Device, &layoutInfo, nullptr, &layout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create pipeline layout!");
+
+    m_Layouts.emplace(std::move(key), layout);
+    return layout;
+}
+
+std::shared_future<VkPipeline> PipelineStateCache::GetPipeline(const PipelineDescription& description,
+                                                               const std::optional<ShaderPermutation>& permutation,
+                                                               VkPipelineLayout layout, VkRenderPass renderPass,
+                                                               ThreadPool* threadPool)
+{
+    ++m_RequestCount;
+
+    PipelineKey key = CreateKey(description, permutation, layout, renderPass);
+    if(auto found = m_Pipelines.find(key); found != m_Pipelines.end())
+        return found->second;
+
+    // Thread pool tasks have to be copyable, so the promise is shared
+    auto promisePtr = std::make_shared<std::promise<VkPipeline>>();
+    std::shared_future<VkPipeline> pipelineFuture = promisePtr->get_future().share();
+
+    auto buildTask = [promisePtr, description, permutation, layout, renderPass]
+    {
+        try
+        {
+            promisePtr->set_value(Build(description, permutation, layout, renderPass));
+        }
+        catch(...)
+        {
+            promisePtr->set_exception(std::current_exception());
+        }
+    };
+
+    if(threadPool != nullptr)
+        threadPool->Enqueue(std::move(buildTask));
+    else
+        buildTask();
+
+    m_Pipelines.emplace(std::move(key), pipelineFuture);
+    return pipelineFuture;
+}
+
+size_t PipelineStateCache::PipelineKeyHash::operator()(const PipelineKey& key) const
+{
+    // FNV-1a over the paths and the state words
+    uint64_t hash{ 14'695'981'039'346'656'037ull };
+    auto hashBytes = [&hash](const void* data, size_t size)
+    {
+        for(size_t byteIndex = 0; byteIndex < size; ++byteIndex)
+        {
+            hash ^= static_cast<const uint8_t*>(data)[byteIndex];
+            hash *= 1'099'511'628'211ull;
+        }
+    };
+
+    hashBytes(key.vertexPath.data(), key.vertexPath.size());
+    hashBytes(key.fragmentPath.data(), key.fragmentPath.size());
+    hashBytes(key.state.data(), key.state.size() * sizeof(uint64_t));
+
+    return static_cast<size_t>(hash);
+}
+
+PipelineStateCache::PipelineKey PipelineStateCache::CreateKey(const PipelineDescription& description,
+                                                              const std::optional<ShaderPermutation>& permutation,
+                                                              VkPipelineLayout layout, VkRenderPass renderPass)
+{
+    PipelineKey key{
+        .vertexPath = description.vertexPath.generic_string(),
+        .fragmentPath = description.fragmentPath.generic_string(),
+    };
+
+    std::vector<uint64_t>& state = key.state;
+    const VkPipelineVertexInputStateCreateInfo& vertexInput = description.vertexInputState;
+
+    state.push_back(vertexInput.vertexBindingDescriptionCount);
+    for(uint32_t bindingIndex = 0; bindingIndex < vertexInput.vertexBindingDescriptionCount; ++bindingIndex)
+    {
+        const VkVertexInputBindingDescription& binding = vertexInput.pVertexBindingDescriptions[bindingIndex];
+        state.insert(state.end(), { binding.binding, binding.stride, static_cast<uint64_t>(binding.inputRate) });
+    }
+
+    state.push_back(vertexInput.vertexAttributeDescriptionCount);
+    for(uint32_t attributeIndex = 0; attributeIndex < vertexInput.vertexAttributeDescriptionCount; ++attributeIndex)
+    {
+        const VkVertexInputAttributeDescription& attribute = vertexInput.pVertexAttributeDescriptions[attributeIndex];
+        state.insert(
+            state.end(),
+            { attribute.location, attribute.binding, static_cast<uint64_t>(attribute.format), attribute.offset });
+    }
+
+    state.insert(state.end(), { reinterpret_cast<uint64_t>(layout), reinterpret_cast<uint64_t>(renderPass) });
+
+    const FixedFunctionState& fixedState = description.fixedFunctionState;
+    if(VulkanGlobals::IsExtendedDynamicStateEnabled())
+        state.push_back(GetTopologyClass(fixedState.topology));
+    else
+        state.insert(state.end(),
+                     { fixedState.cullMode,
+                       static_cast<uint64_t>(fixedState.frontFace),
+                       static_cast<uint64_t>(fixedState.topology),
+                       fixedState.depthTestEnable,
+                       fixedState.depthWriteEnable,
+                       static_cast<uint64_t>(fixedState.depthCompareOp) });
+
+    if(not VulkanGlobals::IsExtendedDynamicState2Enabled())
+        state.push_back(fixedState.primitiveRestartEnable);
+
+    // The material set layout is already part of the pipeline layout
+    state.push_back(permutation.has_value());
+    if(permutation.has_value())
+        state.insert(state.end(),
+                     { permutation->hasNormalMap,
+                       permutation->hasOrmMap,
+                       static_cast<uint64_t>(permutation->debugView) });
+
+    return key;
+}
+
+VkPipeline PipelineStateCache::Build(const PipelineDescription& description,
+                                     const std::optional<ShaderPermutation>& permutation, VkPipelineLayout layout,
+                                     VkRenderPass renderPass)
+{
+    JUL_PROFILE_ZONE("PipelineStateCache::Build");
+
+    // Still filled in with extended dynamic state, the values are ignored then
+    const FixedFunctionState& fixedState = description.fixedFunctionState;
+
+    const VkPipelineViewportStateCreateInfo viewportState{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+        .viewportCount = 1,
+        .scissorCount = 1,
+    };
+
+    const VkPipelineRasterizationStateCreateInfo rasterizer{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+        .depthClampEnable = VK_FALSE,
+        .rasterizerDiscardEnable = VK_FALSE,
+        .polygonMode = VK_POLYGON_MODE_FILL,
+        .cullMode = fixedState.cullMode,
+        .frontFace = fixedState.frontFace,
+        .depthBiasEnable = VK_FALSE,
+        .lineWidth = 1.0f,
+    };
+
+    const VkPipelineMultisampleStateCreateInfo multisampling{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+        .sampleShadingEnable = VK_FALSE,
+    };
+
+    const VkPipelineDepthStencilStateCreateInfo depthStencil{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+        .depthTestEnable = fixedState.depthTestEnable,
+        .depthWriteEnable = fixedState.depthWriteEnable,
+        .depthCompareOp = fixedState.depthCompareOp,
+        .depthBoundsTestEnable = VK_FALSE,
+        .stencilTestEnable = VK_FALSE,
+        .front = {},
+        .back = {},
+        .minDepthBounds = 0.f,
+        .maxDepthBounds = 1.f,
+    };
+
+
+    const VkPipelineColorBlendAttachmentState colorBlendAttachment{
+        .blendEnable = VK_FALSE,
+        .colorWriteMask =
+            VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
+    };
+
+    const VkPipelineColorBlendStateCreateInfo colorBlending{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+        .logicOpEnable = VK_FALSE,
+        .logicOp = VK_LOGIC_OP_COPY,
+        .attachmentCount = 1,
+        .pAttachments = &colorBlendAttachment,
+    };
+
+
+    std::vector<VkDynamicState> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    if(VulkanGlobals::IsExtendedDynamicStateEnabled())
+        dynamicStates.insert(dynamicStates.end(),
+                             { VK_DYNAMIC_STATE_CULL_MODE_EXT,
+                               VK_DYNAMIC_STATE_FRONT_FACE_EXT,
+                               VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT,
+                               VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE_EXT,
+                               VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT,
+                               VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT });
+    if(VulkanGlobals::IsExtendedDynamicState2Enabled())
+        dynamicStates.push_back(VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE_EXT);
+
+    const VkPipelineDynamicStateCreateInfo dynamicState{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        .dynamicStateCount = static_cast<uint32_t>(dynamicStates.size()),
+        .pDynamicStates = dynamicStates.data(),
+    };
+
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+
+
+    // Modules are only needed while the pipeline is created
+    const Shader shader{ description.vertexPath, description.fragmentPath };
+    VkPipelineShaderStageCreateInfo shaderStages[] = { shader.GetVertexInfo(), shader.GetFragmentInfo() };
+
+    const std::array<VkSpecializationMapEntry, 3> specializationEntries{
+        VkSpecializationMapEntry{ 0, offsetof(ShaderPermutation, hasNormalMap), sizeof(VkBool32) },
+        VkSpecializationMapEntry{ 1, offsetof(ShaderPermutation, hasOrmMap), sizeof(VkBool32) },
+        VkSpecializationMapEntry{ 2, offsetof(ShaderPermutation, debugView), sizeof(uint32_t) },
+    };
+
+    const VkSpecializationInfo specializationInfo{
+        .mapEntryCount = static_cast<uint32_t>(specializationEntries.size()),
+        .pMapEntries = specializationEntries.data(),
+        .dataSize = sizeof(ShaderPermutation),
+        .pData = permutation.has_value() ? &permutation.value() : nullptr,
+    };
+
+    if(permutation.has_value())
+        shaderStages[1].pSpecializationInfo = &specializationInfo;
+
+    auto inputAssemblyState{ Shader::CreateInputAssemblyStateInfo() };
+    inputAssemblyState.topology = fixedState.topology;
+    inputAssemblyState.primitiveRestartEnable = fixedState.primitiveRestartEnable;
+
+    pipelineInfo.stageCount = 2;
+    pipelineInfo.pStages = shaderStages;
+    pipelineInfo.pVertexInputState = &description.vertexInputState;
+    pipelineInfo.pInputAssemblyState = &inputAssemblyState;
+
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState = &multisampling;
+    pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.layout = layout;
+    pipelineInfo.renderPass = renderPass;
+    pipelineInfo.subpass = 0;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+    pipelineInfo.pDepthStencilState = &depthStencil;
+
+    const auto creationStart = std::chrono::steady_clock::now();
+
+    VkPipeline pipeline{};
+    if(vkCreateGraphicsPipelines(
+           VulkanGlobals::GetDevice(), PipelineCache::Get(), 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+        throw std::runtime_error("failed to create graphics pipeline!");
+
+    PipelineCache::AddCreationTime(
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - creationStart).count());
+
+    return pipeline;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <future>
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "jul/CommandEncoder.h"
+#include "jul/Shader.h"
+
+class ThreadPool;
+
+// Specialization constants of the PBR fragment shaders, the constant ids follow the member order
+struct ShaderPermutation
+{
+    enum class DebugView : uint32_t
+    {
+        None,
+        BaseColor,
+        Normal,
+        Metallic,
+        Roughness,
+        Occlusion,
+        Count
+    };
+
+    VkBool32 hasNormalMap{ VK_TRUE };
+    VkBool32 hasOrmMap{ VK_TRUE };
+    DebugView debugView{ DebugView::None };
+
+    bool operator==(const ShaderPermutation&) const = default;
+};
+
+// Everything that ends up in a graphics pipeline, copied to the worker when it is built on a thread pool
+struct PipelineDescription
+{
+    path vertexPath;
+    path fragmentPath;
+
+    // Has to point to data that outlives the build, the Vertex types keep theirs in static members
+    VkPipelineVertexInputStateCreateInfo vertexInputState;
+
+    uint32_t pushConstantSize{};
+    std::optional<VkDescriptorSetLayout> materialSetLayout{};
+    // Only part of the pipeline key when the device can't set it on the command buffer, see Pipeline::Bind
+    FixedFunctionState fixedFunctionState{};
+
+    // Only for the PBR shaders, materials get variants of this with the textures they don't need left out
+    std::optional<ShaderPermutation> permutation{};
+};
+
+// Owns every graphics pipeline and pipeline layout, equal requests get the same object
+//
+// Pipelines are looked up on a hash of everything that is baked into them, so users that describe the same state
+// share one VkPipeline no matter how many of them there are
+// With extended dynamic state the fixed function state is left out of the key, descriptions that only differ in
+// culling, depth or topology class collapse into one pipeline
+class PipelineStateCache final
+{
+public:
+    explicit PipelineStateCache(VkDevice device);
+    // Waits for pipelines that are still being built
+    ~PipelineStateCache();
+
+    PipelineStateCache(PipelineStateCache&&) = delete;
+    PipelineStateCache(const PipelineStateCache&) = delete;
+    PipelineStateCache& operator=(PipelineStateCache&&) = delete;
+    PipelineStateCache& operator=(const PipelineStateCache&) = delete;
+
+    // Push constants are always in the vertex stage at offset 0
+    [[nodiscard]] VkPipelineLayout GetLayout(const std::vector<VkDescriptorSetLayout>& setLayouts,
+                                             uint32_t pushConstantSize);
+
+    // With a thread pool a new pipeline is built on a worker, the future is ready right away otherwise
+    [[nodiscard]] std::shared_future<VkPipeline> GetPipeline(const PipelineDescription& description,
+                                                             const std::optional<ShaderPermutation>& permutation,
+                                                             VkPipelineLayout layout, VkRenderPass renderPass,
+                                                             ThreadPool* threadPool = nullptr);
+
+    [[nodiscard]] uint32_t GetPipelineCount() const { return static_cast<uint32_t>(m_Pipelines.size()); }
+    [[nodiscard]] uint32_t GetLayoutCount() const { return static_cast<uint32_t>(m_Layouts.size()); }
+    // Every GetPipeline call, the difference with the pipeline count was deduplicated
+    [[nodiscard]] uint32_t GetRequestCount() const { return m_RequestCount; }
+
+private:
+    // Everything baked into the pipeline flattened, so it can be hashed and compared
+    struct PipelineKey
+    {
+        std::string vertexPath;
+        std::string fragmentPath;
+        std::vector<uint64_t> state;
+
+        bool operator==(const PipelineKey&) const = default;
+    };
+
+    struct PipelineKeyHash
+    {
+        [[nodiscard]] size_t operator()(const PipelineKey& key) const;
+    };
+
+    // Set layouts then the push constant size
+    using LayoutKey = std::vector<uint64_t>;
+
+    [[nodiscard]] static PipelineKey CreateKey(const PipelineDescription& description,
+                                               const std::optional<ShaderPermutation>& permutation,
+                                               VkPipelineLayout layout, VkRenderPass renderPass);
+
+    [[nodiscard]] static VkPipeline Build(const PipelineDescription& description,
+                                          const std::optional<ShaderPermutation>& permutation,
+                                          VkPipelineLayout layout, VkRenderPass renderPass);
+
+    VkDevice m_Device{};
+
+    std::map<LayoutKey, VkPipelineLayout> m_Layouts{};
+    std::unordered_map<PipelineKey, std::shared_future<VkPipeline>, PipelineKeyHash> m_Pipelines{};
+    uint32_t m_RequestCount{};
+};
@@ -6,7 +6,8 @@
 class RenderPass
 {
 public:
-    RenderPass(VkDevice device, VkFormat swapChainImageFormat);
+    // A pass that doesn't clear continues on the attachments of the previous pass, only the last pass presents
+    RenderPass(VkDevice device, VkFormat swapChainImageFormat, bool clear = true, bool present = true);
     ~RenderPass();
 
     void Begin(VkFramebuffer swapChainFramebuffers, VkExtent2D swapChainExtent, VkCommandBuffer commandBuffer);
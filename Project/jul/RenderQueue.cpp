@@ -0,0 +1,469 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+#include "jul/CpuProfiler.h"
+#include "jul/GpuProfiler.h"
+#include "InstanceBuffer.h"
+#include "Material.h"
+#include "Mesh.h"
+#include "Pipeline.h"
+#include "SwapChain.h"
+#include "vulkanbase/VulkanGlobals.h"
+
+static_assert(OcclusionCuller::MAX_OBJECT_COUNT >= RenderQueue::MAX_INDIRECT_COMMAND_COUNT);
+static_assert(Pipeline::MAX_VARIANT_COUNT <= 1 << 5);
+// Material ids in the key are offset by one so meshes without a material sort first
+static_assert(Material::MAX_BINDLESS_MATERIAL_COUNT + 1 <= 1 << 11);
+
+namespace
+{
+    // Meshes without a material never bind a set
+    VkDescriptorSet GetMaterialSet(const Mesh* meshPtr)
+    {
+        const Material* material = meshPtr->GetMaterial();
+        return material != nullptr ? material->GetDescriptorSet() : VK_NULL_HANDLE;
+    }
+}  // namespace
+
+RenderQueue::RenderQueue()
+{
+    const int frameCount = VulkanGlobals::GetSwapChain().GetImageCount();
+    constexpr VkDeviceSize indirectBufferSize{ sizeof(VkDrawIndexedIndirectCommand) * MAX_INDIRECT_COMMAND_COUNT };
+
+    m_IndirectBuffers.reserve(frameCount);
+
+    for(int i = 0; i < frameCount; ++i)
+    {
+        m_IndirectBuffers.emplace_back(
+            std::make_unique<Buffer>(indirectBufferSize,
+                                     VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+
+        m_IndirectBuffers[i]->Map(indirectBufferSize);
+    }
+}
+
+uint32_t RenderQueue::RegisterPipeline(Pipeline* pipeline, const std::string& name, InstanceBuffer* instanceBuffer)
+{
+    m_Pipelines.push_back({ pipeline, name, instanceBuffer });
+    return static_cast<uint32_t>(m_Pipelines.size() - 1);
+}
+
+void RenderQueue::Clear()
+{
+    m_Draws.clear();
+    m_SortEntries.clear();
+}
+
+void RenderQueue::Add(uint32_t pipelineId, const Mesh* mesh, const glm::mat4& modelMatrix, float depth)
+{
+    const Material* material = mesh->GetMaterial();
+    const uint32_t materialId = material != nullptr ? material->GetId() + 1 : 0;
+    Pipeline& pipeline = *m_Pipelines[pipelineId].pipelinePtr;
+
+    // The base variant draws every material, so a variant still being built doesn't stall the frame
+    uint32_t variantIndex = pipeline.GetVariant(material);
+    if(not pipeline.IsReady(variantIndex))
+        variantIndex = 0;
+
+    m_SortEntries.push_back({ CreateSortKey(pipelineId, variantIndex, materialId, mesh->GetId(), depth),
+                              static_cast<uint32_t>(m_Draws.size()) });
+    m_Draws.push_back({ pipelineId, variantIndex, mesh, modelMatrix, false });
+}
+
+void RenderQueue::AddInstanced(uint32_t pipelineId, const Mesh* mesh, float depth)
+{
+    if(m_Pipelines[pipelineId].instanceBufferPtr == nullptr or not mesh->IsInstanced())
+        throw std::runtime_error("instanced meshes need a pipeline with an instance buffer!");
+
+    if(mesh->GetInstanceCount() == 0)
+        return;
+
+    Add(pipelineId, mesh, glm::mat4{ 1.0f }, depth);
+    m_Draws.back().instanced = true;
+}
+
+void RenderQueue::Sort()
+{
+    JUL_PROFILE_ZONE("RenderQueue::Sort");
+    RadixSort(m_SortEntries, m_SortScratch);
+}
+
+void RenderQueue::Prepare(VkCommandBuffer commandBuffer, int imageIndex)
+{
+    JUL_PROFILE_ZONE("RenderQueue::Prepare");
+
+    m_Stats = {};
+    m_Encoder.ResetStats();
+    m_Batches.clear();
+    m_IndirectCommands.clear();
+    m_CullBatchCount = 0;
+
+    if(m_OcclusionCullerPtr != nullptr)
+        m_OcclusionCullerPtr->Clear();
+
+    std::vector<InstanceBuffer*> instanceBuffers{};
+    for(const PipelineEntry& pipelineEntry : m_Pipelines)
+    {
+        if(pipelineEntry.instanceBufferPtr != nullptr and
+           std::ranges::find(instanceBuffers, pipelineEntry.instanceBufferPtr) == instanceBuffers.end())
+        {
+            pipelineEntry.instanceBufferPtr->ClearDynamic();
+            instanceBuffers.push_back(pipelineEntry.instanceBufferPtr);
+        }
+    }
+
+    // Draws are still in submission order, the unsorted loop binds whenever the pipeline or variant changes
+    for(size_t drawIndex = 0; drawIndex < m_Draws.size(); ++drawIndex)
+    {
+        const Draw& draw = m_Draws[drawIndex];
+        if(drawIndex == 0 or draw.pipelineId != m_Draws[drawIndex - 1].pipelineId or
+           draw.variantIndex != m_Draws[drawIndex - 1].variantIndex)
+            ++m_Stats.naivePipelineBinds;
+    }
+
+    size_t runBegin = 0;
+    while(runBegin < m_SortEntries.size())
+    {
+        const uint32_t pipelineId = m_Draws[m_SortEntries[runBegin].drawIndex].pipelineId;
+
+        size_t runEnd = runBegin + 1;
+        while(runEnd < m_SortEntries.size() and m_Draws[m_SortEntries[runEnd].drawIndex].pipelineId == pipelineId)
+            ++runEnd;
+
+        if(InstanceBuffer* instanceBuffer = m_Pipelines[pipelineId].instanceBufferPtr)
+            BuildIndirectBatches(*instanceBuffer, runBegin, runEnd);
+        else
+            BuildDirectBatches(runBegin, runEnd);
+
+        runBegin = runEnd;
+    }
+
+    if(not m_IndirectCommands.empty())
+        m_IndirectBuffers[imageIndex]->Upload(
+            m_IndirectCommands.data(),
+            static_cast<uint32_t>(m_IndirectCommands.size() * sizeof(VkDrawIndexedIndirectCommand)));
+
+    const GpuZone uploadZone{ commandBuffer, "Upload" };
+    for(InstanceBuffer* instanceBuffer : instanceBuffers)
+    {
+        instanceBuffer->RecordUpload(commandBuffer, imageIndex);
+        m_Stats.uploadedInstances += instanceBuffer->GetUploadedInstanceCount();
+    }
+}
+
+void RenderQueue::Submit(VkCommandBuffer commandBuffer, int imageIndex, OcclusionCuller::Phase phase)
+{
+    JUL_PROFILE_ZONE("RenderQueue::Submit");
+
+    const bool latePhase = phase == OcclusionCuller::Phase::Late;
+    if(latePhase and m_OcclusionCullerPtr == nullptr)
+        return;
+
+    // The occlusion passes bind compute state in between, so nothing is known to be bound yet
+    m_Encoder.Begin(commandBuffer);
+
+    constexpr uint32_t noPipeline = UINT32_MAX;
+
+    uint32_t boundPipelineId = noPipeline;
+    uint32_t boundVariantIndex{};
+    VkDescriptorSet boundMaterialSet = VK_NULL_HANDLE;
+    const Mesh* boundMeshPtr = nullptr;
+    const GeometryBuffer* boundGeometryPtr = nullptr;
+
+    for(const Batch& batch : m_Batches)
+    {
+        if(latePhase and not batch.indirect)
+            continue;
+
+        Pipeline& pipeline = *m_Pipelines[batch.pipelineId].pipelinePtr;
+
+        if(batch.pipelineId != boundPipelineId)
+        {
+            if(boundPipelineId != noPipeline)
+                GpuProfiler::EndZone(commandBuffer);
+            GpuProfiler::BeginZone(commandBuffer, m_Pipelines[batch.pipelineId].name);
+
+            pipeline.Bind(m_Encoder, imageIndex, batch.variantIndex);
+            boundPipelineId = batch.pipelineId;
+            boundVariantIndex = batch.variantIndex;
+            ++m_Stats.pipelineBinds;
+
+            // Pipeline layouts differ, so the material set has to be bound again
+            boundMaterialSet = VK_NULL_HANDLE;
+        }
+        else if(batch.variantIndex != boundVariantIndex)
+        {
+            // Variants share the layout, so the bound sets stay valid
+            pipeline.Bind(m_Encoder, imageIndex, batch.variantIndex);
+            boundVariantIndex = batch.variantIndex;
+            ++m_Stats.pipelineBinds;
+        }
+
+        // Bindless materials all share one set, so it is only bound once per pipeline
+        const Material* material = batch.meshPtr->GetMaterial();
+        if(material != nullptr and material->GetDescriptorSet() != boundMaterialSet)
+        {
+            pipeline.UpdateMaterial(m_Encoder, *material);
+            boundMaterialSet = material->GetDescriptorSet();
+            ++m_Stats.materialBinds;
+        }
+
+        // Meshes in the same geometry buffer share their vertex and index buffers
+        const GeometryBuffer* geometryPtr = batch.meshPtr->GetGeometryBuffer();
+        if(geometryPtr != nullptr ? geometryPtr != boundGeometryPtr : batch.meshPtr != boundMeshPtr)
+        {
+            batch.meshPtr->Bind(m_Encoder);
+            boundMeshPtr = batch.meshPtr;
+            boundGeometryPtr = geometryPtr;
+            ++m_Stats.meshBinds;
+        }
+
+        if(batch.indirect)
+        {
+            DrawIndirect(m_Encoder, imageIndex, batch, phase);
+            continue;
+        }
+
+        const glm::mat4& modelMatrix = m_Draws[batch.drawIndex].modelMatrix;
+        pipeline.UpdatePushConstant(m_Encoder, &modelMatrix, sizeof(modelMatrix));
+
+        batch.meshPtr->DrawIndexed(m_Encoder);
+        ++m_Stats.drawCalls;
+    }
+
+    if(boundPipelineId != noPipeline)
+        GpuProfiler::EndZone(commandBuffer);
+}
+
+void RenderQueue::BuildDirectBatches(size_t begin, size_t end)
+{
+    for(size_t entryIndex = begin; entryIndex < end; ++entryIndex)
+    {
+        const uint32_t drawIndex = m_SortEntries[entryIndex].drawIndex;
+        const Draw& draw = m_Draws[drawIndex];
+
+        m_Batches.push_back({ .pipelineId = draw.pipelineId,
+                              .variantIndex = draw.variantIndex,
+                              .meshPtr = draw.meshPtr,
+                              .drawIndex = drawIndex });
+
+        ++m_Stats.drawCount;
+        ++m_Stats.instanceCount;
+        ++m_Stats.naiveMeshBinds;
+        if(draw.meshPtr->GetMaterial() != nullptr)
+            ++m_Stats.naiveMaterialBinds;
+    }
+}
+
+void RenderQueue::BuildIndirectBatches(InstanceBuffer& instanceBuffer, size_t begin, size_t end)
+{
+    size_t entryIndex = begin;
+    while(entryIndex < end)
+    {
+        const Draw& batchDraw = m_Draws[m_SortEntries[entryIndex].drawIndex];
+        const VkDescriptorSet materialSet = GetMaterialSet(batchDraw.meshPtr);
+        const GeometryBuffer* geometryPtr = batchDraw.meshPtr->GetGeometryBuffer();
+        const auto firstCommand = static_cast<uint32_t>(m_IndirectCommands.size());
+        const uint32_t cullBatchIndex = m_CullBatchCount++;
+
+        auto countDraw = [this](const Mesh* meshPtr, uint32_t instanceCount)
+        {
+            ++m_Stats.drawCount;
+            m_Stats.instanceCount += instanceCount;
+            ++m_Stats.naiveMeshBinds;
+            if(meshPtr->GetMaterial() != nullptr)
+                ++m_Stats.naiveMaterialBinds;
+        };
+
+        // A batch shares its variant, material set and geometry buffer, meshes with their own buffers get a batch each
+        // Bindless materials share one set, so every material of a variant ends up in the same batch
+        while(entryIndex < end)
+        {
+            const Draw& commandDraw = m_Draws[m_SortEntries[entryIndex].drawIndex];
+            const Mesh* meshPtr = commandDraw.meshPtr;
+            if(commandDraw.variantIndex != batchDraw.variantIndex or GetMaterialSet(meshPtr) != materialSet or
+               meshPtr->GetGeometryBuffer() != geometryPtr or (geometryPtr == nullptr and meshPtr != batchDraw.meshPtr))
+                break;
+
+            const Material* material = meshPtr->GetMaterial();
+            const uint32_t materialIndex = material != nullptr ? material->GetId() : 0;
+
+            if(m_IndirectCommands.size() >= MAX_INDIRECT_COMMAND_COUNT)
+                throw std::runtime_error("render queue ran out of indirect commands!");
+
+            uint32_t firstInstance{};
+            uint32_t instanceCount{};
+            Bounds commandBounds{};
+
+            if(commandDraw.instanced)
+            {
+                firstInstance = meshPtr->GetFirstInstance();
+                instanceCount = meshPtr->GetInstanceCount();
+                commandBounds = meshPtr->GetWorldBounds();
+                countDraw(meshPtr, instanceCount);
+                ++entryIndex;
+            }
+            else
+            {
+                // Sorted on mesh, so every draw of this mesh follows and becomes an instance of one command
+                while(entryIndex < end)
+                {
+                    const Draw& draw = m_Draws[m_SortEntries[entryIndex].drawIndex];
+                    if(draw.meshPtr != meshPtr or draw.instanced)
+                        break;
+
+                    const uint32_t instanceIndex = instanceBuffer.AddDynamic(
+                        { .modelMatrix = draw.modelMatrix, .tint = glm::vec4{ 1.0f }, .materialIndex = materialIndex });
+
+                    const Bounds drawBounds = meshPtr->GetBounds().Transformed(draw.modelMatrix);
+                    commandBounds = instanceCount == 0 ? drawBounds : Bounds::Merge(commandBounds, drawBounds);
+
+                    if(instanceCount++ == 0)
+                        firstInstance = instanceIndex;
+
+                    countDraw(meshPtr, 1);
+                    ++entryIndex;
+                }
+            }
+
+            m_IndirectCommands.push_back({
+                .indexCount = meshPtr->GetIndexCount(),
+                .instanceCount = instanceCount,
+                .firstIndex = meshPtr->GetFirstIndex(),
+                .vertexOffset = meshPtr->GetVertexOffset(),
+                .firstInstance = firstInstance,
+            });
+
+            if(m_OcclusionCullerPtr != nullptr)
+                m_OcclusionCullerPtr->Add(
+                    commandBounds, meshPtr->GetId(), cullBatchIndex, firstCommand, m_IndirectCommands.back());
+        }
+
+        m_Batches.push_back({
+            .pipelineId = batchDraw.pipelineId,
+            .variantIndex = batchDraw.variantIndex,
+            .meshPtr = batchDraw.meshPtr,
+            .indirect = true,
+            .firstCommand = firstCommand,
+            .commandCount = static_cast<uint32_t>(m_IndirectCommands.size()) - firstCommand,
+            .cullBatchIndex = cullBatchIndex,
+        });
+    }
+}
+
+void RenderQueue::DrawIndirect(VkCommandBuffer commandBuffer, int imageIndex, const Batch& batch,
+                               OcclusionCuller::Phase phase)
+{
+    constexpr uint32_t stride{ sizeof(VkDrawIndexedIndirectCommand) };
+    const VkPhysicalDeviceFeatures& features = VulkanGlobals::GetEnabledFeatures();
+    const uint32_t firstCommand = batch.firstCommand;
+    const uint32_t commandCount = batch.commandCount;
+
+    if(phase == OcclusionCuller::Phase::Early)
+        m_Stats.indirectCommands += commandCount;
+
+    // The culler wrote its own commands, the count it wrote decides how many are drawn
+    if(m_OcclusionCullerPtr != nullptr)
+    {
+        m_OcclusionCullerPtr->DrawBatch(commandBuffer, phase, batch.cullBatchIndex, firstCommand, commandCount);
+        ++m_Stats.drawCalls;
+        return;
+    }
+
+    // Indirect draws can't pick their first instance, the same commands are issued directly instead
+    if(not features.drawIndirectFirstInstance)
+    {
+        for(uint32_t commandIndex = firstCommand; commandIndex < firstCommand + commandCount; ++commandIndex)
+        {
+            const VkDrawIndexedIndirectCommand& command = m_IndirectCommands[commandIndex];
+            vkCmdDrawIndexed(commandBuffer,
+                             command.indexCount,
+                             command.instanceCount,
+                             command.firstIndex,
+                             command.vertexOffset,
+                             command.firstInstance);
+        }
+
+        m_Stats.drawCalls += commandCount;
+        return;
+    }
+
+    VkBuffer indirectBuffer = *m_IndirectBuffers[imageIndex];
+    const VkDeviceSize offset = static_cast<VkDeviceSize>(firstCommand) * stride;
+
+    if(features.multiDrawIndirect)
+    {
+        vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffer, offset, commandCount, stride);
+        ++m_Stats.drawCalls;
+        return;
+    }
+
+    for(uint32_t commandIndex = 0; commandIndex < commandCount; ++commandIndex)
+        vkCmdDrawIndexedIndirect(
+            commandBuffer, indirectBuffer, offset + static_cast<VkDeviceSize>(commandIndex) * stride, 1, stride);
+
+    m_Stats.drawCalls += commandCount;
+}
+
+uint64_t RenderQueue::CreateSortKey(uint32_t pipelineId, uint32_t variantIndex, uint32_t materialId, uint32_t meshId,
+                                   float depth)
+{
+    constexpr uint32_t maxDepth{ (1 << 24) - 1 };
+    const auto quantizedDepth = static_cast<uint32_t>(std::clamp(depth, 0.0f, 1.0f) * static_cast<float>(maxDepth));
+
+    return (static_cast<uint64_t>(pipelineId & 0xFF) << 56) | (static_cast<uint64_t>(variantIndex & 0x1F) << 51) |
+           (static_cast<uint64_t>(materialId & 0x7FF) << 40) | (static_cast<uint64_t>(meshId & 0xFFFF) << 24) |
+           static_cast<uint64_t>(quantizedDepth);
+}
+
+void RenderQueue::RadixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch)
+{
+    constexpr int digitCount{ 8 };
+    constexpr int digitSize{ 256 };
+
+    const size_t entryCount = entries.size();
+    if(entryCount < 2)
+        return;
+
+    // Build every histogram in a single pass over the keys
+    std::array<std::array<uint32_t, digitSize>, digitCount> histograms{};
+    for(const SortEntry& entry : entries)
+        for(int digit = 0; digit < digitCount; ++digit)
+            ++histograms[digit][(entry.key >> (digit * 8)) & 0xFF];
+
+    scratch.resize(entryCount);
+    SortEntry* sourcePtr = entries.data();
+    SortEntry* destinationPtr = scratch.data();
+
+    for(int digit = 0; digit < digitCount; ++digit)
+    {
+        std::array<uint32_t, digitSize>& histogram = histograms[digit];
+
+        // Every key shares this digit, sorting on it would not change anything
+        if(histogram[(sourcePtr[0].key >> (digit * 8)) & 0xFF] == entryCount)
+            continue;
+
+        uint32_t offset{};
+        for(uint32_t& count : histogram)
+        {
+            const uint32_t bucketCount = count;
+            count = offset;
+            offset += bucketCount;
+        }
+
+        for(size_t entryIndex = 0; entryIndex < entryCount; ++entryIndex)
+        {
+            const SortEntry& entry = sourcePtr[entryIndex];
+            destinationPtr[histogram[(entry.key >> (digit * 8)) & 0xFF]++] = entry;
+        }
+
+        std::swap(sourcePtr, destinationPtr);
+    }
+
+    if(sourcePtr != entries.data())
+        std::copy(sourcePtr, sourcePtr + entryCount, entries.data());
+}
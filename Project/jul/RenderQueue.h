@@ -0,0 +1,145 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <glm/mat4x4.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Buffer.h"
+#include "CommandEncoder.h"
+#include "OcclusionCuller.h"
+
+class InstanceBuffer;
+class Mesh;
+class Pipeline;
+
+// Collects draws for a frame, sorts them on a 64 bit key and emits them while skipping redundant binds
+//
+// Key layout (most significant first)
+// | pipeline 8 | variant 5 | material 11 | mesh 16 | depth 24 |
+//
+// Every material draws with the cheapest shader variant of its pipeline, draws of a variant are sorted together
+//
+// Pipelines with an instance buffer are drawn indirectly, their transforms go to the instance buffer (set 0, binding 1)
+// and every material set gets one multi draw, consecutive draws of the same mesh are merged into one instanced command
+// Bindless materials share a single set, so all of them are drawn by one multi draw per pipeline variant
+//
+// With an occlusion culler every indirect command becomes a cull object, the culler decides in which phase it is drawn
+class RenderQueue final
+{
+public:
+    struct Stats
+    {
+        uint32_t drawCount{};
+        uint32_t instanceCount{};
+        uint32_t drawCalls{};
+        uint32_t indirectCommands{};
+        uint32_t uploadedInstances{};
+
+        uint32_t pipelineBinds{};
+        uint32_t materialBinds{};
+        uint32_t meshBinds{};
+
+        // Binds the unsorted loop would have issued for the same draws
+        uint32_t naivePipelineBinds{};
+        uint32_t naiveMaterialBinds{};
+        uint32_t naiveMeshBinds{};
+    };
+
+    struct SortEntry
+    {
+        uint64_t key;
+        uint32_t drawIndex;
+    };
+
+    RenderQueue();
+
+    // Pipelines are drawn in the order they are registered
+    uint32_t RegisterPipeline(Pipeline* pipeline, const std::string& name, InstanceBuffer* instanceBuffer = nullptr);
+
+    // Only used for indirect batches, pass null to draw everything in the early phase
+    void SetOcclusionCuller(OcclusionCuller* occlusionCuller) { m_OcclusionCullerPtr = occlusionCuller; }
+
+    void Clear();
+
+    // Depth is expected in the 0 to 1 range, closer draws are emitted first
+    void Add(uint32_t pipelineId, const Mesh* mesh, const glm::mat4& modelMatrix, float depth);
+
+    // Draws every instance of an instanced mesh, only pipelines with an instance buffer can draw these
+    void AddInstanced(uint32_t pipelineId, const Mesh* mesh, float depth);
+
+    void Sort();
+
+    // Builds the batches and uploads the instance data, has to be recorded outside of a render pass
+    void Prepare(VkCommandBuffer commandBuffer, int imageIndex);
+    // The late phase only draws culled indirect batches
+    void Submit(VkCommandBuffer commandBuffer, int imageIndex,
+                OcclusionCuller::Phase phase = OcclusionCuller::Phase::Early);
+
+    [[nodiscard]] const Stats& GetStats() const { return m_Stats; }
+
+    // What the encoder dropped on top of the binds the sorted order already skips
+    [[nodiscard]] const CommandEncoder::Stats& GetEncoderStats() const { return m_Encoder.GetStats(); }
+
+    [[nodiscard]] static uint64_t CreateSortKey(uint32_t pipelineId, uint32_t variantIndex, uint32_t materialId,
+                                                uint32_t meshId, float depth);
+
+    // LSD radix sort on 8 bit digits, digits that are the same for every key are skipped
+    static void RadixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch);
+
+    inline static constexpr uint32_t MAX_INDIRECT_COMMAND_COUNT{ 4'096 };
+
+private:
+    struct Draw
+    {
+        uint32_t pipelineId;
+        uint32_t variantIndex;
+        const Mesh* meshPtr;
+        glm::mat4 modelMatrix;
+        bool instanced;
+    };
+
+    struct PipelineEntry
+    {
+        Pipeline* pipelinePtr;
+        std::string name;
+        InstanceBuffer* instanceBufferPtr;
+    };
+
+    // Direct batches draw a single draw, indirect batches a range of indirect commands
+    struct Batch
+    {
+        uint32_t pipelineId;
+        uint32_t variantIndex;
+        const Mesh* meshPtr;
+        uint32_t drawIndex;
+        bool indirect;
+        uint32_t firstCommand;
+        uint32_t commandCount;
+        uint32_t cullBatchIndex;
+    };
+
+    // Every sorted entry in [begin, end) uses the same pipeline
+    void BuildDirectBatches(size_t begin, size_t end);
+    void BuildIndirectBatches(InstanceBuffer& instanceBuffer, size_t begin, size_t end);
+
+    void DrawIndirect(VkCommandBuffer commandBuffer, int imageIndex, const Batch& batch, OcclusionCuller::Phase phase);
+
+    std::vector<PipelineEntry> m_Pipelines{};
+    std::vector<Draw> m_Draws{};
+    std::vector<SortEntry> m_SortEntries{};
+    std::vector<SortEntry> m_SortScratch{};
+
+    std::vector<Batch> m_Batches{};
+    std::vector<VkDrawIndexedIndirectCommand> m_IndirectCommands{};
+    std::vector<std::unique_ptr<Buffer>> m_IndirectBuffers{};
+
+    OcclusionCuller* m_OcclusionCullerPtr{};
+    uint32_t m_CullBatchCount{};
+
+    CommandEncoder m_Encoder{};
+    Stats m_Stats{};
+};
@@ -1,15 +1,17 @@
 #include "Shader.h"
 
+#include <stdexcept>
+
+#include "ShaderBlob.h"
 #include "vulkanbase/VulkanGlobals.h"
-#include "vulkanbase/VulkanUtil.h"
 
 Shader::Shader(const path& vertexPath, const path& fragmentPath)
 {
     //////////////////////////////
     /// Create vertex shader info
     //////////////////////////////
-    const std::vector<char> vertShaderCode = vulkanUtil::ReadFile(vertexPath.string());
-    const VkShaderModule vertShaderModule = CreateShaderModule(vertShaderCode, VulkanGlobals::GetDevice());
+    const ShaderBlob vertShaderBlob{ vertexPath };
+    const VkShaderModule vertShaderModule = CreateShaderModule(vertShaderBlob.GetCode(), VulkanGlobals::GetDevice());
 
     m_VertexInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     m_VertexInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
@@ -20,8 +22,8 @@ Shader::Shader(const path& vertexPath, const path& fragmentPath)
     //////////////////////////////
     /// Create fragment shader info
     //////////////////////////////
-    const std::vector<char> fragShaderCode = vulkanUtil::ReadFile(fragmentPath.string());
-    const VkShaderModule fragShaderModule = CreateShaderModule(fragShaderCode, VulkanGlobals::GetDevice());
+    const ShaderBlob fragShaderBlob{ fragmentPath };
+    const VkShaderModule fragShaderModule = CreateShaderModule(fragShaderBlob.GetCode(), VulkanGlobals::GetDevice());
 
     m_FragmentInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     m_FragmentInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
@@ -55,12 +57,12 @@ VkPipelineInputAssemblyStateCreateInfo Shader::CreateInputAssemblyStateInfo()
     return inputAssembly;
 }
 
-VkShaderModule Shader::CreateShaderModule(const std::vector<char>& code, VkDevice device)
+VkShaderModule Shader::CreateShaderModule(std::span<const uint32_t> code, VkDevice device)
 {
 	VkShaderModuleCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	createInfo.codeSize = code.size();
-	createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+	createInfo.codeSize = code.size_bytes();
+	createInfo.pCode = code.data();
 
 	VkShaderModule shaderModule;
 	if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
@@ -1,7 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
-#include <vector>
+#include <span>
 #include <vulkan/vulkan_core.h>
 
 using path = std::filesystem::path;
@@ -40,9 +41,10 @@ public:
 
     [[nodiscard]] static VkPipelineInputAssemblyStateCreateInfo CreateInputAssemblyStateInfo();
 
-private:
+    // The code can come straight from a ShaderBlob, Vulkan copies it into the module
+    [[nodiscard]] static VkShaderModule CreateShaderModule(std::span<const uint32_t> code, VkDevice device);
 
-	[[nodiscard]] VkShaderModule CreateShaderModule(const std::vector<char>& code, VkDevice device);
+private:
 
 	VkPipelineShaderStageCreateInfo m_VertexInfo{};
 	VkPipelineShaderStageCreateInfo m_FragmentInfo{};
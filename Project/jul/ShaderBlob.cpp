@@ -0,0 +1,38 @@
+#include "ShaderBlob.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#ifndef JUL_EMBED_SHADERS
+#define JUL_EMBED_SHADERS 0
+#endif
+
+#if JUL_EMBED_SHADERS
+#include "EmbeddedShaders.h"
+#endif
+
+ShaderBlob::ShaderBlob(const std::filesystem::path& shaderPath)
+{
+#if JUL_EMBED_SHADERS
+    // Paths are relative to the working directory, the embedded table only knows file names
+    const std::string fileName = shaderPath.filename().string();
+    const auto embedded = std::ranges::find(embeddedShaders::ENTRIES, fileName, &embeddedShaders::Entry::name);
+
+    if(embedded != embeddedShaders::ENTRIES.end())
+    {
+        m_Code = embedded->code;
+        return;
+    }
+#endif
+
+    m_File.emplace(shaderPath);
+    const std::span<const std::byte> data = m_File->GetData();
+
+    if(data.size() % sizeof(uint32_t) != 0)
+        throw std::runtime_error(shaderPath.string() + " is not a multiple of 4 bytes, it can't be SPIR-V!");
+
+    m_Code = { reinterpret_cast<const uint32_t*>(data.data()), data.size() / sizeof(uint32_t) };
+
+    if(m_Code.front() != SPIRV_MAGIC)
+        throw std::runtime_error(shaderPath.string() + " doesn't start with the SPIR-V magic number!");
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+
+#include "MappedFile.h"
+
+// SPIR-V words of a compiled shader, handed to Vulkan without a copy
+//
+// With JUL_EMBED_SHADERS the shaders are compiled into the executable and found on their file name, so loading them
+// needs no file I/O at all. Anything that isn't embedded is memory mapped from disk
+class ShaderBlob final
+{
+public:
+    explicit ShaderBlob(const std::filesystem::path& shaderPath);
+    ~ShaderBlob() = default;
+
+    ShaderBlob(ShaderBlob&&) = default;
+
+    ShaderBlob(const ShaderBlob&) = delete;
+    ShaderBlob& operator=(ShaderBlob&&) = delete;
+    ShaderBlob& operator=(const ShaderBlob&) = delete;
+
+    // Valid as long as the blob lives
+    [[nodiscard]] std::span<const uint32_t> GetCode() const { return m_Code; }
+    [[nodiscard]] bool IsEmbedded() const { return not m_File.has_value(); }
+
+private:
+    std::optional<MappedFile> m_File{};
+    std::span<const uint32_t> m_Code{};
+
+    inline static constexpr uint32_t SPIRV_MAGIC{ 0x07230203 };
+};
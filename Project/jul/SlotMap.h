@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "Handle.h"
+
+// Owns objects behind generational handles, lookups are two array reads
+// Objects are heap allocated so pointers given to Vulkan wrappers stay valid, the pointers themselves are kept dense
+template<typename T>
+class SlotMap final
+{
+public:
+    SlotMap() = default;
+    ~SlotMap() = default;
+
+    SlotMap(SlotMap&&) = delete;
+    SlotMap(const SlotMap&) = delete;
+    SlotMap& operator=(SlotMap&&) = delete;
+    SlotMap& operator=(const SlotMap&) = delete;
+
+    template<typename... Args>
+    Handle<T> Emplace(Args&&... args)
+    {
+        return Add(std::make_unique<T>(std::forward<Args>(args)...));
+    }
+
+    Handle<T> Add(std::unique_ptr<T> value)
+    {
+        uint32_t slotIndex{};
+        if(m_FreeSlots.empty())
+        {
+            slotIndex = static_cast<uint32_t>(m_Slots.size());
+            m_Slots.push_back({});
+        }
+        else
+        {
+            slotIndex = m_FreeSlots.back();
+            m_FreeSlots.pop_back();
+        }
+
+        Slot& slot = m_Slots[slotIndex];
+        slot.denseIndex = static_cast<uint32_t>(m_Values.size());
+
+        m_Values.push_back(std::move(value));
+        m_DenseToSlot.push_back(slotIndex);
+
+        return { .index = slotIndex, .generation = slot.generation };
+    }
+
+    // The last object moves into the hole so the dense array stays packed
+    void Remove(Handle<T> handle)
+    {
+        if(not Contains(handle))
+            throw std::runtime_error("Removing stale handle!");
+
+        Slot& slot = m_Slots[handle.index];
+        const uint32_t lastSlotIndex = m_DenseToSlot.back();
+
+        m_Values[slot.denseIndex] = std::move(m_Values.back());
+        m_DenseToSlot[slot.denseIndex] = lastSlotIndex;
+        m_Slots[lastSlotIndex].denseIndex = slot.denseIndex;
+
+        m_Values.pop_back();
+        m_DenseToSlot.pop_back();
+
+        ++slot.generation;
+        m_FreeSlots.push_back(handle.index);
+    }
+
+    [[nodiscard]] bool Contains(Handle<T> handle) const
+    {
+        return handle.index < m_Slots.size() and m_Slots[handle.index].generation == handle.generation;
+    }
+
+    // Null for stale handles
+    [[nodiscard]] T* Get(Handle<T> handle) const
+    {
+        if(not Contains(handle))
+            return nullptr;
+
+        return m_Values[m_Slots[handle.index].denseIndex].get();
+    }
+
+    [[nodiscard]] T& At(Handle<T> handle) const
+    {
+        T* valuePtr = Get(handle);
+        if(valuePtr == nullptr)
+            throw std::runtime_error("Accessing stale handle!");
+
+        return *valuePtr;
+    }
+
+    // Live objects in no particular order
+    [[nodiscard]] const std::vector<std::unique_ptr<T>>& GetValues() const { return m_Values; }
+    [[nodiscard]] uint32_t GetCount() const { return static_cast<uint32_t>(m_Values.size()); }
+
+private:
+    struct Slot
+    {
+        uint32_t denseIndex;
+        uint32_t generation;
+    };
+
+    std::vector<Slot> m_Slots{};
+    std::vector<uint32_t> m_FreeSlots{};
+
+    std::vector<std::unique_ptr<T>> m_Values{};
+    std::vector<uint32_t> m_DenseToSlot{};
+};
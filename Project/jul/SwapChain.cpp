@@ -8,10 +8,11 @@
 #include "vulkanbase/VulkanGlobals.h"
 #include "vulkanbase/VulkanUtil.h"
 
-SwapChain::SwapChain(VkSurfaceKHR surface, const glm::ivec2& extents)
+SwapChain::SwapChain(VkSurfaceKHR surface, const glm::ivec2& extents, VkSwapchainKHR oldSwapChain)
 {
-    CreateSwapChain(VulkanGlobals::GetPhysicalDevice(), surface, extents);
+    CreateSwapChain(VulkanGlobals::GetPhysicalDevice(), surface, extents, oldSwapChain);
     CreateImageViews();
+    CreateDepthResources();
 }
 
 SwapChain::~SwapChain()
@@ -22,16 +23,20 @@ SwapChain::~SwapChain()
     for (auto&& imageView : m_SwapChainImageViews)
         vkDestroyImageView(VulkanGlobals::GetDevice(), imageView, nullptr);
 
+    vkDestroyImageView(VulkanGlobals::GetDevice(), m_DepthImageView, nullptr);
+    vkDestroyImage(VulkanGlobals::GetDevice(), m_DepthImage, nullptr);
+    vkFreeMemory(VulkanGlobals::GetDevice(), m_DepthImageMemory, nullptr);
+
     vkDestroySwapchainKHR(VulkanGlobals::GetDevice(), m_SwapChain, nullptr);
 }
 
-void SwapChain::CreateFrameBuffers(RenderPass* renderPass, VkImageView depthImageView)
+void SwapChain::CreateFrameBuffers(RenderPass* renderPass)
 {
     m_SwapChainFramebuffers.resize(m_SwapChainImageViews.size());
 
     for (size_t i = 0; i < m_SwapChainImageViews.size(); i++)
     {
-        std::array<VkImageView, 2> attachments = { m_SwapChainImageViews[i], depthImageView };
+        std::array<VkImageView, 2> attachments = { m_SwapChainImageViews[i], m_DepthImageView };
         const VkFramebufferCreateInfo frameBufferInfo{
             .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
             .renderPass = *renderPass,
@@ -52,7 +57,8 @@ SwapChain::operator VkSwapchainKHR() { return m_SwapChain; }
 
 int SwapChain::GetImageCount() { return static_cast<int>(m_SwapChainImages.size()); }
 
-void SwapChain::CreateSwapChain(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, const glm::ivec2& extents)
+void SwapChain::CreateSwapChain(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, const glm::ivec2& extents,
+                                VkSwapchainKHR oldSwapChain)
 {
     SwapChainSupportDetails const swapChainSupport = QuerySwapChainSupport(physicalDevice, surface);
     VkSurfaceFormatKHR const surfaceFormat = ChooseSwapSurfaceFormat(swapChainSupport.formats);
@@ -94,7 +100,7 @@ void SwapChain::CreateSwapChain(VkPhysicalDevice physicalDevice, VkSurfaceKHR su
     createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     createInfo.presentMode = presentMode;
     createInfo.clipped = VK_TRUE;
-    createInfo.oldSwapchain = VK_NULL_HANDLE;
+    createInfo.oldSwapchain = oldSwapChain;
 
     if(vkCreateSwapchainKHR(VulkanGlobals::GetDevice(), &createInfo, nullptr, &m_SwapChain) != VK_SUCCESS)
         throw std::runtime_error("failed to create swap chain!");
@@ -123,6 +129,22 @@ void SwapChain::CreateImageViews()
     }
 }
 
+void SwapChain::CreateDepthResources()
+{
+    const VkFormat depthFormat = vulkanUtil::FindDepthFormat();
+
+    vulkanUtil::CreateImage(m_SwapChainExtent.width,
+                            m_SwapChainExtent.height,
+                            depthFormat,
+                            VK_IMAGE_TILING_OPTIMAL,
+                            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                            m_DepthImage,
+                            m_DepthImageMemory);
+
+    m_DepthImageView = vulkanUtil::CreateImageView(m_DepthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+}
+
 SwapChainSupportDetails SwapChain::QuerySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface)
 {
     SwapChainSupportDetails details;
@@ -17,12 +17,21 @@ struct SwapChainSupportDetails
 class SwapChain
 {
 public:
-    SwapChain(VkSurfaceKHR surface, const glm::ivec2& extents);
+    // Passing the old swap chain lets the driver reuse its resources, it is retired but stays valid until destroyed
+    SwapChain(VkSurfaceKHR surface, const glm::ivec2& extents, VkSwapchainKHR oldSwapChain = VK_NULL_HANDLE);
     ~SwapChain();
 
+    SwapChain(SwapChain&&) = delete;
+    SwapChain(const SwapChain&) = delete;
+    SwapChain& operator=(SwapChain&&) = delete;
+    SwapChain& operator=(const SwapChain&) = delete;
+
     VkFormat GetImageFormat() {return m_SwapChainImageFormat; }
 
-    void CreateFrameBuffers(RenderPass* renderPass, VkImageView depthImageView);
+    void CreateFrameBuffers(RenderPass* renderPass);
+
+    [[nodiscard]] VkImage GetDepthImage() const { return m_DepthImage; }
+    [[nodiscard]] VkImageView GetDepthImageView() const { return m_DepthImageView; }
 
     operator VkSwapchainKHR();
 
@@ -38,8 +47,10 @@ public:
     [[nodiscard]] int GetImageCount();
 
 private:
-    void CreateSwapChain(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, const glm::ivec2& extents);
+    void CreateSwapChain(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, const glm::ivec2& extents,
+                         VkSwapchainKHR oldSwapChain);
     void CreateImageViews();
+    void CreateDepthResources();
 
 
     SwapChainSupportDetails QuerySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface);
@@ -55,4 +66,9 @@ private:
     std::vector<VkImageView> m_SwapChainImageViews;
 
     std::vector<VkFramebuffer> m_SwapChainFramebuffers;
+
+    // Depth target always matches the swap chain extent
+    VkImage m_DepthImage{};
+    VkDeviceMemory m_DepthImageMemory{};
+    VkImageView m_DepthImageView{};
 };
@@ -2,55 +2,289 @@
 
 #include <external/stb/stb_image.h>
 
+#include <algorithm>
+#include <cstring>
 #include <filesystem>
 #include <glm/vec2.hpp>
+#include <span>
 #include <stdexcept>
 
-#include "Buffer.h"
-#include "jul/CommandBuffer.h"
+#include "Ktx2File.h"
+#include "UploadBatch.h"
+#include "jul/CpuProfiler.h"
 #include "vulkan/vulkan_core.h"
 #include "vulkanbase/VulkanGlobals.h"
 #include "vulkanbase/VulkanUtil.h"
 
-Texture::Texture(const std::string& filePath)
+Texture::Source Texture::Decode(const std::string& filePath, Usage usage)
 {
-    using namespace std::string_literals;
+    JUL_PROFILE_ZONE("Texture::Decode");
 
     if(not std::filesystem::exists(filePath))
         throw std::runtime_error("Failed to find file: " + filePath);
 
+    Source source{};
+
+    // Compressed versions are made offline by TextureCompressor and sit next to the source image
+    const std::filesystem::path compressedPath = std::filesystem::path{ filePath }.replace_extension(".ktx2");
+    if(std::filesystem::exists(compressedPath))
+    {
+        Ktx2File compressedFile{ compressedPath };
+        if(CanSample(compressedFile.GetFormat()))
+        {
+            DecodeCompressed(std::move(compressedFile), source);
+            return source;
+        }
+
+        if(std::filesystem::path{ filePath }.extension() == ".ktx2")
+            throw std::runtime_error("The device can't sample the format of " + filePath + "!");
+    }
+
+    DecodeUncompressed(filePath, usage, source);
+    return source;
+}
+
+Texture::Texture(const std::string& filePath, Usage usage)
+{
+    UploadBatch batch{};
+    Create(Decode(filePath, usage), batch);
+    batch.Submit();
+}
+
+Texture::Texture(const Source& source, UploadBatch& batch)
+{
+    Create(source, batch);
+}
+
+void Texture::PixelDeleter::operator()(uint8_t* pixels) const
+{
+    stbi_image_free(pixels);
+}
+
+Texture::Source Texture::DecodePacked(const std::vector<PackedChannel>& channels)
+{
+    JUL_PROFILE_ZONE("Texture::DecodePacked");
+
+    using namespace std::string_literals;
+
+    if(channels.size() > 4)
+        throw std::invalid_argument("Packed textures have at most four channels!");
+
+    // Without any file the texture is a single texel of the fallbacks
+    std::vector<std::unique_ptr<uint8_t, PixelDeleter>> channelPixels(channels.size());
+    glm::ivec2 imageSize{ 1, 1 };
+    bool hasImageSize{};
+
+    for(size_t channelIndex = 0; channelIndex < channels.size(); ++channelIndex)
+    {
+        const std::string& filePath = channels[channelIndex].filePath;
+        if(filePath.empty())
+            continue;
+
+        glm::ivec2 channelSize{};
+        int channelCount{};
+        channelPixels[channelIndex].reset(
+            stbi_load(filePath.c_str(), &channelSize.x, &channelSize.y, &channelCount, STBI_grey));
+
+        if(channelPixels[channelIndex] == nullptr)
+            throw std::runtime_error("Failed to load texture image!"s + stbi_failure_reason());
+
+        if(hasImageSize and channelSize != imageSize)
+            throw std::runtime_error("Packed channels need images of the same size, " + filePath + " differs!");
+
+        imageSize = channelSize;
+        hasImageSize = true;
+    }
+
+    Source source{ .format = VK_FORMAT_R8G8B8A8_UNORM };
+
+    const size_t texelCount = static_cast<size_t>(imageSize.x) * static_cast<size_t>(imageSize.y);
+    source.packedPixels.resize(texelCount * 4, 255);
+
+    for(size_t channelIndex = 0; channelIndex < channels.size(); ++channelIndex)
+    {
+        const uint8_t* channel = channelPixels[channelIndex].get();
+        for(size_t texelIndex = 0; texelIndex < texelCount; ++texelIndex)
+            source.packedPixels[texelIndex * 4 + channelIndex] =
+                channel != nullptr ? channel[texelIndex] : channels[channelIndex].fallback;
+    }
+
+    channelPixels.clear();
+
+    CreateLevels(source.packedPixels.data(),
+                 static_cast<uint32_t>(imageSize.x),
+                 static_cast<uint32_t>(imageSize.y),
+                 4,
+                 source);
+
+    return source;
+}
+
+void Texture::DecodeUncompressed(const std::string& filePath, Usage usage, Source& source)
+{
+    using namespace std::string_literals;
+
     glm::ivec2 imageSize{};
-    int channelCount{};  // We force STBI_rgb_alpha so always 4
+    int fileChannelCount{};
+    if(stbi_info(filePath.c_str(), &imageSize.x, &imageSize.y, &fileChannelCount) == 0)
+        throw std::runtime_error("Failed to load texture image!"s + stbi_failure_reason());
+
+    // There is no widely sampleable RGB8 or single channel sRGB format, so only grey and grey alpha data images
+    // keep their channel count
+    const bool keepChannels = usage == Usage::Data and fileChannelCount <= STBI_grey_alpha;
+    const int channelCount = keepChannels ? fileChannelCount : STBI_rgb_alpha;
 
-    stbi_uc* pixelsPtr = stbi_load(filePath.c_str(), &imageSize.x, &imageSize.y, &channelCount, STBI_rgb_alpha);
-    const VkDeviceSize imageBufferSize = imageSize.x * imageSize.y * 4;
+    stbi_uc* pixelsPtr = stbi_load(filePath.c_str(), &imageSize.x, &imageSize.y, &fileChannelCount, channelCount);
 
     if(pixelsPtr == nullptr)
         throw std::runtime_error("Failed to load texture image!"s + stbi_failure_reason());
 
-    Buffer imageStagingBuffer = { imageBufferSize,
-                                  VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+    source.pixels.reset(pixelsPtr);
 
-    imageStagingBuffer.Upload(pixelsPtr, imageBufferSize);
-    stbi_image_free(pixelsPtr);
+    switch(channelCount)
+    {
+        case STBI_grey:
+            source.format = VK_FORMAT_R8_UNORM;
+            source.components = {
+                VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_ONE
+            };
+            break;
 
-    vulkanUtil::CreateImage(imageSize.x,
-                            imageSize.y,
-                            VK_FORMAT_R8G8B8A8_SRGB,
+        case STBI_grey_alpha:
+            source.format = VK_FORMAT_R8G8_UNORM;
+            source.components = {
+                VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G
+            };
+            break;
+
+        default:
+            source.format = usage == Usage::Color ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+            break;
+    }
+
+    CreateLevels(pixelsPtr,
+                 static_cast<uint32_t>(imageSize.x),
+                 static_cast<uint32_t>(imageSize.y),
+                 static_cast<uint32_t>(channelCount),
+                 source);
+}
+
+void Texture::CreateLevels(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channelCount,
+                           Source& source)
+{
+    // Materials skip sampling textures that hold a single value
+    const size_t texelCount = static_cast<size_t>(width) * static_cast<size_t>(height);
+    bool isUniform{ true };
+    for(size_t texelIndex = 1; texelIndex < texelCount and isUniform; ++texelIndex)
+        isUniform = std::memcmp(pixels + texelIndex * channelCount, pixels, channelCount) == 0;
+
+    // Spread over RGBA the same way the view does
+    if(isUniform and channelCount == 1)
+        source.uniformTexel = std::array<uint8_t, 4>{ pixels[0], pixels[0], pixels[0], 255 };
+    else if(isUniform and channelCount == 2)
+        source.uniformTexel = std::array<uint8_t, 4>{ pixels[0], pixels[0], pixels[0], pixels[1] };
+    else if(isUniform)
+        source.uniformTexel = std::array<uint8_t, 4>{ pixels[0], pixels[1], pixels[2], pixels[3] };
+
+    source.mipLevels = MipChain::GetLevelCount(width, height);
+    source.blitMipmaps = CanBlitMipmaps(source.format);
+
+    // Only the base level is uploaded when the GPU blits the rest
+    if(source.blitMipmaps)
+    {
+        source.levels.push_back({
+            .width = width,
+            .height = height,
+            .data = std::as_bytes(std::span{ pixels, texelCount * channelCount }),
+        });
+        return;
+    }
+
+    const bool srgb = source.format == VK_FORMAT_R8G8B8A8_SRGB;
+    const MipChain& mipChain = source.mipChain.emplace(pixels, width, height, channelCount, srgb);
+    const std::span<const std::byte> chainData = std::as_bytes(std::span{ mipChain.GetData() });
+
+    for(const MipChain::Level& level : mipChain.GetLevels())
+        source.levels.push_back({
+            .width = level.width,
+            .height = level.height,
+            .data = chainData.subspan(level.offset, static_cast<size_t>(level.width) * level.height * channelCount),
+        });
+
+    // The chain holds its own copy of the base level
+    source.pixels.reset();
+    source.packedPixels = {};
+}
+
+void Texture::DecodeCompressed(Ktx2File&& file, Source& source)
+{
+    // The level spans point into the mapping, which moves along with the file
+    source.format = file.GetFormat();
+    source.levels = file.GetLevels();
+    source.uniformTexel = file.GetUniformTexel();
+    source.mipLevels = static_cast<uint32_t>(source.levels.size());
+    source.compressedFile.emplace(std::move(file));
+}
+
+void Texture::Create(const Source& source, UploadBatch& batch)
+{
+    JUL_PROFILE_ZONE("Texture::Create");
+
+    m_Format = source.format;
+    m_MipLevels = source.mipLevels;
+    m_UniformTexel = source.uniformTexel;
+
+    // Copies have to start on a whole texel or block, 16 bytes covers every format
+    std::vector<MipChain::Level> uploadLevels{};
+    VkDeviceSize uploadSize{};
+    for(const Ktx2File::Level& level : source.levels)
+    {
+        uploadSize = (uploadSize + 15) / 16 * 16;
+        uploadLevels.push_back({ .width = level.width, .height = level.height, .offset = uploadSize });
+        uploadSize += level.data.size();
+    }
+
+    // Every level shares one staging allocation, the offsets become offsets into the staging buffer
+    const UploadBatch::Allocation staging = batch.Allocate(uploadSize);
+    for(size_t levelIndex = 0; levelIndex < source.levels.size(); ++levelIndex)
+    {
+        const std::span<const std::byte> levelData = source.levels[levelIndex].data;
+        std::memcpy(staging.data + uploadLevels[levelIndex].offset, levelData.data(), levelData.size());
+        uploadLevels[levelIndex].offset += staging.offset;
+    }
+
+    VkImageUsageFlags usage{ VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT };
+    if(source.blitMipmaps)
+        usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+    const Ktx2File::Level& baseLevel = source.levels.front();
+    vulkanUtil::CreateImage(baseLevel.width,
+                            baseLevel.height,
+                            m_Format,
                             VK_IMAGE_TILING_OPTIMAL,
-                            VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                            usage,
                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
                             m_Image,
-                            m_ImageMemory);
+                            m_ImageMemory,
+                            m_MipLevels);
 
-    TransitionImageLayout(m_Image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    CopyBufferToImage(imageStagingBuffer, m_Image, imageSize.x, imageSize.y);
+    const VkCommandBuffer commandBuffer = batch.GetCommandBuffer();
 
-    TransitionImageLayout(m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    TransitionImageLayout(
+        commandBuffer, m_Image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, m_MipLevels);
+    CopyBufferToImage(commandBuffer, staging.buffer, m_Image, uploadLevels);
+
+    if(source.blitMipmaps)
+        BlitMipmaps(commandBuffer, m_Image, baseLevel.width, baseLevel.height, m_MipLevels);
+    else
+        TransitionImageLayout(commandBuffer,
+                              m_Image,
+                              VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                              VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                              m_MipLevels);
 
     descriptorImageInfo.imageView =
-        vulkanUtil::CreateImageView(m_Image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT);
+        vulkanUtil::CreateImageView(m_Image, m_Format, VK_IMAGE_ASPECT_COLOR_BIT, m_MipLevels, source.components);
 
     CreateTextureSampler(VK_SAMPLER_ADDRESS_MODE_REPEAT);
 
@@ -58,7 +292,8 @@ Texture::Texture(const std::string& filePath)
     descriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 }
 
-void Texture::TransitionImageLayout(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout)
+void Texture::TransitionImageLayout(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout oldLayout,
+                                    VkImageLayout newLayout, uint32_t mipLevels)
 {
     VkImageMemoryBarrier barrier
         {
@@ -74,7 +309,7 @@ void Texture::TransitionImageLayout(VkImage image, VkImageLayout oldLayout, VkIm
             {            
                 .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
                 .baseMipLevel = 0,
-                .levelCount = 1,
+                .levelCount = mipLevels,
                 .baseArrayLayer = 0,
                 .layerCount = 1,
             }
@@ -104,38 +339,148 @@ void Texture::TransitionImageLayout(VkImage image, VkImageLayout oldLayout, VkIm
         throw std::invalid_argument("Unsupported layout transition!");
     }
 
+    vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
 
-    CommandBuffer transitionBuffer{ VulkanGlobals::GetDevice() };
-    transitionBuffer.BeginBuffer();
+void Texture::CopyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer buffer, VkImage image,
+                                const std::vector<MipChain::Level>& levels)
+{
+    std::vector<VkBufferImageCopy> regions{};
+    regions.reserve(levels.size());
+
+    for(uint32_t levelIndex = 0; levelIndex < levels.size(); ++levelIndex)
     {
-        vkCmdPipelineBarrier(transitionBuffer, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        const MipChain::Level& level = levels[levelIndex];
+        regions.push_back({
+            .bufferOffset = level.offset,
+            .bufferRowLength = 0,
+            .bufferImageHeight = 0,
+            .imageSubresource =
+            {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = levelIndex,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+            .imageOffset = {           0,            0, 0},
+            .imageExtent = { level.width, level.height, 1},
+        });
     }
-    transitionBuffer.EndBuffer();
+
+    vkCmdCopyBufferToImage(commandBuffer,
+                           buffer,
+                           image,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           static_cast<uint32_t>(regions.size()),
+                           regions.data());
 }
 
-void Texture::CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height)
+bool Texture::CanSample(VkFormat format)
 {
-    const VkBufferImageCopy region{
-        .bufferOffset = 0,
-        .bufferRowLength = 0,
-        .bufferImageHeight = 0,
-        .imageSubresource = 
+    // BC formats need the device feature on top of the format support
+    const bool isBlockCompressed = format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK and format <= VK_FORMAT_BC7_SRGB_BLOCK;
+    if(isBlockCompressed and not VulkanGlobals::GetEnabledFeatures().textureCompressionBC)
+        return false;
+
+    VkFormatProperties properties{};
+    vkGetPhysicalDeviceFormatProperties(VulkanGlobals::GetPhysicalDevice(), format, &properties);
+
+    constexpr VkFormatFeatureFlags requiredFeatures{ VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT |
+                                                     VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT };
+    return (properties.optimalTilingFeatures & requiredFeatures) == requiredFeatures;
+}
+
+bool Texture::CanBlitMipmaps(VkFormat format)
+{
+    VkFormatProperties properties{};
+    vkGetPhysicalDeviceFormatProperties(VulkanGlobals::GetPhysicalDevice(), format, &properties);
+
+    constexpr VkFormatFeatureFlags requiredFeatures{ VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+                                                     VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT };
+    return (properties.optimalTilingFeatures & requiredFeatures) == requiredFeatures;
+}
+
+void Texture::BlitMipmaps(VkCommandBuffer commandBuffer, VkImage image, uint32_t width, uint32_t height,
+                          uint32_t mipLevels)
+{
+    VkImageMemoryBarrier barrier{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = image,
+        .subresourceRange =
         {
             .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-            .mipLevel = 0,
+            .levelCount = 1,
             .baseArrayLayer = 0,
             .layerCount = 1,
         },
-        .imageOffset = {    0,      0, 0},
-        .imageExtent = {width, height, 1},
     };
 
-    CommandBuffer imageCopyBuffer{ VulkanGlobals::GetDevice() };
-    imageCopyBuffer.BeginBuffer();
+    auto transitionLevel = [&barrier, commandBuffer](uint32_t level, VkImageLayout oldLayout, VkImageLayout newLayout,
+                                                     VkAccessFlags srcAccess, VkAccessFlags dstAccess,
+                                                     VkPipelineStageFlags dstStage)
+    {
+        barrier.subresourceRange.baseMipLevel = level;
+        barrier.oldLayout = oldLayout;
+        barrier.newLayout = newLayout;
+        barrier.srcAccessMask = srcAccess;
+        barrier.dstAccessMask = dstAccess;
+        vkCmdPipelineBarrier(
+            commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    };
+
+    auto levelWidth = static_cast<int32_t>(width);
+    auto levelHeight = static_cast<int32_t>(height);
+
+    // Blits convert sRGB to linear before filtering, so each level is the linear average of the one above it
+    for(uint32_t level = 1; level < mipLevels; ++level)
     {
-        vkCmdCopyBufferToImage(imageCopyBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        transitionLevel(level - 1,
+                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                        VK_ACCESS_TRANSFER_WRITE_BIT,
+                        VK_ACCESS_TRANSFER_READ_BIT,
+                        VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+        const int32_t nextWidth = std::max(levelWidth / 2, 1);
+        const int32_t nextHeight = std::max(levelHeight / 2, 1);
+
+        const VkImageBlit blit{
+            .srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1 },
+            .srcOffsets = { { 0, 0, 0 }, { levelWidth, levelHeight, 1 } },
+            .dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 },
+            .dstOffsets = { { 0, 0, 0 }, { nextWidth, nextHeight, 1 } },
+        };
+
+        vkCmdBlitImage(commandBuffer,
+                       image,
+                       VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                       image,
+                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                       1,
+                       &blit,
+                       VK_FILTER_LINEAR);
+
+        // Done as a source, so it can go to the shaders right away
+        transitionLevel(level - 1,
+                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                        VK_ACCESS_TRANSFER_READ_BIT,
+                        VK_ACCESS_SHADER_READ_BIT,
+                        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+        levelWidth = nextWidth;
+        levelHeight = nextHeight;
     }
-    imageCopyBuffer.EndBuffer();
+
+    // The smallest level is never blitted from
+    transitionLevel(mipLevels - 1,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                    VK_ACCESS_TRANSFER_WRITE_BIT,
+                    VK_ACCESS_SHADER_READ_BIT,
+                    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
 }
 
 void Texture::CreateTextureSampler(VkSamplerAddressMode addressMode)
@@ -157,7 +502,7 @@ void Texture::CreateTextureSampler(VkSamplerAddressMode addressMode)
         .compareEnable = VK_FALSE,
         .compareOp = VK_COMPARE_OP_ALWAYS,
         .minLod = 0.0f,
-        .maxLod = 0.0f,
+        .maxLod = static_cast<float>(m_MipLevels),
         .borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
         .unnormalizedCoordinates = VK_FALSE,
     };
@@ -2,13 +2,72 @@
 
 #include <vulkan/vulkan_core.h>
 
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
+#include <vector>
+
+#include "Ktx2File.h"
+#include "MipChain.h"
+
+class UploadBatch;
 
 
 class Texture
 {
 public:
-    Texture(const std::string& filePath);
+    struct PixelDeleter
+    {
+        void operator()(uint8_t* pixels) const;
+    };
+
+    // Everything read from disk for one texture, decoding doesn't touch the device so it can run on any thread
+    struct Source
+    {
+        VkFormat format{};
+        // Spreads one and two channel formats over RGBA like stb does for grey images
+        VkComponentMapping components{};
+        uint32_t mipLevels{ 1 };
+        // Only level 0 is in levels when the rest is blitted on the GPU
+        bool blitMipmaps{};
+        std::vector<Ktx2File::Level> levels{};
+        std::optional<std::array<uint8_t, 4>> uniformTexel{};
+
+        // Own the memory the levels point into
+        std::unique_ptr<uint8_t, PixelDeleter> pixels{};
+        std::vector<uint8_t> packedPixels{};
+        std::optional<MipChain> mipChain{};
+        std::optional<Ktx2File> compressedFile{};
+    };
+
+    // Color is sRGB encoded, data like normals and masks is sampled as it is stored
+    enum class Usage
+    {
+        Color,
+        Data
+    };
+
+    // One channel of a packed texture, the fallback fills the channel when there is no file
+    struct PackedChannel
+    {
+        std::string filePath;
+        uint8_t fallback;
+    };
+
+    // Loads the KTX2 file next to the image instead when there is one and the device can sample its format
+    // Data images with one or two channels keep their channel count, color is always RGBA
+    [[nodiscard]] static Source Decode(const std::string& filePath, Usage usage);
+
+    // Packs the grey value of each file into its own channel of a linear RGBA8 texture, alpha is left at full
+    // Every file needs the same size, packed textures are never compressed
+    [[nodiscard]] static Source DecodePacked(const std::vector<PackedChannel>& channels);
+
+    // Decodes and uploads right away
+    Texture(const std::string& filePath, Usage usage);
+    // Records the upload into the batch, the texture can be sampled once the batch is submitted
+    Texture(const Source& source, UploadBatch& batch);
     ~Texture();
 
     Texture(Texture&&) = delete;
@@ -18,14 +77,45 @@ public:
 
     [[nodiscard]] const VkDescriptorImageInfo& GetDescriptorInfo() const { return descriptorImageInfo; }
 
+    // Set when every texel holds the same RGBA value, like the default placeholder textures
+    [[nodiscard]] const std::optional<std::array<uint8_t, 4>>& GetUniformTexel() const { return m_UniformTexel; }
+
+
+    [[nodiscard]] uint32_t GetMipLevelCount() const { return m_MipLevels; }
 
 private:
-    static void TransitionImageLayout(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout);
-    static void CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
+    // Decodes color to sRGB RGBA8 and data to R8, RG8 or RGBA8
+    static void DecodeUncompressed(const std::string& filePath, Usage usage, Source& source);
+    // Takes over the base level, the CPU fills in the mips when the GPU can't blit them
+    static void CreateLevels(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t channelCount,
+                             Source& source);
+    // The blocks and mips of the file are uploaded as they are
+    static void DecodeCompressed(Ktx2File&& file, Source& source);
+
+    void Create(const Source& source, UploadBatch& batch);
+
+    [[nodiscard]] static bool CanSample(VkFormat format);
+
+    // Covers every mip level
+    static void TransitionImageLayout(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout oldLayout,
+                                      VkImageLayout newLayout, uint32_t mipLevels);
+    // One copy per level, the offsets are into the buffer
+    static void CopyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer buffer, VkImage image,
+                                  const std::vector<MipChain::Level>& levels);
+
+    // Blitting needs linear filtering support for the format, the CPU fills in the levels otherwise
+    [[nodiscard]] static bool CanBlitMipmaps(VkFormat format);
+    // Expects every level in transfer dst with level 0 filled in, leaves every level shader read only
+    static void BlitMipmaps(VkCommandBuffer commandBuffer, VkImage image, uint32_t width, uint32_t height,
+                            uint32_t mipLevels);
 
     void CreateTextureSampler(VkSamplerAddressMode addressMode);
 
     VkDescriptorImageInfo descriptorImageInfo{};
     VkImage m_Image{};
     VkDeviceMemory m_ImageMemory{};
+    VkFormat m_Format{};
+    uint32_t m_MipLevels{ 1 };
+
+    std::optional<std::array<uint8_t, 4>> m_UniformTexel{};
 };
@@ -0,0 +1,124 @@
+#include "TextureLoader.h"
+
+#include <vector>
+
+#include "ThreadPool.h"
+#include "UploadBatch.h"
+#include "jul/CpuProfiler.h"
+
+TextureLoader::TextureLoader(ThreadPool& threadPool) :
+    m_ThreadPool(threadPool)
+{
+}
+
+TextureLoader::~TextureLoader()
+{
+    std::unique_lock lock{ m_Mutex };
+    m_DecodedCondition.wait(lock, [this] { return m_DecodingCount == 0; });
+}
+
+void TextureLoader::Request(const std::string& filePath, Texture::Usage usage, TextureHandle& handle)
+{
+    Enqueue([filePath, usage] { return Texture::Decode(filePath, usage); }, handle);
+}
+
+void TextureLoader::RequestOrm(const std::string& occlusionPath, const std::string& roughnessPath,
+                               const std::string& metallicPath, TextureHandle& handle)
+{
+    std::vector<Texture::PackedChannel> channels{
+        { .filePath = occlusionPath, .fallback = 255 },
+        { .filePath = roughnessPath, .fallback = 255 },
+        { .filePath = metallicPath, .fallback = 0 },
+    };
+
+    Enqueue([channels = std::move(channels)] { return Texture::DecodePacked(channels); }, handle);
+}
+
+void TextureLoader::Enqueue(std::function<Texture::Source()> decode, TextureHandle& handle)
+{
+    const size_t index = m_PendingTextures.size();
+    PendingTexture& pendingTexture = m_PendingTextures.emplace_back(PendingTexture{
+        .decode = std::move(decode),
+        .handlePtr = &handle,
+    });
+
+    {
+        const std::lock_guard lock{ m_Mutex };
+        ++m_DecodingCount;
+    }
+
+    m_ThreadPool.Enqueue(
+        [this, &pendingTexture, index]
+        {
+            try
+            {
+                pendingTexture.source.emplace(pendingTexture.decode());
+            }
+            catch(...)
+            {
+                pendingTexture.error = std::current_exception();
+            }
+
+            // Notified under the lock, the loader can be destroyed as soon as the count reaches zero
+            const std::lock_guard lock{ m_Mutex };
+            m_DecodedIndices.push_back(index);
+            --m_DecodingCount;
+            m_DecodedCondition.notify_all();
+        });
+}
+
+void TextureLoader::Finish(SlotMap<Texture>& textures)
+{
+    JUL_PROFILE_ZONE("TextureLoader::Finish");
+
+    UploadBatch batch{};
+
+    // Recorded into the open batch, their images stay empty until it is submitted
+    std::vector<TextureHandle*> unsubmittedHandlePtrs{};
+
+    try
+    {
+        for(size_t uploadedCount = 0; uploadedCount < m_PendingTextures.size(); ++uploadedCount)
+        {
+            size_t index{};
+            {
+                std::unique_lock lock{ m_Mutex };
+                m_DecodedCondition.wait(lock, [this] { return not m_DecodedIndices.empty(); });
+                index = m_DecodedIndices.front();
+                m_DecodedIndices.pop_front();
+            }
+
+            PendingTexture& pendingTexture = m_PendingTextures[index];
+            if(pendingTexture.error != nullptr)
+                std::rethrow_exception(pendingTexture.error);
+
+            *pendingTexture.handlePtr = textures.Emplace(*pendingTexture.source, batch);
+            unsubmittedHandlePtrs.push_back(pendingTexture.handlePtr);
+
+            // The pixels are in staging memory now
+            pendingTexture.source.reset();
+
+            if(batch.GetStagedSize() >= STAGING_BUDGET)
+            {
+                batch.Submit();
+                unsubmittedHandlePtrs.clear();
+            }
+        }
+
+        if(batch.GetStagedSize() > 0)
+            batch.Submit();
+    }
+    catch(...)
+    {
+        // The open batch is dropped without submitting, so its textures would never be filled in
+        for(TextureHandle* handlePtr : unsubmittedHandlePtrs)
+        {
+            textures.Remove(*handlePtr);
+            *handlePtr = {};
+        }
+
+        throw;
+    }
+
+    m_PendingTextures.clear();
+}
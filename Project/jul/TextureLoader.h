@@ -0,0 +1,69 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "Handle.h"
+#include "SlotMap.h"
+#include "Texture.h"
+
+class ThreadPool;
+
+// Decodes images on the thread pool while the calling thread records their uploads in the order they finish
+//
+// Uploads share staging memory and one command buffer, a batch is submitted whenever its staged data passes the budget
+class TextureLoader final
+{
+public:
+    explicit TextureLoader(ThreadPool& threadPool);
+    // Waits for decodes that are still running
+    ~TextureLoader();
+
+    TextureLoader(TextureLoader&&) = delete;
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(TextureLoader&&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    // Decoding starts right away, handle is filled in by Finish and has to stay alive until then
+    void Request(const std::string& filePath, Texture::Usage usage, TextureHandle& handle);
+
+    // Packs occlusion, roughness and metallic into RGB like glTF, the layout materials sample
+    // An empty path leaves the channel flat, no occlusion, full roughness and no metal
+    // Packed maps stay uncompressed RGBA8, TextureCompressor only compresses single images
+    void RequestOrm(const std::string& occlusionPath, const std::string& roughnessPath,
+                    const std::string& metallicPath, TextureHandle& handle);
+
+    // Creates every requested texture and only returns once all of them are uploaded
+    // Rethrows the first decode or upload error, textures of the batch that was still open are removed first and their
+    // handles reset, textures of batches that were already submitted stay
+    void Finish(SlotMap<Texture>& textures);
+
+private:
+    void Enqueue(std::function<Texture::Source()> decode, TextureHandle& handle);
+
+    inline static constexpr VkDeviceSize STAGING_BUDGET{ 128 << 20 };
+
+    struct PendingTexture
+    {
+        std::function<Texture::Source()> decode;
+        TextureHandle* handlePtr;
+        std::optional<Texture::Source> source{};
+        std::exception_ptr error{};
+    };
+
+    ThreadPool& m_ThreadPool;
+
+    // A deque so the decode tasks can hold on to their entry while more are requested
+    std::deque<PendingTexture> m_PendingTextures{};
+
+    std::mutex m_Mutex{};
+    std::condition_variable m_DecodedCondition{};
+    std::deque<size_t> m_DecodedIndices{};
+    size_t m_DecodingCount{};
+};
@@ -0,0 +1,113 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include "jul/CpuProfiler.h"
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+    m_Threads.reserve(threadCount);
+    for(uint32_t threadIndex = 0; threadIndex < threadCount; ++threadIndex)
+        m_Threads.emplace_back(&ThreadPool::WorkerLoop, this, threadIndex);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        const std::lock_guard lock{ m_Mutex };
+        m_Stopping = true;
+    }
+
+    m_TaskCondition.notify_all();
+
+    for(std::thread& thread : m_Threads)
+        thread.join();
+}
+
+void ThreadPool::Enqueue(std::function<void()> task)
+{
+    {
+        const std::lock_guard lock{ m_Mutex };
+        m_Tasks.push_back(std::move(task));
+    }
+
+    m_TaskCondition.notify_one();
+}
+
+void ThreadPool::ParallelFor(uint32_t count, const std::function<void(uint32_t index)>& function)
+{
+    if(count == 0)
+        return;
+
+    // Helpers can start after every index is taken, so the shared state outlives this call
+    struct State
+    {
+        std::atomic<uint32_t> nextIndex{};
+        std::atomic<uint32_t> doneCount{};
+        uint32_t count{};
+        const std::function<void(uint32_t)>* functionPtr{};
+    };
+
+    auto statePtr = std::make_shared<State>();
+    statePtr->count = count;
+    statePtr->functionPtr = &function;
+
+    // The function is only used while an index is left, and the caller waits for every index to finish
+    auto work = [statePtr]
+    {
+        for(uint32_t index = statePtr->nextIndex++; index < statePtr->count; index = statePtr->nextIndex++)
+        {
+            (*statePtr->functionPtr)(index);
+
+            if(++statePtr->doneCount == statePtr->count)
+                statePtr->doneCount.notify_all();
+        }
+    };
+
+    const uint32_t helperCount = std::min(GetThreadCount(), count - 1);
+    for(uint32_t helper = 0; helper < helperCount; ++helper)
+        Enqueue(work);
+
+    work();
+
+    for(uint32_t doneCount = statePtr->doneCount; doneCount != count; doneCount = statePtr->doneCount)
+        statePtr->doneCount.wait(doneCount);
+}
+
+void ThreadPool::WaitIdle()
+{
+    std::unique_lock lock{ m_Mutex };
+    m_IdleCondition.wait(lock, [this] { return m_Tasks.empty() and m_RunningCount == 0; });
+}
+
+void ThreadPool::WorkerLoop(uint32_t threadIndex)
+{
+    CpuProfiler::SetThreadName("Worker " + std::to_string(threadIndex));
+
+    while(true)
+    {
+        std::function<void()> task{};
+        {
+            std::unique_lock lock{ m_Mutex };
+            m_TaskCondition.wait(lock, [this] { return m_Stopping or not m_Tasks.empty(); });
+
+            if(m_Stopping and m_Tasks.empty())
+                return;
+
+            task = std::move(m_Tasks.front());
+            m_Tasks.pop_front();
+            ++m_RunningCount;
+        }
+
+        task();
+
+        {
+            const std::lock_guard lock{ m_Mutex };
+            --m_RunningCount;
+        }
+
+        m_IdleCondition.notify_all();
+    }
+}
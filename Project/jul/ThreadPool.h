@@ -0,0 +1,47 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads pulling tasks from one queue
+class ThreadPool final
+{
+public:
+    // Defaults to one worker less than the hardware threads, the calling thread helps out in ParallelFor
+    explicit ThreadPool(uint32_t threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1);
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void Enqueue(std::function<void()> task);
+
+    // Runs function for every index in [0, count) on the workers and the calling thread, returns once all are done
+    void ParallelFor(uint32_t count, const std::function<void(uint32_t index)>& function);
+
+    // Blocks until the queue is empty and no task is running
+    void WaitIdle();
+
+    [[nodiscard]] uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Threads.size()); }
+
+private:
+    void WorkerLoop(uint32_t threadIndex);
+
+    std::vector<std::thread> m_Threads{};
+    std::deque<std::function<void()>> m_Tasks{};
+
+    std::mutex m_Mutex{};
+    std::condition_variable m_TaskCondition{};
+    std::condition_variable m_IdleCondition{};
+    uint32_t m_RunningCount{};
+    bool m_Stopping{};
+};
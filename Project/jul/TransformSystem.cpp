@@ -0,0 +1,140 @@
+#include "TransformSystem.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "jul/CpuProfiler.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define JUL_TRANSFORM_SSE 1
+#endif
+
+namespace
+{
+    glm::mat4 ComposeTrs(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+    {
+        const glm::mat3 rotationMatrix = glm::mat3_cast(rotation);
+
+        return {
+            glm::vec4{ rotationMatrix[0] * scale.x, 0.0f },
+            glm::vec4{ rotationMatrix[1] * scale.y, 0.0f },
+            glm::vec4{ rotationMatrix[2] * scale.z, 0.0f },
+            glm::vec4{ position, 1.0f },
+        };
+    }
+
+    // Every result column is the parent columns weighted by one local column
+    void Multiply(const glm::mat4& parent, const glm::mat4& local, glm::mat4& result)
+    {
+#if JUL_TRANSFORM_SSE
+        const __m128 parentColumn0 = _mm_loadu_ps(&parent[0][0]);
+        const __m128 parentColumn1 = _mm_loadu_ps(&parent[1][0]);
+        const __m128 parentColumn2 = _mm_loadu_ps(&parent[2][0]);
+        const __m128 parentColumn3 = _mm_loadu_ps(&parent[3][0]);
+
+        for(int column = 0; column < 4; ++column)
+        {
+            const __m128 weighted0 = _mm_mul_ps(parentColumn0, _mm_set1_ps(local[column][0]));
+            const __m128 weighted1 = _mm_mul_ps(parentColumn1, _mm_set1_ps(local[column][1]));
+            const __m128 weighted2 = _mm_mul_ps(parentColumn2, _mm_set1_ps(local[column][2]));
+            const __m128 weighted3 = _mm_mul_ps(parentColumn3, _mm_set1_ps(local[column][3]));
+
+            _mm_storeu_ps(&result[column][0],
+                          _mm_add_ps(_mm_add_ps(weighted0, weighted1), _mm_add_ps(weighted2, weighted3)));
+        }
+#else
+        result = parent * local;
+#endif
+    }
+}  // namespace
+
+uint32_t TransformSystem::Add(uint32_t parentId, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+    const uint32_t id = GetCount();
+
+    if(parentId != NO_PARENT and parentId >= id)
+        throw std::runtime_error("Transform parent has to be added before its children!");
+
+    m_Positions.push_back(position);
+    m_Rotations.push_back(rotation);
+    m_Scales.push_back(scale);
+    m_Parents.push_back(parentId);
+
+    m_LocalMatrices.emplace_back(1.0f);
+    m_WorldMatrices.emplace_back(1.0f);
+
+    m_Dirty.push_back(1);
+    m_Updated.push_back(0);
+
+    m_FirstDirty = std::min(m_FirstDirty, id);
+    return id;
+}
+
+void TransformSystem::SetPosition(uint32_t id, const glm::vec3& position)
+{
+    m_Positions[id] = position;
+    MarkDirty(id);
+}
+
+void TransformSystem::SetRotation(uint32_t id, const glm::quat& rotation)
+{
+    m_Rotations[id] = rotation;
+    MarkDirty(id);
+}
+
+void TransformSystem::SetScale(uint32_t id, const glm::vec3& scale)
+{
+    m_Scales[id] = scale;
+    MarkDirty(id);
+}
+
+void TransformSystem::Update()
+{
+    JUL_PROFILE_ZONE("TransformSystem::Update");
+
+    for(const uint32_t id : m_UpdatedIds)
+        m_Updated[id] = 0;
+
+    m_UpdatedIds.clear();
+
+    const uint32_t count = GetCount();
+    if(m_FirstDirty >= count)
+        return;
+
+    // Parents are visited first, so an updated parent dirties its children before they are checked
+    for(uint32_t id = m_FirstDirty; id < count; ++id)
+    {
+        const uint32_t parentId = m_Parents[id];
+        if(parentId != NO_PARENT and m_Updated[parentId] != 0)
+            m_Dirty[id] = 1;
+
+        if(m_Dirty[id] == 0)
+            continue;
+
+        m_Dirty[id] = 0;
+        m_Updated[id] = 1;
+        m_UpdatedIds.push_back(id);
+    }
+
+    // Locals don't depend on each other, so they are built in one batch before walking the hierarchy
+    for(const uint32_t id : m_UpdatedIds)
+        m_LocalMatrices[id] = ComposeTrs(m_Positions[id], m_Rotations[id], m_Scales[id]);
+
+    for(const uint32_t id : m_UpdatedIds)
+    {
+        const uint32_t parentId = m_Parents[id];
+        if(parentId == NO_PARENT)
+            m_WorldMatrices[id] = m_LocalMatrices[id];
+        else
+            Multiply(m_WorldMatrices[parentId], m_LocalMatrices[id], m_WorldMatrices[id]);
+    }
+
+    m_FirstDirty = count;
+}
+
+void TransformSystem::MarkDirty(uint32_t id)
+{
+    m_Dirty[id] = 1;
+    m_FirstDirty = std::min(m_FirstDirty, id);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <limits>
+#include <vector>
+
+// Local position, rotation and scale of every transform, stored as one array per component
+// Parents always come before their children, so one forward pass sees a parent's new world matrix first
+class TransformSystem final
+{
+public:
+    inline static constexpr uint32_t NO_PARENT{ std::numeric_limits<uint32_t>::max() };
+
+    // The parent has to be added first, which keeps the arrays topologically sorted
+    uint32_t Add(uint32_t parentId = NO_PARENT,
+                 const glm::vec3& position = glm::vec3{ 0.0f },
+                 const glm::quat& rotation = glm::quat{ 1.0f, 0.0f, 0.0f, 0.0f },
+                 const glm::vec3& scale = glm::vec3{ 1.0f });
+
+    void SetPosition(uint32_t id, const glm::vec3& position);
+    void SetRotation(uint32_t id, const glm::quat& rotation);
+    void SetScale(uint32_t id, const glm::vec3& scale);
+
+    // Recomputes the world matrices of dirty transforms and everything below them
+    void Update();
+
+    [[nodiscard]] const glm::vec3& GetPosition(uint32_t id) const { return m_Positions[id]; }
+    [[nodiscard]] const glm::quat& GetRotation(uint32_t id) const { return m_Rotations[id]; }
+    [[nodiscard]] const glm::vec3& GetScale(uint32_t id) const { return m_Scales[id]; }
+    [[nodiscard]] uint32_t GetParent(uint32_t id) const { return m_Parents[id]; }
+
+    [[nodiscard]] const glm::mat4& GetWorldMatrix(uint32_t id) const { return m_WorldMatrices[id]; }
+    [[nodiscard]] const std::vector<glm::mat4>& GetWorldMatrices() const { return m_WorldMatrices; }
+
+    // True when the last Update changed the world matrix
+    [[nodiscard]] bool WasUpdated(uint32_t id) const { return m_Updated[id] != 0; }
+    [[nodiscard]] const std::vector<uint32_t>& GetUpdatedIds() const { return m_UpdatedIds; }
+
+    [[nodiscard]] uint32_t GetCount() const { return static_cast<uint32_t>(m_Parents.size()); }
+
+private:
+    void MarkDirty(uint32_t id);
+
+    std::vector<glm::vec3> m_Positions{};
+    std::vector<glm::quat> m_Rotations{};
+    std::vector<glm::vec3> m_Scales{};
+    std::vector<uint32_t> m_Parents{};
+
+    std::vector<glm::mat4> m_LocalMatrices{};
+    std::vector<glm::mat4> m_WorldMatrices{};
+
+    std::vector<uint8_t> m_Dirty{};
+    std::vector<uint8_t> m_Updated{};
+    std::vector<uint32_t> m_UpdatedIds{};
+
+    // Everything before this is clean, so Update starts here
+    uint32_t m_FirstDirty{};
+};
@@ -0,0 +1,59 @@
+#include "UploadBatch.h"
+
+#include <algorithm>
+
+#include "jul/CpuProfiler.h"
+#include "vulkanbase/VulkanGlobals.h"
+
+UploadBatch::UploadBatch() :
+    m_CommandBuffer(VulkanGlobals::GetDevice())
+{
+    m_CommandBuffer.BeginBuffer();
+}
+
+UploadBatch::Allocation UploadBatch::Allocate(VkDeviceSize size)
+{
+    m_ChunkOffset = (m_ChunkOffset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+    // Uploads bigger than a chunk get a buffer of their own
+    if(m_ChunkData == nullptr or m_ChunkOffset + size > m_ChunkSize)
+    {
+        m_ChunkSize = std::max(size, CHUNK_SIZE);
+        m_ChunkOffset = 0;
+
+        auto& stagingBuffer = m_StagingBuffers.emplace_back(std::make_unique<Buffer>(
+            m_ChunkSize,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+
+        stagingBuffer->Map(static_cast<uint32_t>(m_ChunkSize));
+        m_ChunkData = static_cast<std::byte*>(stagingBuffer->GetMappedData());
+    }
+
+    const Allocation allocation{
+        .buffer = *m_StagingBuffers.back(),
+        .offset = m_ChunkOffset,
+        .data = m_ChunkData + m_ChunkOffset,
+    };
+
+    m_ChunkOffset += size;
+    m_StagedSize += size;
+
+    return allocation;
+}
+
+void UploadBatch::Submit()
+{
+    JUL_PROFILE_ZONE("UploadBatch::Submit");
+
+    m_CommandBuffer.EndBuffer();
+
+    // The queue is idle after EndBuffer, so the staging memory can go
+    m_StagingBuffers.clear();
+    m_ChunkData = nullptr;
+    m_ChunkOffset = 0;
+    m_ChunkSize = 0;
+    m_StagedSize = 0;
+
+    m_CommandBuffer.BeginBuffer();
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "Buffer.h"
+#include "CommandBuffer.h"
+
+// Records transfers into one command buffer and keeps their staging memory alive until they are submitted
+//
+// Staging memory comes from a few large mapped buffers instead of one buffer per upload
+class UploadBatch final
+{
+public:
+    struct Allocation
+    {
+        VkBuffer buffer;
+        VkDeviceSize offset;
+        std::byte* data;
+    };
+
+    UploadBatch();
+    // Transfers that were never submitted are dropped
+    ~UploadBatch() = default;
+
+    UploadBatch(UploadBatch&&) = delete;
+    UploadBatch(const UploadBatch&) = delete;
+    UploadBatch& operator=(UploadBatch&&) = delete;
+    UploadBatch& operator=(const UploadBatch&) = delete;
+
+    // Offsets are aligned to 16 bytes, which covers every texel and block size, the memory stays valid until Submit
+    [[nodiscard]] Allocation Allocate(VkDeviceSize size);
+
+    [[nodiscard]] VkCommandBuffer GetCommandBuffer() const { return m_CommandBuffer; }
+    [[nodiscard]] VkDeviceSize GetStagedSize() const { return m_StagedSize; }
+
+    // One submit for everything recorded so far, waits for it and starts recording again
+    void Submit();
+
+private:
+    inline static constexpr VkDeviceSize CHUNK_SIZE{ 32 << 20 };
+    inline static constexpr VkDeviceSize ALIGNMENT{ 16 };
+
+    CommandBuffer m_CommandBuffer;
+    std::vector<std::unique_ptr<Buffer>> m_StagingBuffers{};
+    std::byte* m_ChunkData{};
+    VkDeviceSize m_ChunkOffset{};
+    VkDeviceSize m_ChunkSize{};
+    VkDeviceSize m_StagedSize{};
+};
@@ -2,6 +2,20 @@
 
 #define PI 3.1415926535897932384626433832795
 
+// Specialization constants, the ids match ShaderPermutation in PipelineStateCache.h
+layout(constant_id = 0) const bool HAS_NORMAL_MAP = true;
+layout(constant_id = 1) const bool HAS_ORM_MAP = true;
+layout(constant_id = 2) const uint DEBUG_VIEW = 0u;
+
+#define LIGHT_COUNT 2u
+
+#define DEBUG_VIEW_NONE 0u
+#define DEBUG_VIEW_BASE_COLOR 1u
+#define DEBUG_VIEW_NORMAL 2u
+#define DEBUG_VIEW_METALLIC 3u
+#define DEBUG_VIEW_ROUGHNESS 4u
+#define DEBUG_VIEW_OCCLUSION 5u
+
 
 //Tonemap used in uncharted 2
 vec3 ToneMap(vec3 color)
@@ -83,9 +97,13 @@ vec3 specularContribution(vec3 L, vec3 V, vec3 N, vec3 F0, float metallic, float
     return color;
 }
 
-vec3 calculateNormal(sampler2D normalMap, vec3 normal, vec3 tangent, vec2 uv)
+// Takes the raw sample so bindless shaders can sample their own texture
+// Z is rebuilt from X and Y, BC5 normal maps only store those two
+vec3 applyNormalMap(vec3 normalSample, vec3 normal, vec3 tangent)
 {
-    vec3 tangentNormal = texture(normalMap, uv).xyz * 2.0 - 1.0;
+    vec3 tangentNormal;
+    tangentNormal.xy = normalSample.xy * 2.0 - 1.0;
+    tangentNormal.z = sqrt(max(1.0 - dot(tangentNormal.xy, tangentNormal.xy), 0.0));
 
     vec3 N = normalize(normal);
     vec3 T = normalize(tangent.xyz);
@@ -93,3 +111,70 @@ vec3 calculateNormal(sampler2D normalMap, vec3 normal, vec3 tangent, vec2 uv)
     mat3 TBN = mat3(T, B, N);
     return normalize(TBN * tangentNormal);
 }
+
+vec3 calculateNormal(sampler2D normalMap, vec3 normal, vec3 tangent, vec2 uv)
+{
+    return applyNormalMap(texture(normalMap, uv).xyz, normal, tangent);
+}
+
+
+struct Light
+{
+    vec3 position;
+    vec3 color;
+};
+
+// Fixed scene lights plus a flat ambient term, occlusion only darkens the ambient part
+vec3 shadeScene(vec3 baseColor, vec3 N, vec3 V, float metallic, float roughness, float occlusion, vec3 worldPosition,
+                vec2 uv)
+{
+    vec3 F0 = vec3(0.04);
+    F0 = mix(F0, baseColor, metallic);
+
+
+    Light lights[LIGHT_COUNT];
+    lights[0].position = vec3(10.0, 0.0, 10.0);
+    lights[0].color = vec3(1.0, 1.0, 1.0);
+
+    lights[1].position = vec3(-100.0, 0.0, 0.0);
+    lights[1].color = vec3(1.0, 1.0, 0.0);
+
+    vec3 Lo = vec3(0.0);
+    for(uint i = 0; i < LIGHT_COUNT; i++)
+    {
+        vec3 L = normalize(lights[i].position - worldPosition);
+        Lo += specularContribution(L, V, N, F0, metallic, roughness, uv, baseColor);
+    }
+
+    vec2 brdf = (0.08 * vec2(max(dot(N, V), 0.0), roughness)).rg;
+    vec3 reflection = vec3(0.3);
+    // Diffuse based on irradiance
+    vec3 diffuse = 0.7 * baseColor;
+
+    vec3 F = F_SchlickR(max(dot(N, V), 0.0), F0, roughness);
+
+    // Specular reflectance
+    vec3 specular = reflection * (F * brdf.x + brdf.y);
+
+    // Ambient part
+    vec3 kD = 1.0 - F;
+    kD *= 1.0 - metallic;
+    vec3 ambient = (kD * diffuse + specular) * occlusion;
+
+    return ambient + Lo;
+}
+
+// Only called when DEBUG_VIEW is set, the lighting is skipped entirely
+vec3 debugView(vec3 baseColor, vec3 N, float metallic, float roughness, float occlusion)
+{
+    switch(DEBUG_VIEW)
+    {
+        case DEBUG_VIEW_BASE_COLOR: return baseColor;
+        case DEBUG_VIEW_NORMAL: return N * 0.5 + 0.5;
+        case DEBUG_VIEW_METALLIC: return vec3(metallic);
+        case DEBUG_VIEW_ROUGHNESS: return vec3(roughness);
+        case DEBUG_VIEW_OCCLUSION: return vec3(occlusion);
+    }
+
+    return vec3(1.0, 0.0, 1.0);
+}
@@ -6,10 +6,17 @@ layout(set = 0, binding = 0) uniform UniformBufferObject
     vec4 viewPosition;
 } ubo;
 
-layout(push_constant) uniform constants
+struct InstanceData
 {
     mat4 model;
-} push;
+    vec4 tint;
+    uint materialIndex;
+};
+
+layout(std430, set = 0, binding = 1) readonly buffer InstanceBuffer
+{
+    InstanceData instances[];
+};
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inNormal;
@@ -20,12 +27,20 @@ layout(location = 0) out vec3 outWorldPosition;
 layout(location = 1) out vec3 outNormal;
 layout(location = 2) out vec3 outTangent;
 layout(location = 3) out vec2 outUV;
+layout(location = 4) out vec4 outTint;
+layout(location = 5) flat out uint outMaterialIndex;
 
 void main()
 {
-    outWorldPosition = vec3(push.model * vec4(inPosition, 1.0));
-    outNormal = mat3(push.model) * inNormal;
-    outTangent = mat3(push.model) * inTangent;
+    // gl_InstanceIndex includes the firstInstance of the draw
+    const InstanceData instance = instances[gl_InstanceIndex];
+    const mat4 model = instance.model;
+
+    outWorldPosition = vec3(model * vec4(inPosition, 1.0));
+    outNormal = mat3(model) * inNormal;
+    outTangent = mat3(model) * inTangent;
     outUV = inUV;
+    outTint = instance.tint;
+    outMaterialIndex = instance.materialIndex;
     gl_Position =  ubo.viewProjection * vec4(outWorldPosition, 1.0);
 }
@@ -0,0 +1,77 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+#include "PBR.glsl"
+
+layout(set = 0, binding = 0) uniform UniformBufferObject
+{
+    mat4 viewProjection;
+    vec4 viewPosition;
+} ubo;
+
+// Matches Material::MaterialData
+struct MaterialData
+{
+    uint colorTexture;
+    uint normalTexture;
+    uint ormTexture;
+    uint texturePadding;
+    vec4 colorFactor;
+    float metallicFactor;
+    float roughnessFactor;
+};
+
+// Every texture of every material, only the slots that are in use are written
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+
+layout(std430, set = 1, binding = 1) readonly buffer MaterialTable
+{
+    MaterialData materials[];
+};
+
+
+layout(location = 0) in vec3 inWorldPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec3 inTangent;
+layout(location = 3) in vec2 inUV;
+layout(location = 4) in vec4 inTint;
+layout(location = 5) flat in uint inMaterialIndex;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+    // One multi draw mixes materials, so the index is not uniform across the draw
+    const MaterialData material = materials[inMaterialIndex];
+
+    // Every material in the draw shares the permutation, so the branches are uniform
+    vec3 N = normalize(inNormal);
+    if(HAS_NORMAL_MAP)
+    {
+        vec3 normalSample = texture(textures[nonuniformEXT(material.normalTexture)], inUV).xyz;
+        N = applyNormalMap(normalSample, inNormal, inTangent);
+    }
+
+    float occlusion = 1.0;
+    float metallic = 0.0;
+    float roughness = material.roughnessFactor;
+    if(HAS_ORM_MAP)
+    {
+        // Occlusion, roughness and metallic come from one packed sample
+        vec3 orm = texture(textures[nonuniformEXT(material.ormTexture)], inUV).rgb;
+        occlusion = orm.r;
+        roughness = orm.g * material.roughnessFactor;
+        metallic = orm.b * material.metallicFactor;
+    }
+
+    vec3 baseColor = texture(textures[nonuniformEXT(material.colorTexture)], inUV).rgb * material.colorFactor.rgb *
+                     inTint.rgb;
+
+    if(DEBUG_VIEW != DEBUG_VIEW_NONE)
+    {
+        outColor = vec4(debugView(baseColor, N, metallic, roughness, occlusion), 1.0);
+        return;
+    }
+
+    vec3 V = normalize(ubo.viewPosition.xyz - inWorldPosition);
+    outColor = vec4(shadeScene(baseColor, N, V, metallic, roughness, occlusion, inWorldPosition, inUV), 1.0);
+}
@@ -0,0 +1,189 @@
+// Round trips blocks through the BC encoders and checks the decoded texels stay close to the originals
+//
+// Only needs the CPU, registered with ctest so build machines run it
+// Usage: BlockCompressionTest
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "jul/BlockCompression.h"
+
+namespace
+{
+    using Block = std::array<uint8_t, 16 * 4>;
+
+    int g_FailureCount{};
+
+    void Check(bool condition, std::string_view description)
+    {
+        if(condition)
+            return;
+
+        std::cerr << "FAILED: " << description << '\n';
+        ++g_FailureCount;
+    }
+
+    std::array<int, 3> UnpackRgb565(uint16_t color)
+    {
+        const int red = color >> 11 & 31;
+        const int green = color >> 5 & 63;
+        const int blue = color & 31;
+        return { red << 3 | red >> 2, green << 2 | green >> 4, blue << 3 | blue >> 2 };
+    }
+
+    // Alpha is left at full, BC1 is only used without it
+    Block DecodeBC1(const uint8_t* block)
+    {
+        const auto color0 = static_cast<uint16_t>(block[0] | block[1] << 8);
+        const auto color1 = static_cast<uint16_t>(block[2] | block[3] << 8);
+        const std::array<int, 3> endpoint0 = UnpackRgb565(color0);
+        const std::array<int, 3> endpoint1 = UnpackRgb565(color1);
+
+        std::array<std::array<int, 3>, 4> palette{ endpoint0, endpoint1 };
+        for(int channel = 0; channel < 3; ++channel)
+        {
+            if(color0 > color1)
+            {
+                palette[2][channel] = (2 * endpoint0[channel] + endpoint1[channel]) / 3;
+                palette[3][channel] = (endpoint0[channel] + 2 * endpoint1[channel]) / 3;
+            }
+            else
+            {
+                palette[2][channel] = (endpoint0[channel] + endpoint1[channel]) / 2;
+            }
+        }
+
+        const uint32_t indices = block[4] | block[5] << 8 | block[6] << 16 | static_cast<uint32_t>(block[7]) << 24;
+
+        Block texels{};
+        for(uint32_t texelIndex = 0; texelIndex < 16; ++texelIndex)
+        {
+            const std::array<int, 3>& color = palette[indices >> texelIndex * 2 & 3];
+            for(uint32_t channel = 0; channel < 3; ++channel)
+                texels[texelIndex * 4 + channel] = static_cast<uint8_t>(color[channel]);
+
+            texels[texelIndex * 4 + 3] = 255;
+        }
+
+        return texels;
+    }
+
+    // Only mode 6, the one the encoder writes
+    Block DecodeBC7(const uint8_t* block)
+    {
+        uint32_t position{};
+        auto read = [&](uint32_t bitCount)
+        {
+            uint32_t value{};
+            for(uint32_t bit = 0; bit < bitCount; ++bit, ++position)
+                value |= static_cast<uint32_t>(block[position / 8] >> position % 8 & 1) << bit;
+            return value;
+        };
+
+        Check(read(7) == 1 << 6, "BC7 block is mode 6");
+
+        std::array<std::array<uint32_t, 4>, 2> endpoints{};
+        for(uint32_t channel = 0; channel < 4; ++channel)
+        {
+            endpoints[0][channel] = read(7);
+            endpoints[1][channel] = read(7);
+        }
+
+        for(std::array<uint32_t, 4>& endpoint : endpoints)
+        {
+            const uint32_t pBit = read(1);
+            for(uint32_t& value : endpoint)
+                value = value << 1 | pBit;
+        }
+
+        constexpr std::array<uint32_t, 16> weights{ 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        Block texels{};
+        for(uint32_t texelIndex = 0; texelIndex < 16; ++texelIndex)
+        {
+            const uint32_t weight = weights[read(texelIndex == 0 ? 3 : 4)];
+            for(uint32_t channel = 0; channel < 4; ++channel)
+                texels[texelIndex * 4 + channel] = static_cast<uint8_t>(
+                    ((64 - weight) * endpoints[0][channel] + weight * endpoints[1][channel] + 32) >> 6);
+        }
+
+        return texels;
+    }
+
+    int GetMaxError(const Block& first, const Block& second, uint32_t channelCount)
+    {
+        int maxError{};
+        for(uint32_t texelIndex = 0; texelIndex < 16; ++texelIndex)
+        {
+            for(uint32_t channel = 0; channel < channelCount; ++channel)
+            {
+                const int error = std::abs(first[texelIndex * 4 + channel] - second[texelIndex * 4 + channel]);
+                maxError = std::max(maxError, error);
+            }
+        }
+
+        return maxError;
+    }
+
+    // BC1 only has four colors per block against the sixteen of BC7, so blends need a looser bound
+    void TestRoundTrip(std::string_view name, const Block& texels, int maxBc1Error, int maxBc7Error)
+    {
+        std::array<uint8_t, 16> block{};
+
+        blockCompression::EncodeBC1(texels.data(), block.data());
+        const int bc1Error = GetMaxError(texels, DecodeBC1(block.data()), 3);
+        Check(bc1Error <= maxBc1Error, std::string{ name } + " survives BC1, max error " + std::to_string(bc1Error));
+
+        blockCompression::EncodeBC7(texels.data(), block.data());
+        const int bc7Error = GetMaxError(texels, DecodeBC7(block.data()), 4);
+        Check(bc7Error <= maxBc7Error, std::string{ name } + " survives BC7, max error " + std::to_string(bc7Error));
+    }
+
+    // Texels alternate between the two colors in a checkerboard
+    Block CreateCheckerboard(const std::array<uint8_t, 4>& first, const std::array<uint8_t, 4>& second)
+    {
+        Block texels{};
+        for(uint32_t texelIndex = 0; texelIndex < 16; ++texelIndex)
+        {
+            const bool isFirst = (texelIndex % 4 + texelIndex / 4) % 2 == 0;
+            std::copy_n((isFirst ? first : second).data(), 4, texels.data() + texelIndex * 4);
+        }
+
+        return texels;
+    }
+}
+
+int main()
+{
+    TestRoundTrip("flat block", CreateCheckerboard({ 90, 140, 200, 255 }, { 90, 140, 200, 255 }), 4, 1);
+
+    // Same brightness on the grey axis, only the hue differs
+    TestRoundTrip("red and green block", CreateCheckerboard({ 255, 0, 0, 255 }, { 0, 255, 0, 255 }), 4, 1);
+    TestRoundTrip("red and blue block", CreateCheckerboard({ 255, 0, 0, 255 }, { 0, 0, 255, 255 }), 4, 1);
+    TestRoundTrip("black and white block", CreateCheckerboard({ 0, 0, 0, 255 }, { 255, 255, 255, 255 }), 4, 1);
+
+    Block gradient{};
+    for(uint32_t texelIndex = 0; texelIndex < 16; ++texelIndex)
+    {
+        const auto value = static_cast<uint8_t>(texelIndex * 17);
+        gradient[texelIndex * 4 + 0] = value;
+        gradient[texelIndex * 4 + 1] = static_cast<uint8_t>(255 - value);
+        gradient[texelIndex * 4 + 2] = 128;
+        gradient[texelIndex * 4 + 3] = 255;
+    }
+    TestRoundTrip("gradient block", gradient, 48, 8);
+
+    if(g_FailureCount > 0)
+    {
+        std::cerr << g_FailureCount << " checks failed\n";
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "All checks passed\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,184 @@
+// Checks the occlusion rasterizer against a scene with known visibility and times it with and without threads
+//
+// Only needs the CPU, registered with ctest so build machines run it
+// Usage: OcclusionRasterizerTest
+
+#include <chrono>
+#include <cstdlib>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <random>
+#include <string_view>
+
+#include "jul/Bounds.h"
+#include "jul/OcclusionRasterizer.h"
+#include "jul/ThreadPool.h"
+
+namespace
+{
+    constexpr uint32_t WIDTH{ 256 };
+    constexpr uint32_t HEIGHT{ 128 };
+
+    constexpr uint32_t BENCHMARK_WIDTH{ 512 };
+    constexpr uint32_t BENCHMARK_HEIGHT{ 256 };
+    constexpr uint32_t BENCHMARK_OCCLUDER_COUNT{ 2000 };
+    constexpr uint32_t BENCHMARK_ITERATIONS{ 20 };
+
+    int g_FailureCount{};
+
+    void Check(bool condition, std::string_view description)
+    {
+        if(condition)
+            return;
+
+        std::cerr << "FAILED: " << description << '\n';
+        ++g_FailureCount;
+    }
+
+    // Camera at the origin looking down -z
+    glm::mat4 GetViewProjection(uint32_t width, uint32_t height)
+    {
+        const glm::mat4 projection = glm::perspective(
+            glm::radians(90.0f), static_cast<float>(width) / static_cast<float>(height), 0.1f, 100.0f);
+
+        const glm::mat4 view =
+            glm::lookAt(glm::vec3{ 0.0f }, glm::vec3{ 0.0f, 0.0f, -1.0f }, glm::vec3{ 0.0f, 1.0f, 0.0f });
+
+        return projection * view;
+    }
+
+    // Unit square in the xy plane facing +z
+    OcclusionRasterizer::OccluderMesh CreateQuad()
+    {
+        return {
+            .positions = { { -0.5f, -0.5f, 0.0f }, { 0.5f, -0.5f, 0.0f }, { 0.5f, 0.5f, 0.0f }, { -0.5f, 0.5f, 0.0f } },
+            .indices = { 0, 1, 2, 0, 2, 3 },
+        };
+    }
+
+    OcclusionRasterizer::OccluderMesh CreateCube()
+    {
+        OcclusionRasterizer::OccluderMesh cube{};
+        for(int corner = 0; corner < 8; ++corner)
+        {
+            cube.positions.emplace_back(corner & 1 ? 0.5f : -0.5f,
+                                        corner & 2 ? 0.5f : -0.5f,
+                                        corner & 4 ? 0.5f : -0.5f);
+        }
+
+        cube.indices = { 0, 2, 3, 0, 3, 1, 4, 5, 7, 4, 7, 6, 0, 4, 6, 0, 6, 2,
+                         1, 3, 7, 1, 7, 5, 0, 1, 5, 0, 5, 4, 2, 6, 7, 2, 7, 3 };
+        return cube;
+    }
+
+    Bounds Box(const glm::vec3& center, float extent)
+    {
+        return { .center = center, .extents = glm::vec3{ extent }, .radius = extent * 1.7320508f };
+    }
+
+    void TestVisibility(ThreadPool* threadPoolPtr)
+    {
+        OcclusionRasterizer rasterizer{ WIDTH, HEIGHT, threadPoolPtr };
+        const uint32_t quadId = rasterizer.AddOccluderMesh(CreateQuad());
+
+        // Nothing rasterized, nothing is hidden
+        rasterizer.Clear(GetViewProjection(WIDTH, HEIGHT));
+        rasterizer.Rasterize();
+        Check(rasterizer.IsVisible(Box({ 0.0f, 0.0f, -10.0f }, 0.5f)), "box is visible without occluders");
+
+        // A 4 by 4 wall 5 units in front of the camera
+        rasterizer.Clear(GetViewProjection(WIDTH, HEIGHT));
+        rasterizer.AddOccluder(quadId, glm::scale(glm::translate(glm::mat4{ 1.0f }, glm::vec3{ 0.0f, 0.0f, -5.0f }),
+                                                  glm::vec3{ 4.0f, 4.0f, 1.0f }));
+        rasterizer.Rasterize();
+
+        Check(rasterizer.GetTriangleCount() == 2, "both wall triangles are set up");
+        Check(rasterizer.GetDepth(WIDTH / 2, HEIGHT / 2) < OcclusionRasterizer::CLEAR_DEPTH, "wall covers the center");
+        Check(rasterizer.GetDepth(0, 0) == OcclusionRasterizer::CLEAR_DEPTH, "wall leaves the corner empty");
+
+        Check(not rasterizer.IsVisible(Box({ 0.0f, 0.0f, -10.0f }, 0.5f)), "box behind the wall is hidden");
+        Check(not rasterizer.IsVisible(Box({ 1.0f, -1.0f, -20.0f }, 1.0f)), "far box behind the wall is hidden");
+        Check(rasterizer.IsVisible(Box({ 0.0f, 0.0f, -3.0f }, 0.5f)), "box in front of the wall is visible");
+        Check(rasterizer.IsVisible(Box({ 8.0f, 0.0f, -10.0f }, 0.5f)), "box beside the wall is visible");
+        Check(rasterizer.IsVisible(Box({ 4.0f, 0.0f, -10.0f }, 0.5f)), "box sticking out behind the edge is visible");
+        Check(rasterizer.IsVisible(Box({ 0.0f, 0.0f, -5.0f }, 1.0f)), "box through the wall is visible");
+        Check(rasterizer.IsVisible(Box({ 0.0f, 0.0f, 0.5f }, 1.0f)), "box around the camera is visible");
+        Check(rasterizer.IsVisible(Bounds::Infinite()), "infinite bounds are visible");
+    }
+
+    void AddRandomOccluders(OcclusionRasterizer& rasterizer, uint32_t cubeId)
+    {
+        // Same seed every run so serial and threaded rasterize the same scene
+        std::mt19937 random{ 1234 };
+        std::uniform_real_distribution<float> sideDistribution{ -30.0f, 30.0f };
+        std::uniform_real_distribution<float> depthDistribution{ -60.0f, -2.0f };
+        std::uniform_real_distribution<float> sizeDistribution{ 0.5f, 4.0f };
+
+        for(uint32_t occluderIndex = 0; occluderIndex < BENCHMARK_OCCLUDER_COUNT; ++occluderIndex)
+        {
+            const glm::vec3 position{ sideDistribution(random), sideDistribution(random) * 0.5f,
+                                      depthDistribution(random) };
+
+            rasterizer.AddOccluder(cubeId, glm::scale(glm::translate(glm::mat4{ 1.0f }, position),
+                                                      glm::vec3{ sizeDistribution(random) }));
+        }
+    }
+
+    // Average milliseconds per frame of clearing, adding occluders and rasterizing
+    double Benchmark(OcclusionRasterizer& rasterizer)
+    {
+        const uint32_t cubeId = rasterizer.AddOccluderMesh(CreateCube());
+        const glm::mat4 viewProjection = GetViewProjection(rasterizer.GetWidth(), rasterizer.GetHeight());
+
+        const auto start = std::chrono::steady_clock::now();
+        for(uint32_t iteration = 0; iteration < BENCHMARK_ITERATIONS; ++iteration)
+        {
+            rasterizer.Clear(viewProjection);
+            AddRandomOccluders(rasterizer, cubeId);
+            rasterizer.Rasterize();
+        }
+
+        const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+        return duration.count() / BENCHMARK_ITERATIONS;
+    }
+
+    void BenchmarkThreading(ThreadPool& threadPool)
+    {
+        OcclusionRasterizer serialRasterizer{ BENCHMARK_WIDTH, BENCHMARK_HEIGHT };
+        OcclusionRasterizer threadedRasterizer{ BENCHMARK_WIDTH, BENCHMARK_HEIGHT, &threadPool };
+
+        const double serialMilliseconds = Benchmark(serialRasterizer);
+        const double threadedMilliseconds = Benchmark(threadedRasterizer);
+
+        bool depthMatches{ true };
+        for(uint32_t y = 0; y < BENCHMARK_HEIGHT; ++y)
+            for(uint32_t x = 0; x < BENCHMARK_WIDTH; ++x)
+                depthMatches = depthMatches and serialRasterizer.GetDepth(x, y) == threadedRasterizer.GetDepth(x, y);
+
+        Check(depthMatches, "threaded depth matches serial depth");
+
+        std::cout << BENCHMARK_OCCLUDER_COUNT << " cubes at " << BENCHMARK_WIDTH << "x" << BENCHMARK_HEIGHT << ", "
+                  << serialRasterizer.GetTriangleCount() << " triangles set up\n"
+                  << "  serial:   " << serialMilliseconds << " ms\n"
+                  << "  threaded: " << threadedMilliseconds << " ms with " << threadPool.GetThreadCount()
+                  << " workers\n";
+    }
+}
+
+int main()
+{
+    ThreadPool threadPool{};
+
+    TestVisibility(nullptr);
+    TestVisibility(&threadPool);
+    BenchmarkThreading(threadPool);
+
+    if(g_FailureCount > 0)
+    {
+        std::cerr << g_FailureCount << " checks failed\n";
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "All checks passed\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,137 @@
+// Offline texture compressor, writes a KTX2 file with a full mip chain of BC blocks next to every input image
+//
+// Only needs the CPU, so it runs on build machines without a GPU
+// Usage: TextureCompressor <color|color-bc1|normal|mask> <image>...
+// The CompressTextures target runs it over the color and normal maps in resources
+
+#include <external/stb/stb_image.h>
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "jul/BlockCompression.h"
+#include "jul/Ktx2File.h"
+#include "jul/MipChain.h"
+#include "jul/ThreadPool.h"
+
+namespace
+{
+    struct Usage
+    {
+        std::string_view name;
+        blockCompression::Format blockFormat;
+        VkFormat format;
+        // Color is filtered in linear space, data textures as they are
+        bool srgb;
+    };
+
+    // Albedo keeps BC7 quality, normals keep two full channels and the shader rebuilds z, masks only need red
+    constexpr Usage USAGES[]{
+        { "color", blockCompression::Format::BC7, VK_FORMAT_BC7_SRGB_BLOCK, true },
+        { "color-bc1", blockCompression::Format::BC1, VK_FORMAT_BC1_RGB_SRGB_BLOCK, true },
+        { "normal", blockCompression::Format::BC5, VK_FORMAT_BC5_UNORM_BLOCK, false },
+        { "mask", blockCompression::Format::BC4, VK_FORMAT_BC4_UNORM_BLOCK, false },
+    };
+
+    void Compress(const Usage& usage, const std::filesystem::path& inputPath, ThreadPool& threadPool)
+    {
+        using namespace std::string_literals;
+        const auto start = std::chrono::steady_clock::now();
+
+        int width{};
+        int height{};
+        int channelCount{};
+        stbi_uc* pixelsPtr = stbi_load(inputPath.string().c_str(), &width, &height, &channelCount, STBI_rgb_alpha);
+        if(pixelsPtr == nullptr)
+            throw std::runtime_error("Failed to load " + inputPath.string() + ": "s + stbi_failure_reason());
+
+        // Stored next to the blocks so placeholder textures are still recognised after compression
+        const size_t byteCount = static_cast<size_t>(width) * height * 4;
+        std::optional<std::array<uint8_t, 4>> uniformTexel{ std::array{
+            pixelsPtr[0], pixelsPtr[1], pixelsPtr[2], pixelsPtr[3] } };
+        for(size_t byteIndex = 4; byteIndex < byteCount and uniformTexel.has_value(); ++byteIndex)
+            if(pixelsPtr[byteIndex] != (*uniformTexel)[byteIndex % 4])
+                uniformTexel.reset();
+
+        const MipChain mipChain{ pixelsPtr, static_cast<uint32_t>(width), static_cast<uint32_t>(height), 4, usage.srgb };
+        stbi_image_free(pixelsPtr);
+
+        std::vector<std::vector<uint8_t>> levels{};
+        size_t compressedSize{};
+        for(const MipChain::Level& level : mipChain.GetLevels())
+        {
+            levels.push_back(blockCompression::EncodeImage(usage.blockFormat,
+                                                           mipChain.GetData().data() + level.offset,
+                                                           level.width,
+                                                           level.height,
+                                                           &threadPool));
+            compressedSize += levels.back().size();
+        }
+
+        const std::filesystem::path outputPath = std::filesystem::path{ inputPath }.replace_extension(".ktx2");
+        Ktx2File::Write(
+            outputPath, usage.format, static_cast<uint32_t>(width), static_cast<uint32_t>(height), levels, uniformTexel);
+
+        const auto duration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+        std::cout << inputPath.string() << " -> " << outputPath.string() << " (" << usage.name << ", "
+                  << levels.size() << " levels, " << mipChain.GetData().size() / 1024 << " KB -> "
+                  << compressedSize / 1024 << " KB) in " << duration.count() << " ms\n";
+    }
+}  // namespace
+
+int main(int argumentCount, char* arguments[])
+{
+    if(argumentCount < 3)
+    {
+        std::cerr << "Usage: TextureCompressor <color|color-bc1|normal|mask> <image>...\n";
+        return EXIT_FAILURE;
+    }
+
+    const std::string_view usageName{ arguments[1] };
+    const Usage* usagePtr{};
+    for(const Usage& usage : USAGES)
+    {
+        if(usage.name == usageName)
+            usagePtr = &usage;
+    }
+
+    if(usagePtr == nullptr)
+    {
+        std::cerr << "Unknown usage " << usageName << ", expected color, color-bc1, normal or mask\n";
+        return EXIT_FAILURE;
+    }
+
+    // Blocks of a level are spread over every core, images are compressed one after the other
+    ThreadPool threadPool{};
+
+    // A broken image doesn't stop the rest, every failure is listed at the end
+    std::vector<std::string> failures{};
+    for(int argumentIndex = 2; argumentIndex < argumentCount; ++argumentIndex)
+    {
+        try
+        {
+            Compress(*usagePtr, arguments[argumentIndex], threadPool);
+        }
+        catch(const std::exception& exception)
+        {
+            failures.push_back(std::string{ arguments[argumentIndex] } + ": " + exception.what());
+        }
+    }
+
+    if(failures.empty())
+        return EXIT_SUCCESS;
+
+    std::cerr << failures.size() << " of " << argumentCount - 2 << " images failed:\n";
+    for(const std::string& failure : failures)
+        std::cerr << "  " << failure << '\n';
+
+    return EXIT_FAILURE;
+}
@@ -1,12 +1,18 @@
 #include "vulkanbase/VulkanBase.h"
 
 #include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
 #include <map>
 #include <set>
 
+#include "jul/CpuProfiler.h"
 #include "jul/GameTime.h"
+#include "jul/GpuProfiler.h"
 #include "jul/Input.h"
 #include "jul/Material.h"
+#include "jul/PipelineCache.h"
 #include "vulkanbase/VulkanGlobals.h"
 #include "vulkanbase/VulkanUtil.h"
 
@@ -32,25 +38,44 @@ void VulkanBase::InitVulkan()
     m_SwapChainUPtr = std::make_unique<SwapChain>(m_Surface, windowSize);
     VulkanGlobals::s_SwapChainPtr = m_SwapChainUPtr.get();
 
-    m_RenderPassUPtr = std::make_unique<RenderPass>(m_Device, m_SwapChainUPtr->GetImageFormat());
+    m_RenderPassUPtr = std::make_unique<RenderPass>(m_Device, m_SwapChainUPtr->GetImageFormat(), true, false);
     VulkanGlobals::s_RenderPassPtr = m_RenderPassUPtr.get();
 
+    // Compatible with the first pass, so it uses the same framebuffers
+    m_LateRenderPassUPtr = std::make_unique<RenderPass>(m_Device, m_SwapChainUPtr->GetImageFormat(), false, true);
+
     vulkanUtil::QueueFamilyIndices indices = vulkanUtil::FindQueueFamilies(m_PhysicalDevice);
     m_CommandBufferUPtr = std::make_unique<CommandBuffer>(m_Device, indices.graphicsFamily.value());
 
-    CreateDepthResources();
+    m_SwapChainUPtr->CreateFrameBuffers(m_RenderPassUPtr.get());
 
-    m_SwapChainUPtr->CreateFrameBuffers(m_RenderPassUPtr.get(), m_DepthImageView);
-    Material::CreateMaterialPool(4, 4);
+    m_DescriptorAllocatorUPtr = std::make_unique<DescriptorAllocator>(m_Device);
+    VulkanGlobals::s_DescriptorAllocatorPtr = m_DescriptorAllocatorUPtr.get();
+
+    PipelineCache::Init("pipeline_cache.bin");
+    m_PipelineStateCacheUPtr = std::make_unique<PipelineStateCache>(m_Device);
+    VulkanGlobals::s_PipelineStateCachePtr = m_PipelineStateCacheUPtr.get();
+
+    Material::Init();
+    GpuProfiler::Init(indices.graphicsFamily.value());
     CreateSyncObjects();
 }
 
 void VulkanBase::MainLoop()
 {
+    CpuProfiler::SetThreadName("Main");
+
+    const auto gameStart = std::chrono::steady_clock::now();
     m_GameUPtr = std::make_unique<Game>();
+    const double gameMs =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - gameStart).count();
 
+    std::cout << "Game created in " << gameMs << " ms" << std::endl;
+
+    bool isFirstFrame{ true };
     while(not glfwWindowShouldClose(m_window))
     {
+        CpuProfiler::BeginFrame();
         jul::GameTime::Update();
 
         Input::Update();
@@ -59,6 +84,22 @@ void VulkanBase::MainLoop()
         m_GameUPtr->Update();
         DrawFrame();
 
+        // Pipelines can still be building on the thread pool after the game is created, the first frame waits on them
+        if(isFirstFrame)
+        {
+            isFirstFrame = false;
+
+            const double firstFrameMs =
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - gameStart).count();
+
+            // Compare runs with and without pipeline_cache.bin to see what the cache saves
+            const PipelineCache::CreationStats pipelineStats = PipelineCache::GetCreationStats();
+            std::cout << "First frame after " << firstFrameMs << " ms, " << pipelineStats.pipelineCount
+                      << " pipelines took " << pipelineStats.totalMs << " ms with a "
+                      << (PipelineCache::IsWarm() ? "warm" : "cold") << " pipeline cache ("
+                      << PipelineCache::GetLoadedSize() << " bytes loaded)" << std::endl;
+        }
+
         jul::GameTime::AddToFrameCount();
     }
     vkDeviceWaitIdle(m_Device);
@@ -71,17 +112,18 @@ void VulkanBase::Cleanup()
     vkDestroyFence(m_Device, m_InFlightFence, nullptr);
 
     Material::Cleanup();
+    GpuProfiler::Cleanup();
 
     m_CommandBufferUPtr.reset();
     m_GameUPtr.reset();
+    m_PipelineStateCacheUPtr.reset();
+    m_DescriptorAllocatorUPtr.reset();
+    PipelineCache::Cleanup();
+    m_LateRenderPassUPtr.reset();
     m_RenderPassUPtr.reset();
+    m_RetiredSwapChains.clear();
     m_SwapChainUPtr.reset();
 
-    vkDestroyImageView(VulkanGlobals::GetDevice(), m_DepthImageView, nullptr);
-    vkDestroyImage(VulkanGlobals::GetDevice(), m_DepthImage, nullptr);
-    vkFreeMemory(VulkanGlobals::GetDevice(), m_DepthImageMemory, nullptr);
-
-
     vkDestroyDevice(m_Device, nullptr);
 
     if(enableValidationLayers)
@@ -211,11 +253,114 @@ void VulkanBase::CreateLogicalDevice()
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
-        const VkPhysicalDeviceFeatures deviceFeatures{ .samplerAnisotropy = VK_TRUE };
+        VkPhysicalDeviceFeatures supportedFeatures{};
+        vkGetPhysicalDeviceFeatures(m_PhysicalDevice, &supportedFeatures);
+
+        const VkPhysicalDeviceFeatures deviceFeatures{
+            .multiDrawIndirect = supportedFeatures.multiDrawIndirect,
+            .drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance,
+            .samplerAnisotropy = VK_TRUE,
+            .textureCompressionBC = supportedFeatures.textureCompressionBC,
+        };
         createInfo.pEnabledFeatures = &deviceFeatures;
+        VulkanGlobals::s_EnabledFeatures = deviceFeatures;
+
+        uint32_t extensionCount{};
+        vkEnumerateDeviceExtensionProperties(m_PhysicalDevice, nullptr, &extensionCount, nullptr);
 
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(DEVICE_EXTENSIONS.size());
-        createInfo.ppEnabledExtensionNames = DEVICE_EXTENSIONS.data();
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(
+            m_PhysicalDevice, nullptr, &extensionCount, availableExtensions.data());
+
+        std::vector<const char*> enabledExtensions(DEVICE_EXTENSIONS.begin(), DEVICE_EXTENSIONS.end());
+        for(const char* optionalExtension : OPTIONAL_DEVICE_EXTENSIONS)
+        {
+            if(std::ranges::any_of(availableExtensions,
+                                   [optionalExtension](const VkExtensionProperties& extension)
+                                   { return std::strcmp(extension.extensionName, optionalExtension) == 0; }))
+                enabledExtensions.push_back(optionalExtension);
+        }
+
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+        createInfo.ppEnabledExtensionNames = enabledExtensions.data();
+
+        auto isEnabled = [&enabledExtensions](const char* extensionName)
+        {
+            return std::ranges::any_of(enabledExtensions,
+                                       [extensionName](const char* extension)
+                                       { return std::strcmp(extension, extensionName) == 0; });
+        };
+
+        // Bindless materials need the extension and these features, the features are queried through features2
+        VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT
+        };
+
+        const auto getPhysicalDeviceFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(
+            vkGetInstanceProcAddr(m_Instance, "vkGetPhysicalDeviceFeatures2KHR"));
+
+        if(getPhysicalDeviceFeatures2 != nullptr and isEnabled(VK_KHR_MAINTENANCE3_EXTENSION_NAME) and
+           isEnabled(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME))
+        {
+            VkPhysicalDeviceDescriptorIndexingFeaturesEXT supportedIndexingFeatures{
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT
+            };
+            VkPhysicalDeviceFeatures2KHR supportedFeatures2{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR,
+                                                             .pNext = &supportedIndexingFeatures };
+            getPhysicalDeviceFeatures2(m_PhysicalDevice, &supportedFeatures2);
+
+            if(supportedIndexingFeatures.runtimeDescriptorArray and
+               supportedIndexingFeatures.shaderSampledImageArrayNonUniformIndexing and
+               supportedIndexingFeatures.descriptorBindingPartiallyBound and
+               supportedIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind)
+            {
+                descriptorIndexingFeatures.runtimeDescriptorArray = VK_TRUE;
+                descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+                descriptorIndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+                descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+
+                createInfo.pNext = &descriptorIndexingFeatures;
+                VulkanGlobals::s_DescriptorIndexing = true;
+            }
+        }
+
+        // Cull mode, front face, topology and depth state become command buffer state, pipelines bake them otherwise
+        VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicStateFeatures{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT
+        };
+        VkPhysicalDeviceExtendedDynamicState2FeaturesEXT extendedDynamicState2Features{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT
+        };
+
+        if(getPhysicalDeviceFeatures2 != nullptr and isEnabled(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME))
+        {
+            VkPhysicalDeviceExtendedDynamicState2FeaturesEXT supportedDynamicState2Features{
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT
+            };
+            VkPhysicalDeviceExtendedDynamicStateFeaturesEXT supportedDynamicStateFeatures{
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT,
+                .pNext = isEnabled(VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME) ? &supportedDynamicState2Features
+                                                                                   : nullptr
+            };
+            VkPhysicalDeviceFeatures2KHR supportedFeatures2{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR,
+                                                             .pNext = &supportedDynamicStateFeatures };
+            getPhysicalDeviceFeatures2(m_PhysicalDevice, &supportedFeatures2);
+
+            if(supportedDynamicStateFeatures.extendedDynamicState)
+            {
+                extendedDynamicStateFeatures.extendedDynamicState = VK_TRUE;
+                extendedDynamicStateFeatures.pNext = const_cast<void*>(createInfo.pNext);
+                createInfo.pNext = &extendedDynamicStateFeatures;
+
+                // Primitive restart is only made dynamic on top of the other state
+                if(supportedDynamicState2Features.extendedDynamicState2)
+                {
+                    extendedDynamicState2Features.extendedDynamicState2 = VK_TRUE;
+                    extendedDynamicState2Features.pNext = const_cast<void*>(createInfo.pNext);
+                    createInfo.pNext = &extendedDynamicState2Features;
+                }
+            }
+        }
 
         if(enableValidationLayers)
         {
@@ -232,6 +377,48 @@ void VulkanBase::CreateLogicalDevice()
             throw std::runtime_error("failed to create logical device!");
 
         VulkanGlobals::s_Device = m_Device;
+
+        // Stays null when the extension is missing
+        if(isEnabled(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME))
+        {
+            VulkanGlobals::s_DrawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+                vkGetDeviceProcAddr(m_Device, "vkCmdDrawIndexedIndirectCountKHR"));
+        }
+
+        if(isEnabled(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME))
+        {
+            VulkanGlobals::s_CreateDescriptorUpdateTemplate = reinterpret_cast<PFN_vkCreateDescriptorUpdateTemplateKHR>(
+                vkGetDeviceProcAddr(m_Device, "vkCreateDescriptorUpdateTemplateKHR"));
+            VulkanGlobals::s_DestroyDescriptorUpdateTemplate =
+                reinterpret_cast<PFN_vkDestroyDescriptorUpdateTemplateKHR>(
+                    vkGetDeviceProcAddr(m_Device, "vkDestroyDescriptorUpdateTemplateKHR"));
+            VulkanGlobals::s_UpdateDescriptorSetWithTemplate =
+                reinterpret_cast<PFN_vkUpdateDescriptorSetWithTemplateKHR>(
+                    vkGetDeviceProcAddr(m_Device, "vkUpdateDescriptorSetWithTemplateKHR"));
+        }
+
+        if(extendedDynamicStateFeatures.extendedDynamicState)
+        {
+            auto getFunction = [this](const char* name) { return vkGetDeviceProcAddr(m_Device, name); };
+
+            VulkanGlobals::s_ExtendedDynamicState = {
+                .setCullMode = reinterpret_cast<PFN_vkCmdSetCullModeEXT>(getFunction("vkCmdSetCullModeEXT")),
+                .setFrontFace = reinterpret_cast<PFN_vkCmdSetFrontFaceEXT>(getFunction("vkCmdSetFrontFaceEXT")),
+                .setPrimitiveTopology =
+                    reinterpret_cast<PFN_vkCmdSetPrimitiveTopologyEXT>(getFunction("vkCmdSetPrimitiveTopologyEXT")),
+                .setDepthTestEnable =
+                    reinterpret_cast<PFN_vkCmdSetDepthTestEnableEXT>(getFunction("vkCmdSetDepthTestEnableEXT")),
+                .setDepthWriteEnable =
+                    reinterpret_cast<PFN_vkCmdSetDepthWriteEnableEXT>(getFunction("vkCmdSetDepthWriteEnableEXT")),
+                .setDepthCompareOp =
+                    reinterpret_cast<PFN_vkCmdSetDepthCompareOpEXT>(getFunction("vkCmdSetDepthCompareOpEXT")),
+            };
+
+            if(extendedDynamicState2Features.extendedDynamicState2)
+                VulkanGlobals::s_ExtendedDynamicState.setPrimitiveRestartEnable =
+                    reinterpret_cast<PFN_vkCmdSetPrimitiveRestartEnableEXT>(
+                        getFunction("vkCmdSetPrimitiveRestartEnableEXT"));
+        }
     }
 
     vkGetDeviceQueue(m_Device, queueFamilyIndices.graphicsFamily.value(), 0, &m_GraphicsQueue);
@@ -240,20 +427,38 @@ void VulkanBase::CreateLogicalDevice()
     vkGetDeviceQueue(m_Device, queueFamilyIndices.presentFamily.value(), 0, &m_PresentQueue);
 }
 
-void VulkanBase::CreateDepthResources()
+void VulkanBase::RecreateSwapChain()
+{
+    JUL_PROFILE_ZONE("RecreateSwapChain");
+
+    int width = 0, height = 0;
+    glfwGetFramebufferSize(m_window, &width, &height);
+    while(width == 0 || height == 0)
+    {
+        glfwGetFramebufferSize(m_window, &width, &height);
+        glfwWaitEvents();
+    }
+
+    m_NeedsWindowResize = false;
+
+    // No device idle, the old swap chain stays alive until every frame that could still use it is done
+    auto newSwapChainUPtr = std::make_unique<SwapChain>(m_Surface, glm::ivec2{ width, height }, *m_SwapChainUPtr);
+
+    const uint64_t destroyFrame = m_FrameCount + static_cast<uint64_t>(m_SwapChainUPtr->GetImageCount());
+    m_RetiredSwapChains.push_back({ destroyFrame, std::move(m_SwapChainUPtr) });
+
+    m_SwapChainUPtr = std::move(newSwapChainUPtr);
+    VulkanGlobals::s_SwapChainPtr = m_SwapChainUPtr.get();
+
+    m_SwapChainUPtr->CreateFrameBuffers(m_RenderPassUPtr.get());
+    m_GameUPtr->OnResize();
+}
+
+void VulkanBase::DestroyRetiredSwapChains()
 {
-    VkFormat depthFormat = vulkanUtil::FindDepthFormat();
-
-    vulkanUtil::CreateImage(VulkanGlobals::GetSwapChain().GetExtent().width,
-                            VulkanGlobals::GetSwapChain().GetExtent().height,
-                            depthFormat,
-                            VK_IMAGE_TILING_OPTIMAL,
-                            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                            m_DepthImage,
-                            m_DepthImageMemory);
-
-    m_DepthImageView = vulkanUtil::CreateImageView(m_DepthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+    std::erase_if(m_RetiredSwapChains,
+                  [this](const RetiredSwapChain& retiredSwapChain)
+                  { return retiredSwapChain.destroyFrame <= m_FrameCount; });
 }
 
 
@@ -360,85 +565,104 @@ void VulkanBase::CreateSyncObjects()
 
 void VulkanBase::DrawFrame()
 {
-    vkWaitForFences(m_Device, 1, &m_InFlightFence, VK_TRUE, UINT64_MAX);
-
     uint32_t imageIndex = 0;
-    vkAcquireNextImageKHR(
-        m_Device, *m_SwapChainUPtr, UINT64_MAX, m_ImageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
+    {
+        JUL_PROFILE_ZONE("Acquire");
+        vkWaitForFences(m_Device, 1, &m_InFlightFence, VK_TRUE, UINT64_MAX);
+        DestroyRetiredSwapChains();
 
+        const VkResult acquireResult = vkAcquireNextImageKHR(
+            m_Device, *m_SwapChainUPtr, UINT64_MAX, m_ImageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
 
-    vkResetFences(m_Device, 1, &m_InFlightFence);
+        // Fence is not reset yet so the next frame won't wait on it
+        if(acquireResult == VK_ERROR_OUT_OF_DATE_KHR)
+        {
+            RecreateSwapChain();
+            return;
+        }
 
+        if(acquireResult != VK_SUCCESS and acquireResult != VK_SUBOPTIMAL_KHR)
+            throw std::runtime_error("failed to acquire swap chain image!");
+    }
 
-    vkResetCommandBuffer(*m_CommandBufferUPtr, /*VkCommandBufferResetFlagBits*/ 0);
 
-    m_CommandBufferUPtr->BeginBuffer();
-    m_RenderPassUPtr->Begin(
-        m_SwapChainUPtr->GetFrameBuffer(imageIndex), m_SwapChainUPtr->GetExtent(), *m_CommandBufferUPtr);
-    m_GameUPtr->Draw(*m_CommandBufferUPtr, imageIndex);
-    m_RenderPassUPtr->End(*m_CommandBufferUPtr);
-    m_CommandBufferUPtr->EndBuffer();
+    vkResetFences(m_Device, 1, &m_InFlightFence);
 
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    // The fence wait covers every earlier submit, so the sets this image used last time are free
+    m_DescriptorAllocatorUPtr->ResetFrame(static_cast<int>(imageIndex));
 
-    VkSemaphore waitSemaphores[] = { m_ImageAvailableSemaphore };
-    VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = waitSemaphores;
-    submitInfo.pWaitDstStageMask = waitStages;
+    {
+        JUL_PROFILE_ZONE("Record");
+        vkResetCommandBuffer(*m_CommandBufferUPtr, /*VkCommandBufferResetFlagBits*/ 0);
 
-    submitInfo.commandBufferCount = 1;
-    VkCommandBuffer commandBuffer = *m_CommandBufferUPtr;
-    submitInfo.pCommandBuffers = &commandBuffer;
+        m_CommandBufferUPtr->BeginBuffer();
+        GpuProfiler::BeginFrame(*m_CommandBufferUPtr);
+        GpuProfiler::BeginZone(*m_CommandBufferUPtr, "Frame");
 
-    VkSemaphore signalSemaphores[] = { m_RenderFinishedSemaphore };
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = signalSemaphores;
+        m_GameUPtr->PrepareDraw(*m_CommandBufferUPtr, imageIndex);
 
-    if(vkQueueSubmit(m_GraphicsQueue, 1, &submitInfo, m_InFlightFence) != VK_SUCCESS)
-        throw std::runtime_error("failed to submit draw command buffer!");
+        m_RenderPassUPtr->Begin(
+            m_SwapChainUPtr->GetFrameBuffer(imageIndex), m_SwapChainUPtr->GetExtent(), *m_CommandBufferUPtr);
+        m_GameUPtr->Draw(*m_CommandBufferUPtr, imageIndex);
+        m_RenderPassUPtr->End(*m_CommandBufferUPtr);
 
-    VkPresentInfoKHR presentInfo{};
-    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        m_GameUPtr->CullOcclusion(*m_CommandBufferUPtr, imageIndex);
 
-    presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = signalSemaphores;
+        m_LateRenderPassUPtr->Begin(
+            m_SwapChainUPtr->GetFrameBuffer(imageIndex), m_SwapChainUPtr->GetExtent(), *m_CommandBufferUPtr);
+        m_GameUPtr->DrawLate(*m_CommandBufferUPtr, imageIndex);
+        m_LateRenderPassUPtr->End(*m_CommandBufferUPtr);
 
-    VkSwapchainKHR swapChains[] = { *m_SwapChainUPtr };
-    presentInfo.swapchainCount = 1;
-    presentInfo.pSwapchains = swapChains;
+        GpuProfiler::EndZone(*m_CommandBufferUPtr);
+        GpuProfiler::EndFrame();
+        m_CommandBufferUPtr->EndRecording();
+    }
 
-    presentInfo.pImageIndices = &imageIndex;
+    VkSemaphore signalSemaphores[] = { m_RenderFinishedSemaphore };
 
-    const VkResult presentResult = vkQueuePresentKHR(m_PresentQueue, &presentInfo);
-    if(m_NeedsWindowResize or presentResult == VK_ERROR_OUT_OF_DATE_KHR)
     {
-        int width = 0, height = 0;
-        glfwGetFramebufferSize(m_window, &width, &height);
-        while(width == 0 || height == 0)
-        {
-            glfwGetFramebufferSize(m_window, &width, &height);
-            glfwWaitEvents();
-        }
+        JUL_PROFILE_ZONE("Submit");
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
+        VkSemaphore waitSemaphores[] = { m_ImageAvailableSemaphore };
+        VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+        submitInfo.waitSemaphoreCount = 1;
+        submitInfo.pWaitSemaphores = waitSemaphores;
+        submitInfo.pWaitDstStageMask = waitStages;
 
-        m_NeedsWindowResize = false;
-        vkDeviceWaitIdle(VulkanGlobals::GetDevice());
+        submitInfo.commandBufferCount = 1;
+        VkCommandBuffer commandBuffer = *m_CommandBufferUPtr;
+        submitInfo.pCommandBuffers = &commandBuffer;
 
-        m_SwapChainUPtr.reset();
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = signalSemaphores;
 
+        if(vkQueueSubmit(m_GraphicsQueue, 1, &submitInfo, m_InFlightFence) != VK_SUCCESS)
+            throw std::runtime_error("failed to submit draw command buffer!");
 
-        glm::ivec2 windowSize{};
-        glfwGetFramebufferSize(m_window, &windowSize.x, &windowSize.y);
-        m_SwapChainUPtr = std::make_unique<SwapChain>(m_Surface, windowSize);
-        VulkanGlobals::s_SwapChainPtr = m_SwapChainUPtr.get();
+        ++m_FrameCount;
+    }
 
-        m_GameUPtr->OnResize();
+    VkResult presentResult{};
+    {
+        JUL_PROFILE_ZONE("Present");
+        VkPresentInfoKHR presentInfo{};
+        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
-        m_SwapChainUPtr->CreateFrameBuffers(m_RenderPassUPtr.get(), m_DepthImageView);
-        return;
+        presentInfo.waitSemaphoreCount = 1;
+        presentInfo.pWaitSemaphores = signalSemaphores;
+
+        VkSwapchainKHR swapChains[] = { *m_SwapChainUPtr };
+        presentInfo.swapchainCount = 1;
+        presentInfo.pSwapchains = swapChains;
+
+        presentInfo.pImageIndices = &imageIndex;
+
+        presentResult = vkQueuePresentKHR(m_PresentQueue, &presentInfo);
     }
+    if(m_NeedsWindowResize or presentResult == VK_ERROR_OUT_OF_DATE_KHR or presentResult == VK_SUBOPTIMAL_KHR)
+        RecreateSwapChain();
 }
 
 bool checkValidationLayerSupport()
@@ -480,6 +704,21 @@ std::vector<const char*> VulkanBase::GetRequiredExtensions()
     if(enableValidationLayers)
         extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 
+    uint32_t availableCount{};
+    vkEnumerateInstanceExtensionProperties(nullptr, &availableCount, nullptr);
+
+    std::vector<VkExtensionProperties> availableExtensions(availableCount);
+    vkEnumerateInstanceExtensionProperties(nullptr, &availableCount, availableExtensions.data());
+
+    // Needed to query the descriptor indexing features on a 1.0 instance
+    if(std::ranges::any_of(availableExtensions,
+                           [](const VkExtensionProperties& extension)
+                           {
+                               return std::strcmp(extension.extensionName,
+                                                  VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) == 0;
+                           }))
+        extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+
     return extensions;
 }
 
@@ -16,13 +16,23 @@
 #include <vector>
 
 #include "jul/CommandBuffer.h"
+#include "jul/DescriptorAllocator.h"
 #include "jul/Game.h"
+#include "jul/PipelineStateCache.h"
 #include "jul/RenderPass.h"
 #include "jul/SwapChain.h"
 
 const std::array<const char*, 1> VALIDATION_LAYERS = { "VK_LAYER_KHRONOS_validation" };
 const std::array<const char*, 1> DEVICE_EXTENSIONS = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
 
+// Enabled when the device has them, features built on them check VulkanGlobals before use
+const std::array<const char*, 6> OPTIONAL_DEVICE_EXTENSIONS = { VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME,
+                                                                VK_KHR_MAINTENANCE3_EXTENSION_NAME,
+                                                                VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,
+                                                                VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME,
+                                                                VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME,
+                                                                VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME };
+
 class VulkanBase
 {
 
@@ -43,6 +53,9 @@ private:
     void DrawFrame();
     void Cleanup();
 
+    void RecreateSwapChain();
+    void DestroyRetiredSwapChains();
+
     void CreateSyncObjects();
     void PopulateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
     void SetupDebugMessenger();
@@ -55,10 +68,24 @@ private:
     bool m_NeedsWindowResize{ false };
 
     std::unique_ptr<Game> m_GameUPtr{};
+    std::unique_ptr<DescriptorAllocator> m_DescriptorAllocatorUPtr{};
+    std::unique_ptr<PipelineStateCache> m_PipelineStateCacheUPtr{};
     std::unique_ptr<CommandBuffer> m_CommandBufferUPtr{};
     std::unique_ptr<RenderPass> m_RenderPassUPtr{};
+    // Continues on the attachments after occlusion culling and presents
+    std::unique_ptr<RenderPass> m_LateRenderPassUPtr{};
     std::unique_ptr<SwapChain> m_SwapChainUPtr{};
 
+    struct RetiredSwapChain
+    {
+        uint64_t destroyFrame;
+        std::unique_ptr<SwapChain> swapChainUPtr;
+    };
+
+    // Swap chains replaced on resize, kept alive until the frames that used them are done
+    std::vector<RetiredSwapChain> m_RetiredSwapChains{};
+    uint64_t m_FrameCount{};
+
 
     void CreateLogicalDevice();
     VkQueue m_GraphicsQueue;
@@ -73,9 +100,4 @@ private:
     VkFence m_InFlightFence;
     VkSemaphore m_ImageAvailableSemaphore;
     VkSemaphore m_RenderFinishedSemaphore;
-
-    VkImage m_DepthImage;
-    VkDeviceMemory m_DepthImageMemory;
-    VkImageView m_DepthImageView;
-    void CreateDepthResources();
 };
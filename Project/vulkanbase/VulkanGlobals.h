@@ -4,6 +4,21 @@
 
 class SwapChain;
 class RenderPass;
+class DescriptorAllocator;
+class PipelineStateCache;
+
+// Entry points of VK_EXT_extended_dynamic_state, all null when it is not enabled
+// setPrimitiveRestartEnable comes from VK_EXT_extended_dynamic_state2 and can be null on its own
+struct ExtendedDynamicStateFunctions
+{
+    PFN_vkCmdSetCullModeEXT setCullMode;
+    PFN_vkCmdSetFrontFaceEXT setFrontFace;
+    PFN_vkCmdSetPrimitiveTopologyEXT setPrimitiveTopology;
+    PFN_vkCmdSetDepthTestEnableEXT setDepthTestEnable;
+    PFN_vkCmdSetDepthWriteEnableEXT setDepthWriteEnable;
+    PFN_vkCmdSetDepthCompareOpEXT setDepthCompareOp;
+    PFN_vkCmdSetPrimitiveRestartEnableEXT setPrimitiveRestartEnable;
+};
 
 class VulkanGlobals
 {
@@ -19,10 +34,57 @@ public:
 
     [[nodiscard]] static inline RenderPass& GetRederPass() { return *s_RenderPassPtr; }
 
+    [[nodiscard]] static inline DescriptorAllocator& GetDescriptorAllocator() { return *s_DescriptorAllocatorPtr; }
+
+    [[nodiscard]] static inline PipelineStateCache& GetPipelineStateCache() { return *s_PipelineStateCachePtr; }
+
     [[nodiscard]] static inline VkQueue GetGraphicsQueue() { return s_GraphicsQueue; }
 
     [[nodiscard]] static inline VkSurfaceKHR GetSurface() { return s_Surface; }
 
+    // Optional features are only enabled when the device supports them
+    [[nodiscard]] static inline const VkPhysicalDeviceFeatures& GetEnabledFeatures() { return s_EnabledFeatures; }
+
+    // Null when VK_KHR_draw_indirect_count is not supported
+    [[nodiscard]] static inline PFN_vkCmdDrawIndexedIndirectCountKHR GetDrawIndexedIndirectCount()
+    {
+        return s_DrawIndexedIndirectCount;
+    }
+
+    // True when VK_EXT_descriptor_indexing is enabled with partial binding and update after bind for samplers
+    [[nodiscard]] static inline bool IsDescriptorIndexingEnabled() { return s_DescriptorIndexing; }
+
+    // All null when VK_KHR_descriptor_update_template is not supported
+    [[nodiscard]] static inline PFN_vkCreateDescriptorUpdateTemplateKHR GetCreateDescriptorUpdateTemplate()
+    {
+        return s_CreateDescriptorUpdateTemplate;
+    }
+
+    [[nodiscard]] static inline PFN_vkDestroyDescriptorUpdateTemplateKHR GetDestroyDescriptorUpdateTemplate()
+    {
+        return s_DestroyDescriptorUpdateTemplate;
+    }
+
+    [[nodiscard]] static inline PFN_vkUpdateDescriptorSetWithTemplateKHR GetUpdateDescriptorSetWithTemplate()
+    {
+        return s_UpdateDescriptorSetWithTemplate;
+    }
+
+    [[nodiscard]] static inline const ExtendedDynamicStateFunctions& GetExtendedDynamicState()
+    {
+        return s_ExtendedDynamicState;
+    }
+
+    [[nodiscard]] static inline bool IsExtendedDynamicStateEnabled()
+    {
+        return s_ExtendedDynamicState.setCullMode != nullptr;
+    }
+
+    [[nodiscard]] static inline bool IsExtendedDynamicState2Enabled()
+    {
+        return s_ExtendedDynamicState.setPrimitiveRestartEnable != nullptr;
+    }
+
 
 private:
     static inline VkDevice s_Device{};
@@ -30,5 +92,14 @@ private:
     static inline VkQueue s_GraphicsQueue{};
     static inline SwapChain* s_SwapChainPtr{};
     static inline RenderPass* s_RenderPassPtr{};
+    static inline DescriptorAllocator* s_DescriptorAllocatorPtr{};
+    static inline PipelineStateCache* s_PipelineStateCachePtr{};
     static inline VkSurfaceKHR s_Surface{};
+    static inline VkPhysicalDeviceFeatures s_EnabledFeatures{};
+    static inline PFN_vkCmdDrawIndexedIndirectCountKHR s_DrawIndexedIndirectCount{};
+    static inline bool s_DescriptorIndexing{};
+    static inline PFN_vkCreateDescriptorUpdateTemplateKHR s_CreateDescriptorUpdateTemplate{};
+    static inline PFN_vkDestroyDescriptorUpdateTemplateKHR s_DestroyDescriptorUpdateTemplate{};
+    static inline PFN_vkUpdateDescriptorSetWithTemplateKHR s_UpdateDescriptorSetWithTemplate{};
+    static inline ExtendedDynamicStateFunctions s_ExtendedDynamicState{};
 };
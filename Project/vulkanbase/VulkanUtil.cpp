@@ -75,11 +75,12 @@ vulkanUtil::QueueFamilyIndices vulkanUtil::FindQueueFamilies(VkPhysicalDevice de
     return indices;
 }
 
-void vulkanUtil::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
+void vulkanUtil::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset,
+                            VkDeviceSize dstOffset)
 {
     CommandBuffer commandBuffer{ VulkanGlobals::GetDevice() };
 
-    const VkBufferCopy copyRegion{ .size = size };
+    const VkBufferCopy copyRegion{ .srcOffset = srcOffset, .dstOffset = dstOffset, .size = size };
 
     commandBuffer.BeginBuffer();
     {
@@ -154,14 +155,14 @@ bool vulkanUtil::FasDepthComponent(VkFormat format)
 
 void vulkanUtil::CreateImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling,
                              VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image,
-                             VkDeviceMemory& imageMemory)
+                             VkDeviceMemory& imageMemory, uint32_t mipLevels)
 {
     const VkImageCreateInfo imageInfo{
         .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
         .imageType = VK_IMAGE_TYPE_2D,
         .format = format,
         .extent = { .width = width, .height = height, .depth = 1, },
-        .mipLevels = 1,
+        .mipLevels = mipLevels,
         .arrayLayers = 1,
         .samples = VK_SAMPLE_COUNT_1_BIT,
         .tiling = tiling,
@@ -188,16 +189,18 @@ void vulkanUtil::CreateImage(uint32_t width, uint32_t height, VkFormat format, V
     vkBindImageMemory(VulkanGlobals::GetDevice(), image, imageMemory, 0);
 }
 
-VkImageView vulkanUtil::CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags)
+VkImageView vulkanUtil::CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags,
+                                        uint32_t mipLevels, VkComponentMapping components)
 {
     const  VkImageViewCreateInfo  viewInfo{ .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
         .image = image,
         .viewType = VK_IMAGE_VIEW_TYPE_2D,
         .format = format,
+        .components = components,
         .subresourceRange = {
                              .aspectMask = aspectFlags,
  .baseMipLevel = 0,
- .levelCount = 1,
+ .levelCount = mipLevels,
  .baseArrayLayer = 0,
  .layerCount = 1,
         } };
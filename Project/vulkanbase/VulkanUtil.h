@@ -50,7 +50,8 @@ namespace vulkanUtil
 
     QueueFamilyIndices FindQueueFamilies(VkPhysicalDevice device);
 
-    void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+    void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset = 0,
+                    VkDeviceSize dstOffset = 0);
 
 
     VkFormat FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling,
@@ -66,7 +67,10 @@ namespace vulkanUtil
 
     bool FasDepthComponent(VkFormat format);
     void CreateImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
-                     VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
+                     VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory,
+                     uint32_t mipLevels = 1);
 
-    VkImageView CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
+    // The view covers every mip level, components can spread fewer channels over RGBA
+    VkImageView CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags,
+                                uint32_t mipLevels = 1, VkComponentMapping components = {});
 }  // namespace vulkanUtil